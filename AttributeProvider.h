@@ -21,6 +21,8 @@ namespace Util {
  * Mixin class to provide a GenericAttributeMap including access functions for classes inheriting it.
  * The map itself is created when the first attribute is added;
  * so that the minimal memory overhead is of the size of a single pointer.
+ * Copies of an AttributeProvider share the attributes until one of them is
+ * modified (see GenericAttributeMap::cloneShared()).
  * @ingroup generic_attr
  */
 class AttributeProvider {
@@ -48,15 +50,28 @@ class AttributeProvider {
 
 		void copyAttributesFrom(const AttributeProvider & other) {
 			if (other.hasAttributes())
-				_attributes.reset(other.getAttributes()->clone());
+				_attributes.reset(other.getAttributes()->cloneShared());
 		}
 
-		GenericAttribute * getAttribute(const StringIdentifier & key) const {
+		//! Return the attribute for reading; attributes shared with copies stay shared.
+		const GenericAttribute * getAttribute(const StringIdentifier & key) const {
+			return _attributes ? _attributes->findValue(key) : nullptr;
+		}
+		template<class AttrType>
+		const AttrType * getAttribute(const StringIdentifier & key) const {
+			return _attributes ? _attributes->findValue<AttrType>(key) : nullptr;
+		}
+		/**
+		 * Return the attribute for modifying it in place. If the attributes
+		 * are shared with a copy of this object, they are copied first (see
+		 * GenericAttributeMap::getValue()).
+		 */
+		GenericAttribute * getMutableAttribute(const StringIdentifier & key) {
 			return _attributes ? _attributes->getValue(key) : nullptr;
 		}
 		template<class AttrType>
-		AttrType * getAttribute(const StringIdentifier & key) const {
-			return _attributes ? dynamic_cast<AttrType*>(_attributes->getValue(key)) : nullptr;
+		AttrType * getMutableAttribute(const StringIdentifier & key) {
+			return _attributes ? _attributes->getValue<AttrType>(key) : nullptr;
 		}
 		GenericAttributeMap * getAttributes() const {
 			return _attributes.get();
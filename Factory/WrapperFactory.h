@@ -32,6 +32,7 @@ namespace Util {
  * @tparam IdentifierType Type of the identifier that specifies which object creator to call
  * @tparam ObjectCreator Type for callable entities that take an object of type @a InternalType, and generate an object of type @a WrapperType
  * @tparam FallbackPolicy Template with a function @a onUnknownType() that handles the case that the requested object type was not found
+ * @tparam RegistrationContainer Associative container mapping identifiers to object creators (e.g. std::unordered_map for constant-time lookups)
  * @author Benjamin Eikel
  * @date 2012-01-31
  * @see Patterns from Chapter 8 in Andrei Alexandrescu: Modern C++ Design. Addison-Wesley, 2001.
@@ -40,10 +41,11 @@ template < class InternalType,
 		 class WrapperType,
 		 typename IdentifierType,
 		 typename ObjectCreator = std::function<WrapperType (const InternalType &)>,
-		 template<class, typename> class FallbackPolicy = FallbackPolicies::ExceptionFallback >
+		 template<class, typename> class FallbackPolicy = FallbackPolicies::ExceptionFallback,
+		 class RegistrationContainer = std::map<IdentifierType, ObjectCreator> >
 class WrapperFactory {
 	private:
-		typedef std::map<IdentifierType, ObjectCreator> registrations_t;
+		typedef RegistrationContainer registrations_t;
 		registrations_t registrations;
 	public:
 		typedef FallbackPolicy<WrapperType, IdentifierType> fallbackPolicy_t;
@@ -45,6 +45,7 @@ class Generic {
 			virtual ~AbstractStorage() {
 			}
 			virtual AbstractStorage * clone() const = 0;
+			virtual const std::type_info & getType() const = 0;
 		};
 		template<typename type_t>
 		struct Storage : public AbstractStorage {
@@ -66,6 +67,9 @@ class Generic {
 			Storage * clone() const override {
 				return new Storage(*this);
 			}
+			const std::type_info & getType() const override {
+				return typeid(type_t);
+			}
 		};
 
 		std::unique_ptr<AbstractStorage> content;
@@ -105,6 +109,15 @@ class Generic {
 			return content.operator bool();
 		}
 
+		/**
+		 * Return the type of the stored data, or @c typeid(void) if no data is
+		 * stored. This allows to dispatch on the type with a single call
+		 * instead of testing the possible types with get().
+		 */
+		const std::type_info & getType() const {
+			return content ? content->getType() : typeid(void);
+		}
+
 		//! Check if the stored data is of the given type
 		template<typename type_t>
 		bool contains() const {
@@ -9,13 +9,33 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "GenericAttribute.h"
+#include "GenericAttributeArena.h"
+#include <algorithm>
+#include <ostream>
 #include <sstream>
+#include <typeinfo>
 #include <utility>
 
 namespace Util {
 
 // ----------------------------------
 
+void * GenericAttribute::operator new(std::size_t size) {
+	return GenericAttributeArena::allocate(size);
+}
+
+void GenericAttribute::operator delete(void * ptr) {
+	GenericAttributeArena::deallocate(ptr);
+}
+
+GenericAttribute::~GenericAttribute() {
+	GenericAttributeArena::setDestroyedInArena(inArena);
+}
+
+bool GenericAttribute::isArenaAllocation(const GenericAttribute * attribute) {
+	return GenericAttributeArena::takeArenaAllocation(attribute);
+}
+
 /**
  * [static] Factory
  */
@@ -30,75 +50,441 @@ BoolAttribute * GenericAttribute::createBool(bool b){
 	return new BoolAttribute(b);
 }
 
+/**
+ * (internal) Write the JSON representation of an attribute tree to a stream
+ * in blocks of bounded size. Maps and lists are written element by element;
+ * all other attributes, including classes derived from maps and lists, are
+ * written by appendJSON().
+ */
+class JSONStreamWriter {
+	private:
+		static const std::size_t FLUSH_SIZE = 64 * 1024;
+
+		std::ostream & out;
+		std::string buffer;
+
+		void flushIfFull() {
+			if(buffer.size() >= FLUSH_SIZE) {
+				flush();
+			}
+		}
+
+		void writeSlot(const GenericAttributeSlot & slot) {
+			if(slot.isInline()) {
+				slot.appendJSON(buffer);
+			} else {
+				write(*slot.get());
+			}
+		}
+
+	public:
+		explicit JSONStreamWriter(std::ostream & _out) : out(_out), buffer() {
+			buffer.reserve(FLUSH_SIZE + 1024);
+		}
+
+		void flush() {
+			out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			buffer.clear();
+		}
+
+		void write(const GenericAttribute & attribute) {
+			const std::type_info & type = typeid(attribute);
+			if(type == typeid(GenericAttributeMap)) {
+				buffer += '{';
+				bool first = true;
+				for(const auto & element : static_cast<const GenericAttributeMap &>(attribute).getElements()) {
+					if(element.second) {
+						if(first) {
+							first = false;
+						} else {
+							buffer += ',';
+						}
+						const StringView key = element.first.toStringView();
+						buffer += '"';
+						StringUtils::appendEscaped(buffer, key.data(), key.size());
+						buffer += "\":";
+						writeSlot(element.second);
+					}
+				}
+				buffer += '}';
+			} else if(type == typeid(GenericAttributeList)) {
+				buffer += '[';
+				bool first = true;
+				for(const auto & element : static_cast<const GenericAttributeList &>(attribute).getElements()) {
+					if(element) {
+						if(first) {
+							first = false;
+						} else {
+							buffer += ',';
+						}
+						writeSlot(element);
+					}
+				}
+				buffer += ']';
+			} else {
+				attribute.appendJSON(buffer);
+			}
+			flushIfFull();
+		}
+};
+
+void GenericAttribute::writeJSON(std::ostream & out) const {
+	JSONStreamWriter writer(out);
+	writer.write(*this);
+	writer.flush();
+}
+
+uint64_t _Internals::hashBytes(const char * data, std::size_t size) {
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for(std::size_t i = 0; i < size; ++i) {
+		hash = (hash ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ull;
+	}
+	return mixHash(hash ^ size);
+}
+
+uint64_t GenericAttribute::getStructuralHash() const {
+	const std::string str = toString();
+	return _Internals::combineHash(static_cast<uint64_t>(getKind()), _Internals::hashBytes(str.data(), str.size()));
+}
+
+// ------------------------------------------------------------------------
+
+const std::size_t GenericAttributeSlot::MAX_INLINE_STRING_LENGTH;
+
+GenericAttribute * GenericAttributeSlot::materialize() const {
+	// The slot may belong to a tree outside of the active arena.
+	GenericAttributeArena::HeapScope heapScope;
+	GenericAttribute * created;
+	switch(inlineKind) {
+		case GenericAttributeKind::BOOL:
+			created = new BoolAttribute(value.boolValue);
+			break;
+		case GenericAttributeKind::NUMBER_INT:
+			created = new _NumberAttribute<int>(value.intValue);
+			break;
+		case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+			created = new _NumberAttribute<unsigned int>(value.unsignedIntValue);
+			break;
+		case GenericAttributeKind::NUMBER_FLOAT:
+			created = new _NumberAttribute<float>(value.floatValue);
+			break;
+		case GenericAttributeKind::NUMBER_DOUBLE:
+			created = new _NumberAttribute<double>(value.doubleValue);
+			break;
+		default:
+			created = new StringAttribute(getInlineString());
+			break;
+	}
+	// Another thread may have converted the value in the meantime.
+	GenericAttribute * expected = nullptr;
+	if(!attribute.compare_exchange_strong(expected, created, std::memory_order_acq_rel, std::memory_order_acquire)) {
+		delete created;
+		return expected;
+	}
+	return created;
+}
+
+GenericAttributeSlot GenericAttributeSlot::clone() const {
+	if(isInline()) {
+		GenericAttributeSlot slotClone;
+		slotClone.value = value;
+		slotClone.inlineKind = inlineKind;
+		slotClone.stringLength = stringLength;
+		return slotClone;
+	}
+	const GenericAttribute * attr = attribute.load(std::memory_order_acquire);
+	return GenericAttributeSlot(attr == nullptr ? nullptr : attr->clone());
+}
+
+//! Compare an inline value with the value of an attribute of the same kind.
+static bool isInlineValueEqual(const GenericAttributeSlot & slot, const GenericAttribute & attr) {
+	switch(slot.getKind()) {
+		case GenericAttributeKind::BOOL:
+			return static_cast<const BoolAttribute &>(attr).get() == slot.getInlineBool();
+		case GenericAttributeKind::NUMBER_INT:
+			return static_cast<const _NumberAttribute<int> &>(attr).get() == slot.getInlineInt();
+		case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+			return static_cast<const _NumberAttribute<unsigned int> &>(attr).get() == slot.getInlineUnsignedInt();
+		case GenericAttributeKind::NUMBER_FLOAT:
+			return static_cast<const _NumberAttribute<float> &>(attr).get() == slot.getInlineFloat();
+		case GenericAttributeKind::NUMBER_DOUBLE:
+			return static_cast<const _NumberAttribute<double> &>(attr).get() == slot.getInlineDouble();
+		default:
+			return static_cast<const StringAttribute &>(attr).get() == slot.getInlineString();
+	}
+}
+
+bool GenericAttributeSlot::isEqual(const GenericAttributeSlot & other) const {
+	const bool thisInline = isInline();
+	const bool otherInline = other.isInline();
+	if(!thisInline && !otherInline) {
+		return *get() == *other.get();
+	}
+	// Attributes of different types are never equal.
+	if(getKind() != other.getKind()) {
+		return false;
+	}
+	if(thisInline && otherInline) {
+		switch(inlineKind) {
+			case GenericAttributeKind::BOOL:
+				return value.boolValue == other.value.boolValue;
+			case GenericAttributeKind::NUMBER_INT:
+				return value.intValue == other.value.intValue;
+			case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+				return value.unsignedIntValue == other.value.unsignedIntValue;
+			case GenericAttributeKind::NUMBER_FLOAT:
+				return value.floatValue == other.value.floatValue;
+			case GenericAttributeKind::NUMBER_DOUBLE:
+				return value.doubleValue == other.value.doubleValue;
+			default:
+				return stringLength == other.stringLength && std::equal(value.stringValue, value.stringValue + stringLength, other.value.stringValue);
+		}
+	}
+	return thisInline ? isInlineValueEqual(*this, *other.get()) : isInlineValueEqual(other, *get());
+}
+
+uint64_t GenericAttributeSlot::getStructuralHash() const {
+	const GenericAttribute * attr = attribute.load(std::memory_order_acquire);
+	if(attr != nullptr) {
+		return attr->getStructuralHash();
+	}
+	// Same values as the corresponding attributes
+	uint64_t valueHash;
+	switch(inlineKind) {
+		case GenericAttributeKind::BOOL:
+			valueHash = _Internals::hashNumber(value.boolValue ? 1 : 0);
+			break;
+		case GenericAttributeKind::NUMBER_INT:
+			valueHash = _Internals::hashNumber(value.intValue);
+			break;
+		case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+			valueHash = _Internals::hashNumber(value.unsignedIntValue);
+			break;
+		case GenericAttributeKind::NUMBER_FLOAT:
+			valueHash = _Internals::hashNumber(value.floatValue);
+			break;
+		case GenericAttributeKind::NUMBER_DOUBLE:
+			valueHash = _Internals::hashNumber(value.doubleValue);
+			break;
+		default:
+			valueHash = _Internals::hashBytes(value.stringValue, stringLength);
+			break;
+	}
+	return _Internals::combineHash(static_cast<uint64_t>(inlineKind), valueHash);
+}
+
+void GenericAttributeSlot::appendJSON(std::string & out) const {
+	const GenericAttribute * attr = attribute.load(std::memory_order_acquire);
+	if(attr != nullptr) {
+		attr->appendJSON(out);
+		return;
+	}
+	switch(inlineKind) {
+		case GenericAttributeKind::BOOL:
+			out += value.boolValue ? "true" : "false";
+			break;
+		case GenericAttributeKind::NUMBER_INT:
+			out += StringUtils::toString(value.intValue);
+			break;
+		case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+			out += StringUtils::toString(value.unsignedIntValue);
+			break;
+		case GenericAttributeKind::NUMBER_FLOAT:
+			out += StringUtils::toString(value.floatValue);
+			break;
+		case GenericAttributeKind::NUMBER_DOUBLE:
+			out += StringUtils::toString(value.doubleValue);
+			break;
+		default:
+			out += '"';
+			StringUtils::appendEscaped(out, value.stringValue, stringLength);
+			out += '"';
+			break;
+	}
+}
+
 // ------------------------------------------------------------------------
 
-GenericAttributeMap::GenericAttributeMap() : m() {
+const std::size_t GenericAttributeMap::INDEX_THRESHOLD;
+
+GenericAttributeMap::GenericAttributeMap() : GenericAttribute(GenericAttributeKind::MAP), data() {
 }
 
 GenericAttributeMap::~GenericAttributeMap() = default;
 
+const std::vector<GenericAttributeMap::value_type> & GenericAttributeMap::getNoElements() {
+	static const std::vector<value_type> noElements;
+	return noElements;
+}
+
+//! Copy a slot; maps (but not derived types) are shared instead of copied.
+static GenericAttributeSlot cloneSharingMaps(const GenericAttributeSlot & slot) {
+	if(slot.getKind() == GenericAttributeKind::MAP && typeid(*slot.get()) == typeid(GenericAttributeMap)) {
+		return GenericAttributeSlot(static_cast<const GenericAttributeMap *>(slot.get())->cloneShared());
+	}
+	return slot.clone();
+}
+
+void GenericAttributeMap::copyData() {
+	// The map may be outside of the active arena.
+	GenericAttributeArena::HeapScope heapScope;
+	std::shared_ptr<Data> copy = std::make_shared<Data>();
+	copy->elements.reserve(data->elements.size());
+	for(const auto & element : data->elements) {
+		copy->elements.emplace_back(element.first, element.second ? cloneSharingMaps(element.second) : GenericAttributeSlot());
+	}
+	if(data->index) {
+		copy->index.reset(new std::unordered_map<StringIdentifier, std::size_t>(*data->index));
+	}
+	copy->hash = data->hash;
+	data = std::move(copy);
+}
+
 GenericAttributeMap * GenericAttributeMap::clone() const {
 	auto mapClone = new GenericAttributeMap;
-	for(const auto & element : m) {
+	const auto & elements = getElements();
+	mapClone->reserve(elements.size());
+	for(const auto & element : elements) {
 		if(element.second) {
-			mapClone->setValue(element.first, element.second->clone());
+			mapClone->setValue(element.first, element.second.clone());
 		}
 	}
 	return mapClone;
 }
 
-void GenericAttributeMap::setValue(const StringIdentifier & key, GenericAttribute * attr) {
-	m[key].reset(attr);
+GenericAttributeMap * GenericAttributeMap::cloneShared() const {
+	auto mapClone = new GenericAttributeMap;
+	mapClone->data = data;
+	return mapClone;
+}
+
+std::size_t GenericAttributeMap::findPosition(const StringIdentifier & key) const {
+	const auto & elements = getElements();
+	if(data && data->index) {
+		const auto it = data->index->find(key);
+		return it == data->index->end() ? elements.size() : it->second;
+	}
+	std::size_t position = 0;
+	for(const auto & element : elements) {
+		if(element.first == key) {
+			break;
+		}
+		++position;
+	}
+	return position;
+}
+
+void GenericAttributeMap::setValue(const StringIdentifier & key, GenericAttributeSlot && slot) {
+	const std::size_t position = findPosition(key);
+	Data & d = getMutableData();
+	auto & m = d.elements;
+	if(position != m.size()) {
+		m[position].second = std::move(slot);
+		return;
+	}
+	m.emplace_back(key, std::move(slot));
+	if(d.index) {
+		d.index->emplace(key, position);
+	} else if(m.size() > INDEX_THRESHOLD) {
+		d.index.reset(new std::unordered_map<StringIdentifier, std::size_t>);
+		d.index->reserve(m.size());
+		for(std::size_t i = 0; i < m.size(); ++i) {
+			d.index->emplace(m[i].first, i);
+		}
+	}
 }
 
 bool GenericAttributeMap::unsetValue(const StringIdentifier & key) {
-	return m.erase(key) > 0;
+	const std::size_t position = findPosition(key);
+	if(position == size()) {
+		return false;
+	}
+	Data & d = getMutableData();
+	auto & m = d.elements;
+	if(d.index) {
+		d.index->erase(key);
+	}
+	// Fill the gap with the last element.
+	if(position != m.size() - 1) {
+		m[position] = std::move(m.back());
+		if(d.index) {
+			(*d.index)[m[position].first] = position;
+		}
+	}
+	m.pop_back();
+	return true;
 }
 
 
 void GenericAttributeMap::setString(const StringIdentifier & key, const std::string & value) {
-	setValue(key, GenericAttribute::createString(value));
+	setValue(key, GenericAttributeSlot::createString(value));
 }
 
-GenericAttribute * GenericAttributeMap::getValue(const StringIdentifier & key) const {
-	auto it = m.find(key);
-	if(it == m.end()) {
+GenericAttribute * GenericAttributeMap::getValue(const StringIdentifier & key) {
+	const std::size_t position = findPosition(key);
+	if(position == size()) {
 		return nullptr;
 	}
-	return it->second.get();
+	prepareModification();
+	return data->elements[position].second.get();
 }
 
 bool GenericAttributeMap::contains(const StringIdentifier & stringId) const {
-	return m.count(stringId) != 0;
+	return findPosition(stringId) != size();
 }
 
 std::string GenericAttributeMap::getString(const StringIdentifier & key, const std::string & defaultValue) const {
-	GenericAttribute * attr = getValue(key);
-	return attr ? attr->toString() : defaultValue;
+	const GenericAttributeSlot * slot = findSlot(key);
+	return slot ? slot->toString() : defaultValue;
+}
+
+uint64_t GenericAttributeMap::getStructuralHash() const {
+	const uint64_t cachedHash = data ? data->hash.get() : 0;
+	if(cachedHash != 0) {
+		return cachedHash;
+	}
+	// The order of the elements is unspecified; the sum does not depend on it.
+	uint64_t sum = 0;
+	const auto & elements = getElements();
+	for(const auto & element : elements) {
+		const uint64_t valueHash = element.second ? element.second.getStructuralHash() : 0;
+		sum += _Internals::combineHash(element.first.getValue(), valueHash);
+	}
+	const uint64_t hash = _Internals::combineHash(static_cast<uint64_t>(getKind()), _Internals::combineHash(elements.size(), sum));
+	return data ? data->hash.set(hash) : hash;
 }
 
 std::string GenericAttributeMap::toJSON() const {
-	std::ostringstream s;
-	s << "{";
+	std::string json;
+	appendJSON(json);
+	return json;
+}
+
+void GenericAttributeMap::appendJSON(std::string & out) const {
+	out += '{';
 	bool first = true;
-	for(const auto & element : m) {
+	for(const auto & element : getElements()) {
 		if(element.second) {
 			if(first) {
 				first = false;
 			} else {
-				s << ",";
+				out += ',';
 			}
-			s << "\"" << element.first.toString() << "\":" << element.second->toJSON();
+			const StringView key = element.first.toStringView();
+			out += '"';
+			StringUtils::appendEscaped(out, key.data(), key.size());
+			out += "\":";
+			element.second.appendJSON(out);
 		}
 	}
-	s << "}";
-	return s.str();
+	out += '}';
 }
 
 std::string GenericAttributeMap::toString() const {
 	std::ostringstream s;
 	s << "Map {\n";
-	for(const auto & element : m) {
+	for(const auto & element : getElements()) {
 		if(element.second) {
 			s << "\t\"" << element.first.toString() << "\" : "
 			  << StringUtils::replaceAll(StringUtils::trim(element.second->toString()), "\n", "\n\t") << "\n";
@@ -115,15 +501,21 @@ bool GenericAttributeMap::operator==(const GenericAttribute & other)const{
 		return false;
 	if(size()!=otherMap->size())
 		return false;
-	for(const auto & element : m) {
+	if(data == otherMap->data)
+		return true;
+	const auto & otherElements = otherMap->getElements();
+	for(const auto & element : getElements()) {
 		const auto & key = element.first;
 		const auto & value = element.second;
-		const auto & otherValue = otherMap->getValue(key);
+		const std::size_t otherPosition = otherMap->findPosition(key);
+		if(otherPosition == otherElements.size())
+			return false;
+		const auto & otherValue = otherElements[otherPosition].second;
 		
-		if(value==nullptr && otherValue==nullptr && otherMap->contains(key))
+		if(value==nullptr && otherValue==nullptr)
 			continue;
 		
-		if(otherValue==nullptr || (*value != *otherValue))
+		if(value==nullptr || otherValue==nullptr || !value.isEqual(otherValue))
 			return false;
 	}
 	return true;
@@ -131,36 +523,53 @@ bool GenericAttributeMap::operator==(const GenericAttribute & other)const{
 
 // ------------------------------------------------------------------------------
 
-GenericAttributeList::GenericAttributeList() : l() {
+GenericAttributeList::GenericAttributeList() : GenericAttribute(GenericAttributeKind::LIST), l() {
 }
 
 GenericAttributeList::~GenericAttributeList() = default;
 
 GenericAttributeList * GenericAttributeList::clone() const {
 	auto listClone = new GenericAttributeList;
+	listClone->reserve(l.size());
 	for(const auto & element : l) {
 		if(element) {
-			listClone->push_back(element->clone());
+			listClone->l.emplace_back(element.clone());
 		}
 	}
 	return listClone;
 }
 
+uint64_t GenericAttributeList::getStructuralHash() const {
+	const uint64_t cachedHash = hash.get();
+	if(cachedHash != 0) {
+		return cachedHash;
+	}
+	uint64_t listHash = _Internals::combineHash(static_cast<uint64_t>(getKind()), l.size());
+	for(const auto & element : l) {
+		listHash = _Internals::combineHash(listHash, element ? element.getStructuralHash() : 0);
+	}
+	return hash.set(listHash);
+}
+
 std::string GenericAttributeList::toJSON() const {
-	std::ostringstream s;
-	s << "[";
+	std::string json;
+	appendJSON(json);
+	return json;
+}
+
+void GenericAttributeList::appendJSON(std::string & out) const {
+	out += '[';
 	bool first = true;
 	for(const auto & element : l) {
 		if(element != nullptr) {
 			if(first)
 				first = false;
 			else
-				s << ",";
-			s << element->toJSON();
+				out += ',';
+			element.appendJSON(out);
 		}
 	}
-	s << "]";
-	return s.str();
+	out += ']';
 }
 
 std::string GenericAttributeList::toString() const {
@@ -169,7 +578,7 @@ std::string GenericAttributeList::toString() const {
 	for(const auto & element : l) {
 		if(element != nullptr) {
 			s << "\t" << StringUtils::replaceAll(StringUtils::trim(
-					element->toString()), "\n", "\n\t") << "\n";
+					element.toString()), "\n", "\n\t") << "\n";
 		}
 	}
 	s << "]\n";
@@ -186,24 +595,12 @@ std::string GenericAttributeList::implode(const std::string & separator) const {
 			} else {
 				s << separator;
 			}
-			s << element->toString();
+			s << element.toString();
 		}
 	}
 	return s.str();
 }
 
-GenericAttribute * GenericAttributeList::at(int index) const {
-	if(index < 0) {
-		return nullptr;
-	}
-	for(const auto & element : l) {
-		if(index-- == 0) {
-			return element.get();
-		}
-	}
-	return nullptr;
-}
-
 //! ---|> GenericAttribute
 bool GenericAttributeList::operator==(const GenericAttribute & other)const{
 	const attr_t * otherList = (&other)->toType<const attr_t>();
@@ -211,10 +608,12 @@ bool GenericAttributeList::operator==(const GenericAttribute & other)const{
 		return false;
 	if(size()!=otherList->size())
 		return false;
-	int i = 0;
+	auto otherIt = otherList->l.begin();
 	for(const auto & value : l) {
-		const auto & otherValue = otherList->at(i++);
-		if( (value==nullptr && otherValue!=nullptr) || (*value != *otherValue))
+		const auto & otherValue = *otherIt++;
+		if(value==nullptr && otherValue==nullptr)
+			continue;
+		if(value==nullptr || otherValue==nullptr || !value.isEqual(otherValue))
 			return false;
 	}
 	return true;
@@ -14,18 +14,26 @@
 #include "References.h"
 #include "StringIdentifier.h"
 #include "StringUtils.h"
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
-#include <deque>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <iterator>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <stdexcept>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace Util{
 class BoolAttribute;
 template <typename Number> class _NumberAttribute;
+template <typename Number> class NumberArrayAttribute;
 template <typename Type> class WrapperAttribute;
 template <typename ObjType> class ReferenceAttribute;
 template <typename StringType> class _StringAttribute;
@@ -36,6 +44,138 @@ class GenericAttributeList;
 //! @addtogroup generic_attr
 //! @{
 
+/**
+ * Kind of the built-in generic attribute types. It is stored in every
+ * attribute to identify its type without RTTI. Other types, including
+ * classes derived from the built-in ones by users, fall back to dynamic_cast.
+ */
+enum class GenericAttributeKind : uint8_t {
+	UNDEFINED,
+	BOOL,
+	NUMBER_DOUBLE,
+	NUMBER_FLOAT,
+	NUMBER_LONG_LONG,
+	NUMBER_UNSIGNED_LONG_LONG,
+	NUMBER_LONG,
+	NUMBER_UNSIGNED_LONG,
+	NUMBER_INT,
+	NUMBER_UNSIGNED_INT,
+	NUMBER_SHORT,
+	NUMBER_UNSIGNED_SHORT,
+	NUMBER_CHAR,
+	NUMBER_SIGNED_CHAR,
+	NUMBER_UNSIGNED_CHAR,
+	STRING,
+	LIST,
+	MAP,
+	NUMBER_ARRAY_DOUBLE,
+	NUMBER_ARRAY_FLOAT,
+	NUMBER_ARRAY_INT,
+	NUMBER_ARRAY_UNSIGNED_INT,
+	NUMBER_ARRAY_SHORT,
+	NUMBER_ARRAY_UNSIGNED_SHORT,
+	NUMBER_ARRAY_SIGNED_CHAR,
+	NUMBER_ARRAY_UNSIGNED_CHAR
+};
+
+//! Kind of the attribute class @p attribute_t; UNDEFINED if it is not a built-in type.
+template<typename attribute_t>
+struct GenericAttributeKindOf {
+	static const GenericAttributeKind value = GenericAttributeKind::UNDEFINED;
+};
+#define UTIL_GENERIC_ATTRIBUTE_KIND(attribute_t, kind) \
+	template<> struct GenericAttributeKindOf<attribute_t> { \
+		static const GenericAttributeKind value = GenericAttributeKind::kind; \
+	};
+UTIL_GENERIC_ATTRIBUTE_KIND(BoolAttribute, BOOL)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<double>, NUMBER_DOUBLE)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<float>, NUMBER_FLOAT)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<long long>, NUMBER_LONG_LONG)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<unsigned long long>, NUMBER_UNSIGNED_LONG_LONG)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<long>, NUMBER_LONG)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<unsigned long>, NUMBER_UNSIGNED_LONG)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<int>, NUMBER_INT)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<unsigned int>, NUMBER_UNSIGNED_INT)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<short>, NUMBER_SHORT)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<unsigned short>, NUMBER_UNSIGNED_SHORT)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<char>, NUMBER_CHAR)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<signed char>, NUMBER_SIGNED_CHAR)
+UTIL_GENERIC_ATTRIBUTE_KIND(_NumberAttribute<unsigned char>, NUMBER_UNSIGNED_CHAR)
+UTIL_GENERIC_ATTRIBUTE_KIND(StringAttribute, STRING)
+UTIL_GENERIC_ATTRIBUTE_KIND(GenericAttributeList, LIST)
+UTIL_GENERIC_ATTRIBUTE_KIND(GenericAttributeMap, MAP)
+UTIL_GENERIC_ATTRIBUTE_KIND(NumberArrayAttribute<double>, NUMBER_ARRAY_DOUBLE)
+UTIL_GENERIC_ATTRIBUTE_KIND(NumberArrayAttribute<float>, NUMBER_ARRAY_FLOAT)
+UTIL_GENERIC_ATTRIBUTE_KIND(NumberArrayAttribute<int>, NUMBER_ARRAY_INT)
+UTIL_GENERIC_ATTRIBUTE_KIND(NumberArrayAttribute<unsigned int>, NUMBER_ARRAY_UNSIGNED_INT)
+UTIL_GENERIC_ATTRIBUTE_KIND(NumberArrayAttribute<short>, NUMBER_ARRAY_SHORT)
+UTIL_GENERIC_ATTRIBUTE_KIND(NumberArrayAttribute<unsigned short>, NUMBER_ARRAY_UNSIGNED_SHORT)
+UTIL_GENERIC_ATTRIBUTE_KIND(NumberArrayAttribute<signed char>, NUMBER_ARRAY_SIGNED_CHAR)
+UTIL_GENERIC_ATTRIBUTE_KIND(NumberArrayAttribute<unsigned char>, NUMBER_ARRAY_UNSIGNED_CHAR)
+#undef UTIL_GENERIC_ATTRIBUTE_KIND
+
+namespace _Internals {
+//! Distribute the bits of @p value over the result (finalizer of SplitMix64).
+inline uint64_t mixHash(uint64_t value) {
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+	return value ^ (value >> 31);
+}
+//! Combine two hash values; the result depends on the order.
+inline uint64_t combineHash(uint64_t seed, uint64_t value) {
+	return mixHash(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+}
+//! Hash value of the characters of a string.
+UTILAPI uint64_t hashBytes(const char * data, std::size_t size);
+//! Hash value of a number; numbers that compare equal (like 0.0 and -0.0) get the same value.
+template<typename Number>
+typename std::enable_if<std::is_integral<Number>::value, uint64_t>::type hashNumber(Number number) {
+	return mixHash(static_cast<uint64_t>(number));
+}
+template<typename Number>
+typename std::enable_if<std::is_floating_point<Number>::value, uint64_t>::type hashNumber(Number number) {
+	if(number == 0) {
+		return mixHash(0);
+	}
+	const double value = static_cast<double>(number);
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return mixHash(bits);
+}
+
+/**
+ * Structural hash value of a container that is computed when it is requested
+ * for the first time. It is reset whenever the elements of the container
+ * may be modified.
+ */
+class CachedHash {
+		mutable std::atomic<uint64_t> value;
+	public:
+		CachedHash() : value(0) {}
+		CachedHash(const CachedHash & other) : value(other.get()) {}
+		//! The moved-from container is empty; its hash has to be computed again.
+		CachedHash(CachedHash && other) : value(other.get()) {	other.reset();	}
+		CachedHash & operator=(const CachedHash & other) {
+			value.store(other.get(), std::memory_order_relaxed);
+			return *this;
+		}
+		CachedHash & operator=(CachedHash && other) {
+			value.store(other.get(), std::memory_order_relaxed);
+			other.reset();
+			return *this;
+		}
+		//! Return the cached value, or 0 if it has not been computed.
+		uint64_t get() const			{	return value.load(std::memory_order_relaxed);	}
+		//! Store the computed value and return it; 0 is replaced by 1.
+		uint64_t set(uint64_t hash) const {
+			hash = hash == 0 ? 1 : hash;
+			value.store(hash, std::memory_order_relaxed);
+			return hash;
+		}
+		void reset() const				{	value.store(0, std::memory_order_relaxed);	}
+};
+}
+
 /**
  * Abstract base class of all generic attributes. A generic attribute is used to
  * store arbitrary types of data into a location.
@@ -100,6 +240,16 @@ class GenericAttribute{
 		static _NumberAttribute<Number> * createNumber(Number f) {
 			return new _NumberAttribute<Number>(f);
 		}
+		/**
+		 * Encapsulate an array of numbers into a generic attribute.
+		 *
+		 * @param values Standard numbers
+		 * @return Numbers encapsulated into a generic number array attribute
+		 */
+		template<typename Number>
+		static NumberArrayAttribute<Number> * createNumberArray(std::vector<Number> values) {
+			return new NumberArrayAttribute<Number>(std::move(values));
+		}
 		/**
 		 * Encapsulate a standard bool into a generic attribute.
 		 *
@@ -128,7 +278,16 @@ class GenericAttribute{
 		}
 		// ----------------------------------
 
-		virtual ~GenericAttribute()	{}
+		UTILAPI virtual ~GenericAttribute();
+
+		/**
+		 * Attributes are placed into the active GenericAttributeArena of the
+		 * current thread, if there is one.
+		 */
+		UTILAPI static void * operator new(std::size_t size);
+		UTILAPI static void operator delete(void * ptr);
+		static void * operator new(std::size_t, void * ptr)	{	return ptr;	}
+		static void operator delete(void *, void *)			{}
 
 		// ---o
 		/**
@@ -140,7 +299,9 @@ class GenericAttribute{
 		
 		//! returns true iff the object is of the given type.
 		template<class specificAttr_t>
-		bool isA()const								{	return dynamic_cast<const specificAttr_t*>(this)!=nullptr;	}
+		bool isA()const								{	return toType<const specificAttr_t>()!=nullptr;	}
+		//! Return the kind of the object; UNDEFINED if it is not a built-in type.
+		GenericAttributeKind getKind()const			{	return kind;	}
 		/**
 		 * Convert the object to a human-readable string.
 		 *
@@ -183,14 +344,47 @@ class GenericAttribute{
 		 * @return JSON representation;
 		 */
 		virtual std::string toJSON()const			{	return std::string("\"")+StringUtils::escape(toString())+"\"";	}
+		/**
+		 * Append the JSON representation to @p out. Containers append their
+		 * elements directly, so that a whole tree is written in one pass
+		 * into a single buffer, which can be reused for further calls.
+		 * The default implementation appends the result of toJSON().
+		 */
+		virtual void appendJSON(std::string & out)const	{	out += toJSON();	}
+		//! Write the JSON representation to the stream (see appendJSON()); the text is passed to the stream in blocks of bounded size.
+		UTILAPI void writeJSON(std::ostream & out)const;
+
+		/**
+		 * Return a 64-bit hash value of the type and the content. Attributes
+		 * that are equal according to operator== have the same value, so
+		 * different values prove that two trees differ. Maps and lists cache
+		 * their value until they are modified, or until their attributes are
+		 * accessed in a way that allows modifications (e.g. using the non-const
+		 * getValue()).
+		 * The value can be used as a fingerprint to find out whether a tree
+		 * has changed, but it is only stable during one execution of the
+		 * program. The default implementation hashes the result of toString().
+		 * @note Attributes obtained from a container before the value is
+		 * computed must not be modified in place afterwards, as the cached
+		 * value of the container would be outdated. For this reason,
+		 * operator== always compares the content.
+		 */
+		UTILAPI virtual uint64_t getStructuralHash()const;
 
+		/**
+		 * Cast the object to the given type. Built-in types are identified by
+		 * their kind; other types are cast using dynamic_cast.
+		 *
+		 * @return Pointer to the object, or nullptr if it is not of the given type
+		 */
 		template<class specificAttr_t>
 		specificAttr_t * toType() {
-			return dynamic_cast<specificAttr_t*>(this);
+			return const_cast<specificAttr_t *>(static_cast<const GenericAttribute *>(this)->toType<const specificAttr_t>());
 		}
 		template<class specificAttr_t>
 		const specificAttr_t * toType() const {
-			return dynamic_cast<const specificAttr_t*>(this);
+			typedef typename std::remove_cv<specificAttr_t>::type plain_t;
+			return _toType<plain_t>(std::integral_constant<bool, GenericAttributeKindOf<plain_t>::value != GenericAttributeKind::UNDEFINED>());
 		}
 
 		//! Per default, the comparison returns false for unspecified types.
@@ -200,14 +394,35 @@ class GenericAttribute{
 	protected:
 		template<class specificAttr_t>
 		static bool _defaultIsEqual(const specificAttr_t * first,const GenericAttribute * second){
-			const specificAttr_t * other = dynamic_cast<const specificAttr_t*>(second);
+			const specificAttr_t * other = second->toType<const specificAttr_t>();
 			return other != nullptr ? first->get() == other->get() : false;
 		}
-		GenericAttribute() = default;
-		GenericAttribute(const GenericAttribute &) = default;
-		GenericAttribute(GenericAttribute &&) = default;
-		GenericAttribute & operator=(const GenericAttribute &) = default;
-		GenericAttribute & operator=(GenericAttribute &&) = default;
+		GenericAttribute() : kind(GenericAttributeKind::UNDEFINED), inArena(isArenaAllocation(this)) {}
+		//! Constructor for the built-in types
+		explicit GenericAttribute(GenericAttributeKind _kind) : kind(_kind), inArena(isArenaAllocation(this)) {}
+		//! Copies do not take over the memory location of the original.
+		GenericAttribute(const GenericAttribute & other) : kind(other.kind), inArena(isArenaAllocation(this)) {}
+		GenericAttribute(GenericAttribute && other) : kind(other.kind), inArena(isArenaAllocation(this)) {}
+		GenericAttribute & operator=(const GenericAttribute & other)	{	kind = other.kind;	return *this;	}
+		GenericAttribute & operator=(GenericAttribute && other)			{	kind = other.kind;	return *this;	}
+
+	private:
+		GenericAttributeKind kind;
+		//! True if the memory of the attribute belongs to a GenericAttributeArena
+		bool inArena;
+
+		UTILAPI static bool isArenaAllocation(const GenericAttribute * attribute);
+
+		//! Built-in type: compare the kind
+		template<class specificAttr_t>
+		const specificAttr_t * _toType(std::true_type) const {
+			return kind == GenericAttributeKindOf<specificAttr_t>::value ? static_cast<const specificAttr_t *>(this) : nullptr;
+		}
+		//! Other type: use RTTI
+		template<class specificAttr_t>
+		const specificAttr_t * _toType(std::false_type) const {
+			return dynamic_cast<const specificAttr_t *>(this);
+		}
 };
 
 /**
@@ -299,6 +514,7 @@ class GenericNumberAttribute : public GenericAttribute {
 	public:
 		typedef GenericNumberAttribute attr_t;
 	protected:
+		explicit GenericNumberAttribute(GenericAttributeKind _kind) : GenericAttribute(_kind) {}
 		virtual ~GenericNumberAttribute() {
 		}
 };
@@ -311,7 +527,7 @@ class _NumberAttribute : public GenericNumberAttribute {
 	public:
 		typedef _NumberAttribute<Number> attr_t;
 
-		explicit _NumberAttribute(Number _n) : GenericNumberAttribute(), data(_n) {
+		explicit _NumberAttribute(Number _n) : GenericNumberAttribute(GenericAttributeKindOf<attr_t>::value), data(_n) {
 		}
 		virtual ~_NumberAttribute() {
 		}
@@ -337,10 +553,14 @@ class _NumberAttribute : public GenericNumberAttribute {
 		attr_t * clone() const override				{	return new attr_t(*this);	}
 		std::string toString() const override		{	return StringUtils::toString<Number>(data);	}
 		std::string toJSON() const override			{	return toString();	}
+		void appendJSON(std::string & out) const override	{	out += toString();	}
 		double toDouble() const override			{	return static_cast<double>(data);	}
 		float toFloat() const override				{	return static_cast<float>(data);	}
 		int toInt() const override					{	return static_cast<int>(data);	}
 		unsigned int toUnsignedInt()const override	{	return static_cast<unsigned int>(data);	}
+		uint64_t getStructuralHash() const override	{
+			return _Internals::combineHash(static_cast<uint64_t>(getKind()), _Internals::hashNumber(data));
+		}
 		bool operator==(const GenericAttribute & other) const override{
 			return _defaultIsEqual(this,&other);
 		}
@@ -348,7 +568,72 @@ class _NumberAttribute : public GenericNumberAttribute {
 		Number data;
 };
 
+/**
+ * Generic attribute to store an array of numbers (e.g. vertex data or sample
+ * buffers) in a single contiguous block of memory. Compared to a
+ * GenericAttributeList, no GenericAttribute is allocated per number.
+ * Serialization and conversion to Generic use a bulk representation for the
+ * element types that have a GenericAttributeKind (double, float, int,
+ * unsigned int, short, unsigned short, signed char and unsigned char).
+ */
+template<typename Number>
+class NumberArrayAttribute : public GenericAttribute {
+		static_assert(std::is_arithmetic<Number>::value && !std::is_same<Number, bool>::value, "Number has to be a number type.");
+	public:
+		typedef NumberArrayAttribute<Number> attr_t;
 
+		NumberArrayAttribute() : GenericAttribute(GenericAttributeKindOf<attr_t>::value), data() {
+		}
+		explicit NumberArrayAttribute(std::vector<Number> values) :
+			GenericAttribute(GenericAttributeKindOf<attr_t>::value), data(std::move(values)) {
+		}
+		//! Copy @p count numbers from @p values.
+		NumberArrayAttribute(const Number * values, std::size_t count) :
+			GenericAttribute(GenericAttributeKindOf<attr_t>::value), data(values, values + count) {
+		}
+		virtual ~NumberArrayAttribute() {
+		}
+
+		//! Return a read-only reference to the stored numbers.
+		const std::vector<Number> & get() const		{	return data;	}
+		//! Return a reference to the stored numbers that allows modifications.
+		std::vector<Number> & get()					{	return data;	}
+		//! Replace the stored numbers.
+		void set(std::vector<Number> values)		{	data = std::move(values);	}
+
+		std::size_t size() const					{	return data.size();	}
+		bool empty() const							{	return data.empty();	}
+		Number operator[](std::size_t index) const	{	return data[index];	}
+
+		attr_t * clone() const override				{	return new attr_t(*this);	}
+		std::string toString() const override		{	return toJSON();	}
+		std::string toJSON() const override			{	std::string json;	appendJSON(json);	return json;	}
+		void appendJSON(std::string & out) const override {
+			// The numbers are formatted like _NumberAttribute::toString(), which reads them back exactly.
+			char digits[StringUtils::MAX_NUMBER_LENGTH];
+			out += '[';
+			for(std::size_t i = 0; i < data.size(); ++i) {
+				if(i != 0) {
+					out += ',';
+				}
+				out.append(digits, StringUtils::formatNumber(digits, data[i]));
+			}
+			out += ']';
+		}
+		//! The value is not cached, as the numbers can be modified through get().
+		uint64_t getStructuralHash() const override {
+			uint64_t hash = _Internals::combineHash(static_cast<uint64_t>(getKind()), data.size());
+			for(const auto & number : data) {
+				hash = _Internals::combineHash(hash, _Internals::hashNumber(number));
+			}
+			return hash;
+		}
+		bool operator==(const GenericAttribute & other) const override{
+			return _defaultIsEqual(this,&other);
+		}
+	private:
+		std::vector<Number> data;
+};
 
 /**
  * Generic attribute to store a Bool value.
@@ -357,7 +642,7 @@ class BoolAttribute:public GenericAttribute{
 	public:
 		typedef BoolAttribute attr_t;
 
-		explicit BoolAttribute(bool _n) : GenericAttribute(), data(_n) {
+		explicit BoolAttribute(bool _n) : GenericAttribute(GenericAttributeKind::BOOL), data(_n) {
 		}
 		virtual ~BoolAttribute() {
 		}
@@ -383,11 +668,15 @@ class BoolAttribute:public GenericAttribute{
 		attr_t * clone() const override				{	return new attr_t(*this);	}
 		std::string toString() const override			{	return data?"true":"false";	}
 		std::string toJSON() const override			{	return toString();	}
+		void appendJSON(std::string & out) const override	{	out += data?"true":"false";	}
 		double toDouble() const override				{	return data?1:0;	}
 		float toFloat() const override				{	return data?1:0;	}
 		int toInt() const override					{	return data?1:0;	}
 		bool toBool() const override					{	return data;	 }
 		unsigned int toUnsignedInt() const override	{	return data?1:0;	}
+		uint64_t getStructuralHash() const override	{
+			return _Internals::combineHash(static_cast<uint64_t>(getKind()), _Internals::hashNumber(data ? 1 : 0));
+		}
 		bool operator==(const GenericAttribute & other)const override{
 			return _defaultIsEqual(this,&other);
 		}
@@ -405,6 +694,7 @@ class GenericStringAttribute : public GenericAttribute	{
 public:
 		typedef GenericStringAttribute attr_t;
 	protected:
+		explicit GenericStringAttribute(GenericAttributeKind _kind) : GenericAttribute(_kind) {}
 		virtual ~GenericStringAttribute()	{}
 };
 
@@ -423,7 +713,7 @@ class _StringAttribute : public GenericStringAttribute{
 											other_string_t, 
 											StringType>::value>::type>
 		explicit _StringAttribute(other_string_t && otherString) : 
-			GenericStringAttribute(), data(std::forward<other_string_t>(otherString)) {
+			GenericStringAttribute(GenericAttributeKindOf<attr_t>::value), data(std::forward<other_string_t>(otherString)) {
 		}
 
 		virtual ~_StringAttribute() {
@@ -452,15 +742,29 @@ class _StringAttribute : public GenericStringAttribute{
 		bool toBool() const override				{	return data=="true" || data=="TRUE" || data=="1";	}
 		std::string toString() const override		{	return StringUtils::toString(data);	}
 		std::string toJSON() const override			{	return std::string("\"")+StringUtils::escape(toString())+"\"";	}
+		void appendJSON(std::string & out) const override {
+			const std::string & str = asString(data);
+			out += '"';
+			StringUtils::appendEscaped(out, str.data(), str.size());
+			out += '"';
+		}
 		double toDouble() const override			{	return StringUtils::toNumber<double>(data);	}
 		float toFloat() const override				{	return StringUtils::toNumber<float>(data);	}
 		int toInt() const override					{	return StringUtils::toNumber<int>(data);	}
 		unsigned int toUnsignedInt() const override	{	return StringUtils::toNumber<unsigned int>(data);	}
+		uint64_t getStructuralHash() const override {
+			const std::string & str = asString(data);
+			return _Internals::combineHash(static_cast<uint64_t>(getKind()), _Internals::hashBytes(str.data(), str.size()));
+		}
 		bool operator==(const GenericAttribute & other) const override{
 			return _defaultIsEqual(this,&other);
 		}
 	private:
 		StringType data;
+
+		static const std::string & asString(const std::string & str)	{	return str;	}
+		template<typename other_string_t>
+		static std::string asString(const other_string_t & str)		{	return StringUtils::toString(str);	}
 };
 
 StringAttribute * GenericAttribute::createString(const std::string & s) {
@@ -497,19 +801,276 @@ class ReferenceAttribute:public WrapperAttribute<Reference<ObjType>>{
 
 };
 
+/**
+ * Owner of an element of a GenericAttributeMap or GenericAttributeList.
+ * Booleans, numbers of type int, unsigned int, float and double, and strings
+ * of up to MAX_INLINE_STRING_LENGTH characters are stored inline without
+ * allocating a GenericAttribute. Such a value is converted into a
+ * GenericAttribute when a pointer to it is requested for the first time;
+ * from then on, the attribute holds the value. The conversion is thread-safe.
+ * The interface resembles std::unique_ptr<GenericAttribute>.
+ */
+class GenericAttributeSlot {
+	public:
+		static const std::size_t MAX_INLINE_STRING_LENGTH = 15;
+
+		GenericAttributeSlot() : attribute(nullptr), inlineKind(GenericAttributeKind::UNDEFINED), stringLength(0) {}
+		explicit GenericAttributeSlot(GenericAttribute * attr) :
+			attribute(attr), inlineKind(GenericAttributeKind::UNDEFINED), stringLength(0) {}
+		GenericAttributeSlot(GenericAttributeSlot && other) noexcept :
+				attribute(other.attribute.exchange(nullptr)), value(other.value),
+				inlineKind(other.inlineKind), stringLength(other.stringLength) {
+			other.inlineKind = GenericAttributeKind::UNDEFINED;
+		}
+		GenericAttributeSlot(const GenericAttributeSlot &) = delete;
+		~GenericAttributeSlot() {
+			delete attribute.load(std::memory_order_relaxed);
+		}
+		GenericAttributeSlot & operator=(GenericAttributeSlot && other) {
+			if(this != &other) {
+				delete attribute.exchange(other.attribute.exchange(nullptr));
+				value = other.value;
+				inlineKind = other.inlineKind;
+				stringLength = other.stringLength;
+				other.inlineKind = GenericAttributeKind::UNDEFINED;
+			}
+			return *this;
+		}
+		GenericAttributeSlot & operator=(const GenericAttributeSlot &) = delete;
+
+		static GenericAttributeSlot createBool(bool b) {
+			GenericAttributeSlot slot;
+			slot.inlineKind = GenericAttributeKind::BOOL;
+			slot.value.boolValue = b;
+			return slot;
+		}
+		static GenericAttributeSlot createNumber(int n) {
+			GenericAttributeSlot slot;
+			slot.inlineKind = GenericAttributeKind::NUMBER_INT;
+			slot.value.intValue = n;
+			return slot;
+		}
+		static GenericAttributeSlot createNumber(unsigned int n) {
+			GenericAttributeSlot slot;
+			slot.inlineKind = GenericAttributeKind::NUMBER_UNSIGNED_INT;
+			slot.value.unsignedIntValue = n;
+			return slot;
+		}
+		static GenericAttributeSlot createNumber(float n) {
+			GenericAttributeSlot slot;
+			slot.inlineKind = GenericAttributeKind::NUMBER_FLOAT;
+			slot.value.floatValue = n;
+			return slot;
+		}
+		static GenericAttributeSlot createNumber(double n) {
+			GenericAttributeSlot slot;
+			slot.inlineKind = GenericAttributeKind::NUMBER_DOUBLE;
+			slot.value.doubleValue = n;
+			return slot;
+		}
+		//! Numbers of other types are stored in a GenericAttribute.
+		template<typename Number>
+		static GenericAttributeSlot createNumber(Number n) {
+			return GenericAttributeSlot(GenericAttribute::createNumber<Number>(n));
+		}
+		static GenericAttributeSlot createString(const std::string & s) {
+			if(s.size() > MAX_INLINE_STRING_LENGTH) {
+				return GenericAttributeSlot(GenericAttribute::createString(s));
+			}
+			GenericAttributeSlot slot;
+			slot.inlineKind = GenericAttributeKind::STRING;
+			slot.stringLength = static_cast<uint8_t>(s.size());
+			s.copy(slot.value.stringValue, s.size());
+			return slot;
+		}
+
+		/**
+		 * Return the attribute. An inline value is converted into a
+		 * GenericAttribute owned by the slot.
+		 */
+		GenericAttribute * get() const {
+			GenericAttribute * attr = attribute.load(std::memory_order_acquire);
+			return (attr != nullptr || inlineKind == GenericAttributeKind::UNDEFINED) ? attr : materialize();
+		}
+		GenericAttribute * operator->() const	{	return get();	}
+		GenericAttribute & operator*() const	{	return *get();	}
+		explicit operator bool() const {
+			return inlineKind != GenericAttributeKind::UNDEFINED || attribute.load(std::memory_order_relaxed) != nullptr;
+		}
+
+		//! Replace the stored value by the given attribute.
+		void reset(GenericAttribute * attr = nullptr) {
+			inlineKind = GenericAttributeKind::UNDEFINED;
+			delete attribute.exchange(attr);
+		}
+		//! Give up the ownership of the attribute.
+		GenericAttribute * release() {
+			GenericAttribute * attr = get();
+			inlineKind = GenericAttributeKind::UNDEFINED;
+			attribute.store(nullptr, std::memory_order_relaxed);
+			return attr;
+		}
+
+		//! Return a deep copy; inline values stay inline.
+		UTILAPI GenericAttributeSlot clone() const;
+
+		//! Kind of the stored value; UNDEFINED for empty slots and other types.
+		GenericAttributeKind getKind() const {
+			const GenericAttribute * attr = attribute.load(std::memory_order_acquire);
+			return attr != nullptr ? attr->getKind() : inlineKind;
+		}
+		//! True iff the value is stored inline and has not been converted into a GenericAttribute.
+		bool isInline() const {
+			return inlineKind != GenericAttributeKind::UNDEFINED && attribute.load(std::memory_order_acquire) == nullptr;
+		}
+
+		/**
+		 * @name Access to inline values
+		 * Only valid if isInline() is true and getKind() returns the matching kind.
+		 */
+		//@{
+		bool getInlineBool() const					{	return value.boolValue;	}
+		int getInlineInt() const					{	return value.intValue;	}
+		unsigned int getInlineUnsignedInt() const	{	return value.unsignedIntValue;	}
+		float getInlineFloat() const				{	return value.floatValue;	}
+		double getInlineDouble() const				{	return value.doubleValue;	}
+		std::string getInlineString() const			{	return std::string(value.stringValue, stringLength);	}
+		//@}
+
+		/**
+		 * @name Conversions
+		 * Identical to the functions of GenericAttribute, but an inline value is
+		 * not converted into a GenericAttribute. The slot must not be empty.
+		 */
+		//@{
+		std::string toString() const			{	return call(&GenericAttribute::toString);	}
+		double toDouble() const					{	return call(&GenericAttribute::toDouble);	}
+		float toFloat() const					{	return call(&GenericAttribute::toFloat);	}
+		int toInt() const						{	return call(&GenericAttribute::toInt);	}
+		unsigned int toUnsignedInt() const		{	return call(&GenericAttribute::toUnsignedInt);	}
+		bool toBool() const						{	return call(&GenericAttribute::toBool);	}
+		std::string toJSON() const				{	std::string json;	appendJSON(json);	return json;	}
+		//! Append the JSON representation like GenericAttribute::appendJSON().
+		UTILAPI void appendJSON(std::string & out) const;
+		//@}
+
+		//! Compare the values of two non-empty slots like GenericAttribute::operator==.
+		UTILAPI bool isEqual(const GenericAttributeSlot & other) const;
+		//! Hash value of a non-empty slot like GenericAttribute::getStructuralHash(); inline values are not converted.
+		UTILAPI uint64_t getStructuralHash() const;
+
+	private:
+		mutable std::atomic<GenericAttribute *> attribute;
+		union Value {
+			bool boolValue;
+			int intValue;
+			unsigned int unsignedIntValue;
+			float floatValue;
+			double doubleValue;
+			char stringValue[MAX_INLINE_STRING_LENGTH];
+		} value;
+		GenericAttributeKind inlineKind;
+		uint8_t stringLength;
+
+		UTILAPI GenericAttribute * materialize() const;
+
+		//! Call the function on a temporary attribute on the stack for inline values.
+		template<typename result_t>
+		result_t call(result_t (GenericAttribute::*function)() const) const {
+			const GenericAttribute * attr = attribute.load(std::memory_order_acquire);
+			if(attr != nullptr) {
+				return (attr->*function)();
+			}
+			switch(inlineKind) {
+				case GenericAttributeKind::BOOL:
+					return (BoolAttribute(value.boolValue).*function)();
+				case GenericAttributeKind::NUMBER_INT:
+					return (_NumberAttribute<int>(value.intValue).*function)();
+				case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+					return (_NumberAttribute<unsigned int>(value.unsignedIntValue).*function)();
+				case GenericAttributeKind::NUMBER_FLOAT:
+					return (_NumberAttribute<float>(value.floatValue).*function)();
+				case GenericAttributeKind::NUMBER_DOUBLE:
+					return (_NumberAttribute<double>(value.doubleValue).*function)();
+				default:
+					// The string is short enough to not allocate memory.
+					return (StringAttribute(getInlineString()).*function)();
+			}
+		}
+};
+
+inline bool operator==(const GenericAttributeSlot & slot, std::nullptr_t)	{	return !slot;	}
+inline bool operator!=(const GenericAttributeSlot & slot, std::nullptr_t)	{	return static_cast<bool>(slot);	}
+
 /**
  * Generic attribute to store a map data structure.
+ * The elements are stored in a flat array that is searched linearly. Only
+ * maps with more than INDEX_THRESHOLD elements additionally build a hash
+ * index. The order of the elements is unspecified: new elements are
+ * appended and an erased element is replaced by the last one.
  */
 class GenericAttributeMap : public GenericAttribute	{
+	public:
+		typedef std::pair<StringIdentifier, GenericAttributeSlot> value_type;
+		//! Number of elements up to which no hash index is used
+		static const std::size_t INDEX_THRESHOLD = 16;
+
 	private:
-		// GenericAttributeMap has unique ownership of its elements
-		std::unordered_map<StringIdentifier, std::unique_ptr<GenericAttribute>> m;
+		//! Elements of a map; shared by maps created with cloneShared() until one of them is modified.
+		struct Data {
+			std::vector<value_type> elements;
+			//! Positions of the elements; only present for large maps
+			std::unique_ptr<std::unordered_map<StringIdentifier, std::size_t>> index;
+			//! Shared together with the elements
+			_Internals::CachedHash hash;
+		};
+		//! nullptr for a map that has never contained an element
+		std::shared_ptr<Data> data;
+
+		//! Elements of all maps without data
+		UTILAPI static const std::vector<value_type> & getNoElements();
+		/**
+		 * Make sure that the elements are not shared with another map.
+		 * Only this level is copied; contained maps are shared again.
+		 */
+		void unshare() {
+			if(data && data.use_count() != 1) {
+				copyData();
+			}
+		}
+		UTILAPI void copyData();
+		//! The elements may be modified: unshare them and reset the cached hash value.
+		void prepareModification() {
+			if(data) {
+				unshare();
+				data->hash.reset();
+			}
+		}
+		Data & getMutableData() {
+			if(!data) {
+				data = std::make_shared<Data>();
+			} else {
+				prepareModification();
+			}
+			return *data;
+		}
+
+		//! Return the position of the element with the given key, or the number of elements if there is none.
+		UTILAPI std::size_t findPosition(const StringIdentifier & key) const;
+		//! Return the non-empty slot with the given key, or nullptr if there is none.
+		const GenericAttributeSlot * findSlot(const StringIdentifier & key) const {
+			const std::size_t position = findPosition(key);
+			const auto & elements = getElements();
+			return (position == elements.size() || !elements[position].second) ? nullptr : &elements[position].second;
+		}
+		friend class GenericAttributePath;
+		friend class GenericAttributePatch;
 
 	public:
 		typedef GenericAttributeMap attr_t;
 		
-		typedef std::unordered_map<StringIdentifier, std::unique_ptr<GenericAttribute>>::const_iterator const_iterator;
-		typedef std::unordered_map<StringIdentifier, std::unique_ptr<GenericAttribute>>::iterator iterator;
+		typedef std::vector<value_type>::const_iterator const_iterator;
+		typedef std::vector<value_type>::iterator iterator;
 
 		UTILAPI GenericAttributeMap();
 		GenericAttributeMap(const GenericAttributeMap &) = delete;
@@ -519,60 +1080,141 @@ class GenericAttributeMap : public GenericAttribute	{
 		GenericAttributeMap & operator=(const GenericAttributeMap &) = delete;
 		GenericAttributeMap & operator=(GenericAttributeMap &&) = default;
 
-		void clear()		{	m.clear();	}
-		UTILAPI void setValue(const StringIdentifier & key,GenericAttribute * attr);
+		void clear()		{	data.reset();	}
+		void reserve(size_t count)	{	getMutableData().elements.reserve(count);	}
+		void setValue(const StringIdentifier & key,GenericAttribute * attr)	{	setValue(key, GenericAttributeSlot(attr));	}
+		UTILAPI void setValue(const StringIdentifier & key, GenericAttributeSlot && slot);
+		//! Store a bool without allocating a GenericAttribute.
+		void setBool(const StringIdentifier & key, bool value)				{	setValue(key, GenericAttributeSlot::createBool(value));	}
+		//! Store a number; int, unsigned int, float and double do not allocate a GenericAttribute.
+		template<typename Number>
+		typename std::enable_if<std::is_arithmetic<Number>::value && !std::is_same<Number, bool>::value>::type
+		setNumber(const StringIdentifier & key, Number value)				{	setValue(key, GenericAttributeSlot::createNumber(value));	}
 		UTILAPI bool unsetValue(const StringIdentifier & key);
 		UTILAPI bool contains(const StringIdentifier & key)const;
-		UTILAPI GenericAttribute * getValue(const StringIdentifier & stringId)const;
-		template<typename T>T * getValue(const StringIdentifier & key)const			{	return dynamic_cast<T*>(getValue(key));	}
+		/**
+		 * Return the attribute stored for the given key.
+		 * As the attribute may be modified through the returned pointer, a map
+		 * that shares its elements (see cloneShared()) copies them first, and
+		 * the cached hash value is reset (see getStructuralHash()).
+		 */
+		UTILAPI GenericAttribute * getValue(const StringIdentifier & stringId);
+		/**
+		 * @deprecated Use findValue() to read the attribute, or the non-const
+		 * getValue() to modify it. Like the latter, this function copies
+		 * shared elements and resets the cached hash value, so it must not be
+		 * called concurrently with other accesses to the map.
+		 */
+		GenericAttribute * getValue(const StringIdentifier & key) const {
+			return const_cast<GenericAttributeMap *>(this)->getValue(key);
+		}
+		template<typename T>T * getValue(const StringIdentifier & key)			{
+			GenericAttribute * attribute = getValue(key);
+			return attribute == nullptr ? nullptr : attribute->toType<T>();
+		}
+		//! @deprecated Use findValue<T>() or the non-const getValue<T>().
+		template<typename T>T * getValue(const StringIdentifier & key)const	{
+			return const_cast<GenericAttributeMap *>(this)->getValue<T>(key);
+		}
+		//! Return the attribute stored for the given key for reading; shared elements stay shared.
+		const GenericAttribute * findValue(const StringIdentifier & key) const {
+			const GenericAttributeSlot * slot = findSlot(key);
+			return slot == nullptr ? nullptr : slot->get();
+		}
+		template<typename T>const T * findValue(const StringIdentifier & key)const	{
+			const GenericAttribute * attribute = findValue(key);
+			return attribute == nullptr ? nullptr : attribute->toType<const T>();
+		}
 		bool getBool(const StringIdentifier & key,const bool defaultValue=false)const	{
-			const GenericAttribute * v = getValue(key);
+			const GenericAttributeSlot * v = findSlot(key);
 			return v==nullptr ? defaultValue : v->toBool();
 		}
 		double getDouble(const StringIdentifier & key, double defaultValue = 0.0) const {
-			const GenericAttribute * attribute = getValue(key);
-			return attribute == nullptr ? defaultValue : attribute->toDouble();
+			const GenericAttributeSlot * slot = findSlot(key);
+			return slot == nullptr ? defaultValue : slot->toDouble();
 		}
 		float getFloat(const StringIdentifier & key,const float defaultValue=0.0f)const	{
-			const GenericAttribute * v = getValue(key);
+			const GenericAttributeSlot * v = findSlot(key);
 			return v==nullptr ? defaultValue : v->toFloat();
 		}
 		int getInt(const StringIdentifier & key,const int defaultValue=0)const	{
-			const GenericAttribute * v = getValue(key);
+			const GenericAttributeSlot * v = findSlot(key);
 			return v==nullptr ? defaultValue : v->toInt();
 		}
 		unsigned int getUInt(const StringIdentifier & key,const unsigned int defaultValue=0)const	{
-			const GenericAttribute * v = getValue(key);
+			const GenericAttributeSlot * v = findSlot(key);
 			return v==nullptr ? defaultValue : v->toUnsignedInt();
 		}
 
 		UTILAPI std::string getString(const StringIdentifier & key,const std::string & defaultValue="")const;
+		//! Store a string; short strings do not allocate a GenericAttribute.
 		UTILAPI void setString(const StringIdentifier & key,const std::string & value);
 
-		const_iterator begin()const				{	return m.begin();	}
-		const_iterator end()const				{	return m.end();	 }
-		size_t size()const						{	return m.size();	}
-		bool empty() const						{	return m.empty();	}
+		//! The iterators of a const map leave shared elements shared; the attributes must not be modified through them.
+		const_iterator begin()const				{	return getElements().begin();	}
+		const_iterator end()const				{	return getElements().end();	 }
+		//! The iterators of a non-const map give access to the attributes; like getValue(), they unshare the elements and reset the cached hash value first.
+		const_iterator begin()					{	prepareModification();	return getElements().begin();	}
+		const_iterator end()					{	prepareModification();	return getElements().end();	 }
+		size_t size()const						{	return getElements().size();	}
+		bool empty() const						{	return getElements().empty();	}
+		/**
+		 * Read-only access to the elements that neither unshares them nor resets the cached hash value.
+		 * @note The elements may be shared with other maps; the attributes must not be modified.
+		 */
+		const std::vector<value_type> & getElements() const	{	return data ? data->elements : getNoElements();	}
 
+		//! Return a deep copy of the map.
 		UTILAPI GenericAttributeMap * clone() const override;
+		/**
+		 * Return a copy of the map that shares the elements with this map
+		 * (copy-on-write). Creating the copy takes constant time. The first
+		 * modification of one of the maps (or access to its attributes via
+		 * the non-const getValue() or iterators) copies the elements of that map;
+		 * contained maps are not copied but shared again, so that only the
+		 * path to a modified value is duplicated.
+		 * @note Attributes obtained from this map before the call (e.g. with
+		 * the non-const getValue()) are shared with the copy: modifying them
+		 * in place afterwards changes both maps. Get them again from the map
+		 * that is modified instead.
+		 */
+		UTILAPI GenericAttributeMap * cloneShared() const;
+		//! Return true if the elements are currently shared with another map.
+		bool isShared() const					{	return data && data.use_count() != 1;	}
+		UTILAPI uint64_t getStructuralHash() const override;
 		UTILAPI std::string toJSON() const override;
+		UTILAPI void appendJSON(std::string & out) const override;
 		UTILAPI std::string toString() const override;
 		UTILAPI bool operator==(const GenericAttribute &) const override;
 };
 
 /**
  * Generic attribute to store a list data structure.
+ * All functions that give access to the elements reset the cached hash value
+ * (see getStructuralHash()), as the elements may be modified through them.
  */
 class GenericAttributeList : public GenericAttribute	{
 	private:
 		// GenericAttributeList has unique ownership of its elements
-		std::deque<std::unique_ptr<GenericAttribute>> l;
+		std::vector<GenericAttributeSlot> l;
+		_Internals::CachedHash hash;
+
+		//! Make room for the elements of a range whose size is known in advance.
+		template<typename Iterator>
+		void reserveFor(Iterator first, Iterator last, std::forward_iterator_tag) {
+			const size_t required = l.size() + static_cast<size_t>(std::distance(first, last));
+			if(required > l.capacity()) {
+				l.reserve(std::max(required, 2 * l.capacity()));
+			}
+		}
+		template<typename Iterator>
+		void reserveFor(Iterator, Iterator, std::input_iterator_tag) {}
 
 	public:
 		typedef GenericAttributeList attr_t;
 
-		typedef std::deque<std::unique_ptr<GenericAttribute>>::const_iterator const_iterator;
-		typedef std::deque<std::unique_ptr<GenericAttribute>>::iterator iterator;
+		typedef std::vector<GenericAttributeSlot>::const_iterator const_iterator;
+		typedef std::vector<GenericAttributeSlot>::iterator iterator;
 
 		UTILAPI GenericAttributeList();
 		GenericAttributeList(const GenericAttributeList &) = delete;
@@ -582,33 +1224,75 @@ class GenericAttributeList : public GenericAttribute	{
 		GenericAttributeList & operator=(const GenericAttributeList &) = delete;
 		GenericAttributeList & operator=(GenericAttributeList &&) = default;
 
-		void clear()							{	l.clear();			}
-		void push_front(GenericAttribute * attr){	l.emplace_front(attr);	}
-		void push_back(GenericAttribute * attr)	{	l.emplace_back(attr);	}
+		void clear()							{	hash.reset();	l.clear();			}
+		void reserve(size_t count)				{	l.reserve(count);	}
+		size_t capacity() const					{	return l.capacity();	}
+		//! @note The elements are stored contiguously; inserting at the front moves all of them.
+		void push_front(GenericAttribute * attr){	hash.reset();	l.emplace(l.begin(), attr);	}
+		void push_back(GenericAttribute * attr)	{	hash.reset();	l.emplace_back(attr);	}
+		void push_back(GenericAttributeSlot && slot)	{	hash.reset();	l.emplace_back(std::move(slot));	}
+		/**
+		 * Append the elements of the range [first, last); the list takes the
+		 * ownership. The elements are either pointers to GenericAttributes, or
+		 * slots that are moved (e.g. using std::make_move_iterator).
+		 */
+		template<typename Iterator>
+		void push_back(Iterator first, Iterator last) {
+			hash.reset();
+			reserveFor(first, last, typename std::iterator_traits<Iterator>::iterator_category());
+			for(; first != last; ++first) {
+				l.emplace_back(*first);
+			}
+		}
+		//! Append a bool without allocating a GenericAttribute.
+		void pushBackBool(bool value)			{	hash.reset();	l.emplace_back(GenericAttributeSlot::createBool(value));	}
+		//! Append a number; int, unsigned int, float and double do not allocate a GenericAttribute.
+		template<typename Number>
+		typename std::enable_if<std::is_arithmetic<Number>::value && !std::is_same<Number, bool>::value>::type
+		pushBackNumber(Number value)			{	hash.reset();	l.emplace_back(GenericAttributeSlot::createNumber(value));	}
+		//! Append a string; short strings do not allocate a GenericAttribute.
+		void pushBackString(const std::string & value)	{	hash.reset();	l.emplace_back(GenericAttributeSlot::createString(value));	}
 		size_t size() const						{	return l.size();	}
 		bool empty() const						{	return l.empty();	}
+		//! Read-only access to the elements that keeps the cached hash value.
+		const std::vector<GenericAttributeSlot> & getElements() const	{	return l;	}
 
-		iterator begin()						{	return l.begin();	}
+		//! The iterators of a non-const list give access to the attributes; they reset the cached hash value.
+		iterator begin()						{	hash.reset();	return l.begin();	}
+		iterator end()							{	hash.reset();	return l.end();	 }
+		//! The iterators of a const list keep the cached hash value; the attributes must not be modified through them.
 		const_iterator begin()const				{	return l.begin();	}
-		iterator end()							{	return l.end();	 }
 		const_iterator end()const				{	return l.end();	 }
-		GenericAttribute * front()				{	return l.front().get();	}
+		GenericAttribute * front()				{	hash.reset();	return l.front().get();	}
 		const GenericAttribute * front() const	{	return l.front().get();	}
-		GenericAttribute * back()				{	return l.back().get();	}
+		GenericAttribute * back()				{	hash.reset();	return l.back().get();	}
 		const GenericAttribute * back() const	{	return l.back().get();	}
 
-		iterator erase(iterator position)		{	return l.erase(position);	}
-		iterator erase(iterator first,iterator last)		{	return l.erase(first,last);	}
+		iterator erase(iterator position)		{	hash.reset();	return l.erase(position);	}
+		iterator erase(iterator first,iterator last)		{	hash.reset();	return l.erase(first,last);	}
 
 		UTILAPI std::string implode(const std::string & separator)const;
 
 		/**
 		 * Returns the element with given index (or nullptr if none exists).
+		 * As the element may be modified, the cached hash value is reset.
 		 */
-		UTILAPI GenericAttribute * at(int index)const;
+		GenericAttribute * at(int index) {
+			hash.reset();
+			return (index < 0 || static_cast<size_t>(index) >= l.size()) ? nullptr : l[static_cast<size_t>(index)].get();
+		}
+		//! Returns the element with given index (or nullptr if none exists) for reading.
+		const GenericAttribute * at(int index) const {
+			return (index < 0 || static_cast<size_t>(index) >= l.size()) ? nullptr : l[static_cast<size_t>(index)].get();
+		}
+		//! Return the slot with the given index without range check; only the non-const version resets the cached hash value.
+		const GenericAttributeSlot & operator[](size_t index) const	{	return l[index];	}
+		GenericAttributeSlot & operator[](size_t index)				{	hash.reset();	return l[index];	}
 
 		UTILAPI GenericAttributeList * clone() const override;
+		UTILAPI uint64_t getStructuralHash() const override;
 		UTILAPI std::string toJSON() const override;
+		UTILAPI void appendJSON(std::string & out) const override;
 		UTILAPI std::string toString() const override;
 		UTILAPI bool operator==(const GenericAttribute &) const override;
 };
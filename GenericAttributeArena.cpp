@@ -0,0 +1,128 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "GenericAttributeArena.h"
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Util {
+
+static thread_local GenericAttributeArena * activeArena = nullptr;
+
+/*
+ * An attribute remembers whether its memory belongs to an arena. The
+ * constructor of GenericAttribute finds this out from the allocations that
+ * have been taken from an arena but not yet been constructed (more than one,
+ * if an attribute is created in the arguments of another one). The destructor
+ * passes the information on to the deallocation that follows it.
+ */
+static thread_local std::vector<std::pair<std::uintptr_t, std::uintptr_t>> pendingArenaAllocations;
+static thread_local bool destroyedInArena = false;
+
+GenericAttributeArena::Scope::Scope(GenericAttributeArena & arena) : previousArena(activeArena) {
+	activeArena = &arena;
+}
+
+GenericAttributeArena::Scope::~Scope() {
+	activeArena = previousArena;
+}
+
+GenericAttributeArena::HeapScope::HeapScope() : previousArena(activeArena) {
+	activeArena = nullptr;
+}
+
+GenericAttributeArena::HeapScope::~HeapScope() {
+	activeArena = previousArena;
+}
+
+void GenericAttributeArena::BlockDeleter::operator()(char * block) const {
+	::operator delete(block);
+}
+
+GenericAttributeArena::GenericAttributeArena(std::size_t _blockSize) :
+	blockSize(_blockSize), blocks(), cursor(nullptr), available(0), allocatedBytes(0), reservedBytes(0), ownedAttributes() {
+}
+
+GenericAttributeArena::~GenericAttributeArena() {
+	// Run the destructors while the memory is still valid.
+	ownedAttributes.clear();
+}
+
+void * GenericAttributeArena::allocateFromBlock(std::size_t size) {
+	static const std::size_t alignment = alignof(std::max_align_t);
+	size = (size + alignment - 1) & ~(alignment - 1);
+	// Large objects would waste too much of a block.
+	if(size > blockSize / 4) {
+		return nullptr;
+	}
+	if(size > available) {
+		char * block = static_cast<char *>(::operator new(blockSize));
+		blocks.emplace_back(block);
+		cursor = block;
+		available = blockSize;
+		reservedBytes += blockSize;
+	}
+	void * ptr = cursor;
+	cursor += size;
+	available -= size;
+	allocatedBytes += size;
+	return ptr;
+}
+
+void * GenericAttributeArena::allocate(std::size_t size) {
+	if(activeArena != nullptr) {
+		void * ptr = activeArena->allocateFromBlock(size);
+		if(ptr != nullptr) {
+			const auto begin = reinterpret_cast<std::uintptr_t>(ptr);
+			pendingArenaAllocations.emplace_back(begin, begin + size);
+			return ptr;
+		}
+	}
+	return ::operator new(size);
+}
+
+void GenericAttributeArena::deallocate(void * ptr) {
+	if(ptr == nullptr) {
+		return;
+	}
+	// The construction of an attribute in an arena has failed.
+	if(!pendingArenaAllocations.empty() && pendingArenaAllocations.back().first == reinterpret_cast<std::uintptr_t>(ptr)) {
+		pendingArenaAllocations.pop_back();
+		return;
+	}
+	if(destroyedInArena) {
+		destroyedInArena = false;
+		return;
+	}
+	::operator delete(ptr);
+}
+
+bool GenericAttributeArena::takeArenaAllocation(const void * object) {
+	if(pendingArenaAllocations.empty()) {
+		return false;
+	}
+	// The attribute may be a base class of the allocated object.
+	const auto address = reinterpret_cast<std::uintptr_t>(object);
+	const auto & allocation = pendingArenaAllocations.back();
+	if(address < allocation.first || address >= allocation.second) {
+		return false;
+	}
+	pendingArenaAllocations.pop_back();
+	return true;
+}
+
+void GenericAttributeArena::setDestroyedInArena(bool inArena) {
+	destroyedInArena = inArena;
+}
+
+}
@@ -0,0 +1,146 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef UTIL_GENERICATTRIBUTEARENA_H
+#define UTIL_GENERICATTRIBUTEARENA_H
+
+#include "GenericAttribute.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Util {
+
+/**
+ * Monotonic memory for building GenericAttribute trees. While a Scope of the
+ * arena is active in a thread, every GenericAttribute created with @c new in
+ * that thread is placed into the arena. This includes the nodes created by
+ * JSON_Parser::parse, GenericAttributeSerialization::unserialize and clone().
+ * Deleting such an attribute runs its destructor, but does not release its
+ * memory; the arena releases all of its blocks at once when it is destroyed.
+ * Every attribute remembers whether it was placed into an arena, so deleting
+ * it never has to search the arenas, and attributes created outside of an
+ * arena are allocated exactly as before.
+ * Attributes that are created implicitly while existing trees are read or
+ * modified (e.g. when a map stops sharing its elements, see
+ * GenericAttributeMap::cloneShared(), or when a GenericAttributePatch is
+ * applied) are always allocated on the heap, as these trees may outlive the arena.
+ * The ownership of the attributes is unchanged, so they can be stored in
+ * GenericAttributeMap and GenericAttributeList as usual.
+ * @code
+ * GenericAttributeArena arena;
+ * GenericAttribute * tree;
+ * {
+ * 	GenericAttributeArena::Scope scope(arena);
+ * 	tree = arena.own(JSON_Parser::parse(json));
+ * }
+ * // The tree is destroyed together with the arena.
+ * @endcode
+ * @note The destructors of the attributes still run, because strings and
+ * containers inside the attributes keep their buffers on the heap.
+ * Attributes placed into the arena must not be used after the arena
+ * has been destroyed. Attributes that are not owned by the arena must be
+ * deleted before that. An arena must only be active in one thread at a time.
+ * @ingroup generic_attr
+ */
+class GenericAttributeArena {
+	public:
+		/**
+		 * Make the arena the target of the allocations of GenericAttributes
+		 * in the current thread until the scope is left.
+		 * Scopes can be nested.
+		 */
+		class Scope {
+				GenericAttributeArena * previousArena;
+			public:
+				UTILAPI explicit Scope(GenericAttributeArena & arena);
+				UTILAPI ~Scope();
+				Scope(const Scope &) = delete;
+				Scope & operator=(const Scope &) = delete;
+		};
+
+		/**
+		 * (internal) Allocate GenericAttributes on the heap until the scope is
+		 * left, even if an arena is active in the current thread. Used for the
+		 * attributes that are created implicitly inside of existing trees.
+		 */
+		class HeapScope {
+				GenericAttributeArena * previousArena;
+			public:
+				UTILAPI HeapScope();
+				UTILAPI ~HeapScope();
+				HeapScope(const HeapScope &) = delete;
+				HeapScope & operator=(const HeapScope &) = delete;
+		};
+
+		UTILAPI explicit GenericAttributeArena(std::size_t blockSize = 64 * 1024);
+		//! Delete the owned attributes and release all blocks.
+		UTILAPI ~GenericAttributeArena();
+		GenericAttributeArena(const GenericAttributeArena &) = delete;
+		GenericAttributeArena & operator=(const GenericAttributeArena &) = delete;
+
+		/**
+		 * Transfer the ownership of an attribute (e.g. the root of a tree)
+		 * to the arena. It is deleted when the arena is destroyed.
+		 * @return The given attribute
+		 */
+		template<typename attribute_t>
+		attribute_t * own(attribute_t * attribute) {
+			ownedAttributes.emplace_back(attribute);
+			return attribute;
+		}
+
+		//! Number of bytes that have been allocated from the arena.
+		std::size_t getAllocatedBytes() const	{	return allocatedBytes;	}
+		//! Number of bytes of all blocks of the arena.
+		std::size_t getReservedBytes() const	{	return reservedBytes;	}
+
+		/**
+		 * Allocate memory for a GenericAttribute. If an arena is active in the
+		 * current thread, the memory is taken from it; otherwise, it is
+		 * allocated on the heap.
+		 */
+		UTILAPI static void * allocate(std::size_t size);
+		//! Release memory returned by allocate(). Memory of an arena is kept until the arena is destroyed.
+		UTILAPI static void deallocate(void * ptr);
+
+	private:
+		friend class GenericAttribute;
+		/**
+		 * Called by the constructor of GenericAttribute: return true if the
+		 * attribute at @p object is constructed in memory that allocate() has
+		 * just taken from an arena.
+		 */
+		UTILAPI static bool takeArenaAllocation(const void * object);
+		/**
+		 * Called by the destructor of GenericAttribute: tell the following
+		 * deallocate() whether the memory of the destroyed attribute belongs to an arena.
+		 */
+		UTILAPI static void setDestroyedInArena(bool inArena);
+
+		struct BlockDeleter {
+			void operator()(char * block) const;
+		};
+		const std::size_t blockSize;
+		std::vector<std::unique_ptr<char, BlockDeleter>> blocks;
+		char * cursor;
+		std::size_t available;
+		std::size_t allocatedBytes;
+		std::size_t reservedBytes;
+		std::vector<std::unique_ptr<GenericAttribute>> ownedAttributes;
+
+		//! Return nullptr if the size is too large for the blocks.
+		void * allocateFromBlock(std::size_t size);
+};
+
+}
+
+#endif /* UTIL_GENERICATTRIBUTEARENA_H */
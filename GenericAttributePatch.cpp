@@ -0,0 +1,169 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "GenericAttributePatch.h"
+#include "GenericAttributeArena.h"
+#include "StringUtils.h"
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace Util {
+
+GenericAttributePatch::GenericAttributePatch() : GenericAttribute(), operations() {
+}
+
+GenericAttributePatch::GenericAttributePatch(const GenericAttributeMap & from, const GenericAttributeMap & to) :
+		GenericAttribute(), operations() {
+	addDifferences(from, to, GenericAttributePath());
+}
+
+GenericAttributePatch::~GenericAttributePatch() = default;
+
+//! Return the path of the element with the given key in the map at @p prefix.
+static GenericAttributePath getElementPath(const GenericAttributePath & prefix, const StringIdentifier & key) {
+	GenericAttributePath path(prefix);
+	path.appendKey(key);
+	return path;
+}
+
+void GenericAttributePatch::addDifferences(const GenericAttributeMap & from, const GenericAttributeMap & to, const GenericAttributePath & prefix) {
+	// Maps sharing their elements are equal.
+	if(from.data == to.data) {
+		return;
+	}
+	for(const auto & element : from.getElements()) {
+		if(!element.second) {
+			continue;
+		}
+		const GenericAttributeSlot * toSlot = to.findSlot(element.first);
+		if(toSlot == nullptr) {
+			addOperation(OperationType::UNSET, getElementPath(prefix, element.first));
+		} else if(element.second.getKind() == GenericAttributeKind::MAP && toSlot->getKind() == GenericAttributeKind::MAP) {
+			addDifferences(*static_cast<const GenericAttributeMap *>(element.second.get()),
+						   *static_cast<const GenericAttributeMap *>(toSlot->get()),
+						   getElementPath(prefix, element.first));
+		} else if(!element.second.isEqual(*toSlot)) {
+			addOperation(OperationType::REPLACE, getElementPath(prefix, element.first), toSlot->clone());
+		}
+	}
+	for(const auto & element : to.getElements()) {
+		if(element.second && from.findSlot(element.first) == nullptr) {
+			addOperation(OperationType::SET, getElementPath(prefix, element.first), element.second.clone());
+		}
+	}
+}
+
+void GenericAttributePatch::applyTo(GenericAttributeMap & target) const {
+	// The target may be outside of the active arena.
+	GenericAttributeArena::HeapScope heapScope;
+	for(const auto & operation : operations) {
+		const auto & steps = operation.path.getSteps();
+		if(steps.empty() || steps.back().isIndex) {
+			throw std::logic_error("GenericAttributePatch: Invalid path \"" + operation.path.toString() + "\".");
+		}
+		GenericAttributeMap * map = &target;
+		for(std::size_t i = 0; i + 1 < steps.size(); ++i) {
+			GenericAttribute * child = steps[i].isIndex ? nullptr : map->getValue(steps[i].key);
+			map = child == nullptr ? nullptr : child->toType<GenericAttributeMap>();
+			if(map == nullptr) {
+				throw std::logic_error("GenericAttributePatch: No map on the path \"" + operation.path.toString() + "\".");
+			}
+		}
+		if(operation.type == OperationType::UNSET) {
+			map->unsetValue(steps.back().key);
+		} else {
+			map->setValue(steps.back().key, operation.value.clone());
+		}
+	}
+}
+
+const char * GenericAttributePatch::getOperationName(OperationType type) {
+	switch(type) {
+		case OperationType::SET:
+			return "set";
+		case OperationType::UNSET:
+			return "unset";
+		default:
+			return "replace";
+	}
+}
+
+GenericAttributePatch::OperationType GenericAttributePatch::getOperationType(const std::string & name) {
+	if(name == "set") {
+		return OperationType::SET;
+	} else if(name == "unset") {
+		return OperationType::UNSET;
+	} else if(name == "replace") {
+		return OperationType::REPLACE;
+	}
+	throw std::invalid_argument("GenericAttributePatch: Unknown operation \"" + name + "\".");
+}
+
+GenericAttributePatch * GenericAttributePatch::clone() const {
+	auto patchClone = new GenericAttributePatch;
+	patchClone->operations.reserve(operations.size());
+	for(const auto & operation : operations) {
+		patchClone->addOperation(operation.type, operation.path, operation.value ? operation.value.clone() : GenericAttributeSlot());
+	}
+	return patchClone;
+}
+
+std::string GenericAttributePatch::toString() const {
+	std::ostringstream s;
+	s << "Patch [\n";
+	for(const auto & operation : operations) {
+		s << '\t' << getOperationName(operation.type) << " \"" << operation.path.toString() << '"';
+		if(operation.value) {
+			s << " : " << StringUtils::replaceAll(StringUtils::trim(operation.value.toString()), "\n", "\n\t");
+		}
+		s << '\n';
+	}
+	s << "]\n";
+	return s.str();
+}
+
+static bool isEqualPath(const GenericAttributePath & first, const GenericAttributePath & second) {
+	if(first.size() != second.size()) {
+		return false;
+	}
+	for(std::size_t i = 0; i < first.size(); ++i) {
+		const auto & step = first.getSteps()[i];
+		const auto & otherStep = second.getSteps()[i];
+		if(step.isIndex != otherStep.isIndex || step.index != otherStep.index || step.key != otherStep.key) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GenericAttributePatch::operator==(const GenericAttribute & other) const {
+	const attr_t * otherPatch = other.toType<const attr_t>();
+	if(otherPatch == nullptr || operations.size() != otherPatch->operations.size()) {
+		return false;
+	}
+	for(std::size_t i = 0; i < operations.size(); ++i) {
+		const Operation & operation = operations[i];
+		const Operation & otherOperation = otherPatch->operations[i];
+		if(operation.type != otherOperation.type || !isEqualPath(operation.path, otherOperation.path)) {
+			return false;
+		}
+		if(!operation.value && !otherOperation.value) {
+			continue;
+		}
+		if(!operation.value || !otherOperation.value || !operation.value.isEqual(otherOperation.value)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,108 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef UTIL_GENERICATTRIBUTEPATCH_H
+#define UTIL_GENERICATTRIBUTEPATCH_H
+
+#include "GenericAttribute.h"
+#include "GenericAttributePath.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Util {
+
+/**
+ * Difference between two GenericAttributeMaps as a list of operations. Each
+ * operation sets, replaces or removes the element at a path of map keys.
+ * Nested maps are compared recursively, so that a change deep inside a tree
+ * only results in one operation. Maps that share their elements (see
+ * GenericAttributeMap::cloneShared()) are known to be equal without comparing
+ * them; therefore, computing the patch between a snapshot created with
+ * cloneShared() and the modified map only visits the modified parts.
+ * The patch is a GenericAttribute and can be serialized with
+ * GenericAttributeSerialization.
+ * @code
+ * std::unique_ptr<GenericAttributeMap> snapshot(state.cloneShared());
+ * // ... modify state ...
+ * const GenericAttributePatch patch(*snapshot, state);
+ * send(GenericAttributeSerialization::serialize(&patch));
+ * // on the remote side:
+ * std::unique_ptr<GenericAttribute> received(GenericAttributeSerialization::unserialize(message));
+ * received->toType<GenericAttributePatch>()->applyTo(remoteState);
+ * @endcode
+ * @ingroup generic_attr
+ */
+class GenericAttributePatch : public GenericAttribute {
+	public:
+		typedef GenericAttributePatch attr_t;
+
+		enum class OperationType : uint8_t {
+			//! Add an element that did not exist
+			SET,
+			//! Remove an element
+			UNSET,
+			//! Replace the value of an existing element
+			REPLACE
+		};
+		struct Operation {
+			OperationType type;
+			//! Keys leading from the root map to the element
+			GenericAttributePath path;
+			//! New value; empty for UNSET
+			GenericAttributeSlot value;
+		};
+
+		//! Create an empty patch.
+		UTILAPI GenericAttributePatch();
+		//! Create the patch that transforms @p from into @p to.
+		UTILAPI GenericAttributePatch(const GenericAttributeMap & from, const GenericAttributeMap & to);
+		GenericAttributePatch(GenericAttributePatch &&) = default;
+		GenericAttributePatch & operator=(GenericAttributePatch &&) = default;
+		UTILAPI virtual ~GenericAttributePatch();
+
+		//! Append an operation; the patch takes the ownership of the value.
+		void addOperation(OperationType type, GenericAttributePath path, GenericAttributeSlot && value = GenericAttributeSlot()) {
+			operations.push_back(Operation{type, std::move(path), std::move(value)});
+		}
+		const std::vector<Operation> & getOperations() const	{	return operations;	}
+		std::size_t size() const								{	return operations.size();	}
+		bool empty() const										{	return operations.empty();	}
+
+		/**
+		 * Perform the operations on @p target. SET and REPLACE both store a
+		 * copy of the value, and UNSET ignores missing elements.
+		 * @throw std::logic_error if a map on the path of an operation does
+		 * not exist in @p target. The preceding operations remain applied.
+		 */
+		UTILAPI void applyTo(GenericAttributeMap & target) const;
+
+		//! Return the name of an operation type ("set", "unset" or "replace").
+		UTILAPI static const char * getOperationName(OperationType type);
+		/**
+		 * Return the operation type with the given name.
+		 * @throw std::invalid_argument if the name is unknown
+		 */
+		UTILAPI static OperationType getOperationType(const std::string & name);
+
+		UTILAPI GenericAttributePatch * clone() const override;
+		UTILAPI std::string toString() const override;
+		UTILAPI bool operator==(const GenericAttribute & other) const override;
+
+	private:
+		std::vector<Operation> operations;
+
+		void addDifferences(const GenericAttributeMap & from, const GenericAttributeMap & to, const GenericAttributePath & prefix);
+};
+
+}
+
+#endif /* UTIL_GENERICATTRIBUTEPATCH_H */
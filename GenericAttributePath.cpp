@@ -0,0 +1,186 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "GenericAttributePath.h"
+#include <limits>
+#include <stdexcept>
+
+namespace Util {
+
+GenericAttributePath::GenericAttributePath(const std::string & path) : steps() {
+	const std::size_t length = path.size();
+	std::size_t pos = 0;
+	while(pos != length) {
+		if(path[pos] == '[') {
+			const std::size_t close = path.find(']', pos);
+			if(close == std::string::npos || close == pos + 1) {
+				throw std::invalid_argument("GenericAttributePath: Invalid index in \"" + path + "\".");
+			}
+			std::size_t index = 0;
+			for(std::size_t i = pos + 1; i != close; ++i) {
+				const char c = path[i];
+				if(c < '0' || c > '9' || index > (std::numeric_limits<std::size_t>::max() - 9) / 10) {
+					throw std::invalid_argument("GenericAttributePath: Invalid index in \"" + path + "\".");
+				}
+				index = index * 10 + static_cast<std::size_t>(c - '0');
+			}
+			appendIndex(index);
+			pos = close + 1;
+		} else {
+			std::size_t end = path.find_first_of(".[]", pos);
+			if(end == std::string::npos) {
+				end = length;
+			}
+			if(end == pos || (end != length && path[end] == ']')) {
+				throw std::invalid_argument("GenericAttributePath: Invalid key in \"" + path + "\".");
+			}
+			appendKey(StringIdentifier(path.data() + pos, end - pos));
+			pos = end;
+		}
+		if(pos != length && path[pos] == '.') {
+			++pos;
+			if(pos == length || path[pos] == '[') {
+				throw std::invalid_argument("GenericAttributePath: Missing key in \"" + path + "\".");
+			}
+		}
+	}
+}
+
+std::string GenericAttributePath::toString() const {
+	std::string result;
+	for(const auto & step : steps) {
+		if(step.isIndex) {
+			result += '[';
+			result += std::to_string(step.index);
+			result += ']';
+		} else {
+			if(!result.empty()) {
+				result += '.';
+			}
+			result += step.key.toString();
+		}
+	}
+	return result;
+}
+
+const GenericAttributeSlot * GenericAttributePath::findChild(const GenericAttribute * container, const Step & step) {
+	if(container == nullptr) {
+		return nullptr;
+	}
+	if(step.isIndex) {
+		auto list = container->toType<const GenericAttributeList>();
+		if(list == nullptr || step.index >= list->size()) {
+			return nullptr;
+		}
+		const GenericAttributeSlot & slot = list->getElements()[step.index];
+		return slot ? &slot : nullptr;
+	}
+	auto map = container->toType<const GenericAttributeMap>();
+	return map == nullptr ? nullptr : map->findSlot(step.key);
+}
+
+const GenericAttribute * GenericAttributePath::getContainer(const GenericAttributeSlot & slot) {
+	// Maps and lists are never stored inline; get() does not convert anything.
+	const GenericAttributeKind kind = slot.getKind();
+	return (kind == GenericAttributeKind::MAP || kind == GenericAttributeKind::LIST) ? slot.get() : nullptr;
+}
+
+const GenericAttributeSlot * GenericAttributePath::findSlot(const GenericAttribute * root) const {
+	const GenericAttributeSlot * slot = nullptr;
+	const GenericAttribute * container = root;
+	for(const auto & step : steps) {
+		if(container == nullptr) {
+			return nullptr;
+		}
+		slot = findChild(container, step);
+		if(slot == nullptr) {
+			return nullptr;
+		}
+		container = getContainer(*slot);
+	}
+	return slot;
+}
+
+GenericAttribute * GenericAttributePath::getValue(GenericAttribute * root) const {
+	if(steps.empty()) {
+		return nullptr;
+	}
+	GenericAttribute * attribute = root;
+	for(const auto & step : steps) {
+		if(attribute == nullptr) {
+			return nullptr;
+		}
+		if(step.isIndex) {
+			auto list = attribute->toType<GenericAttributeList>();
+			attribute = (list == nullptr || step.index >= list->size()) ? nullptr : (*list)[step.index].get();
+		} else {
+			auto map = attribute->toType<GenericAttributeMap>();
+			attribute = map == nullptr ? nullptr : map->getValue(step.key);
+		}
+	}
+	return attribute;
+}
+
+std::size_t GenericAttributePathQuery::addPath(const GenericAttributePath & path) {
+	const std::size_t pathIndex = pathCount++;
+	if(path.empty()) {
+		return pathIndex;
+	}
+	std::vector<std::size_t> * siblings = &rootNodes;
+	std::size_t nodeIndex = 0;
+	for(const auto & step : path.getSteps()) {
+		std::size_t found = nodes.size();
+		for(const auto & sibling : *siblings) {
+			const auto & siblingStep = nodes[sibling].step;
+			if(siblingStep.isIndex == step.isIndex && siblingStep.index == step.index && siblingStep.key == step.key) {
+				found = sibling;
+				break;
+			}
+		}
+		if(found == nodes.size()) {
+			siblings->push_back(found);
+			nodes.push_back(Node{step, {}, {}});
+		}
+		nodeIndex = found;
+		siblings = &nodes[nodeIndex].children;
+	}
+	nodes[nodeIndex].paths.push_back(pathIndex);
+	return pathIndex;
+}
+
+void GenericAttributePathQuery::resolveNodes(const GenericAttribute * container, const std::vector<std::size_t> & nodeIndices,
+											 std::vector<const GenericAttributeSlot *> & results) const {
+	for(const auto & nodeIndex : nodeIndices) {
+		const Node & node = nodes[nodeIndex];
+		const GenericAttributeSlot * slot = GenericAttributePath::findChild(container, node.step);
+		if(slot == nullptr) {
+			continue;
+		}
+		for(const auto & pathIndex : node.paths) {
+			results[pathIndex] = slot;
+		}
+		if(!node.children.empty()) {
+			const GenericAttribute * child = GenericAttributePath::getContainer(*slot);
+			if(child != nullptr) {
+				resolveNodes(child, node.children, results);
+			}
+		}
+	}
+}
+
+void GenericAttributePathQuery::resolve(const GenericAttribute * root, std::vector<const GenericAttributeSlot *> & results) const {
+	results.assign(pathCount, nullptr);
+	if(root != nullptr) {
+		resolveNodes(root, rootNodes, results);
+	}
+}
+
+}
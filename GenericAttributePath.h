@@ -0,0 +1,179 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef UTIL_GENERICATTRIBUTEPATH_H
+#define UTIL_GENERICATTRIBUTEPATH_H
+
+#include "GenericAttribute.h"
+#include "StringIdentifier.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Util {
+
+/**
+ * Compiled path to an element of a tree of GenericAttributeMaps and
+ * GenericAttributeLists. The keys are converted into StringIdentifiers once
+ * when the path is created, so that resolving the path only compares numbers
+ * and checks the kinds of the containers.
+ * @code
+ * static const GenericAttributePath biasPath("render.shadow.bias");
+ * const float bias = biasPath.getFloat(config, 0.005f);
+ * static const GenericAttributePath colorPath("lights[2].color");
+ * @endcode
+ * @ingroup generic_attr
+ */
+class GenericAttributePath {
+	public:
+		//! Element of a path: a key in a map, or an index in a list
+		struct Step {
+			StringIdentifier key;
+			std::size_t index;
+			bool isIndex;
+		};
+
+		//! Create an empty path, which does not refer to any element.
+		GenericAttributePath() : steps() {}
+		/**
+		 * Compile a path given as keys separated by dots, and list indices in
+		 * brackets (e.g. "render.shadow.bias" or "lights[2].color").
+		 * @throw std::invalid_argument if the path is malformed
+		 */
+		UTILAPI explicit GenericAttributePath(const std::string & path);
+
+		GenericAttributePath & appendKey(const StringIdentifier & key) {
+			steps.push_back(Step{key, 0, false});
+			return *this;
+		}
+		GenericAttributePath & appendIndex(std::size_t index) {
+			steps.push_back(Step{StringIdentifier(), index, true});
+			return *this;
+		}
+
+		const std::vector<Step> & getSteps() const	{	return steps;	}
+		std::size_t size() const					{	return steps.size();	}
+		bool empty() const							{	return steps.empty();	}
+		//! Return the path in the form accepted by the constructor.
+		UTILAPI std::string toString() const;
+
+		/**
+		 * Return the element the path refers to, or nullptr if there is none.
+		 * Like the scalar getters of GenericAttributeMap, this neither copies
+		 * shared elements nor converts inline values.
+		 * @note The returned slot must not be used to modify the element.
+		 */
+		UTILAPI const GenericAttributeSlot * findSlot(const GenericAttribute * root) const;
+		/**
+		 * Return the attribute the path refers to, or nullptr if there is none.
+		 * Like GenericAttributeMap::getValue(), the maps along the path stop
+		 * sharing their elements, so that the attribute may be modified.
+		 */
+		UTILAPI GenericAttribute * getValue(GenericAttribute * root) const;
+		template<typename T>
+		T * getValue(GenericAttribute * root) const {
+			GenericAttribute * attribute = getValue(root);
+			return attribute == nullptr ? nullptr : attribute->toType<T>();
+		}
+
+		/**
+		 * @name Typed access
+		 * Return the converted value of the element, or the default value if
+		 * the path does not refer to an element.
+		 */
+		//@{
+		bool getBool(const GenericAttribute * root, bool defaultValue = false) const {
+			const GenericAttributeSlot * slot = findSlot(root);
+			return slot == nullptr ? defaultValue : slot->toBool();
+		}
+		double getDouble(const GenericAttribute * root, double defaultValue = 0.0) const {
+			const GenericAttributeSlot * slot = findSlot(root);
+			return slot == nullptr ? defaultValue : slot->toDouble();
+		}
+		float getFloat(const GenericAttribute * root, float defaultValue = 0.0f) const {
+			const GenericAttributeSlot * slot = findSlot(root);
+			return slot == nullptr ? defaultValue : slot->toFloat();
+		}
+		int getInt(const GenericAttribute * root, int defaultValue = 0) const {
+			const GenericAttributeSlot * slot = findSlot(root);
+			return slot == nullptr ? defaultValue : slot->toInt();
+		}
+		unsigned int getUInt(const GenericAttribute * root, unsigned int defaultValue = 0) const {
+			const GenericAttributeSlot * slot = findSlot(root);
+			return slot == nullptr ? defaultValue : slot->toUnsignedInt();
+		}
+		std::string getString(const GenericAttribute * root, const std::string & defaultValue = "") const {
+			const GenericAttributeSlot * slot = findSlot(root);
+			return slot == nullptr ? defaultValue : slot->toString();
+		}
+		//@}
+
+	private:
+		std::vector<Step> steps;
+
+		friend class GenericAttributePathQuery;
+		//! Return the element of the map or list @p container addressed by @p step, or nullptr.
+		UTILAPI static const GenericAttributeSlot * findChild(const GenericAttribute * container, const Step & step);
+		//! Return the map or list stored in the slot, or nullptr.
+		UTILAPI static const GenericAttribute * getContainer(const GenericAttributeSlot & slot);
+};
+
+/**
+ * Set of GenericAttributePaths that are resolved together from the same root.
+ * Paths with a common prefix share the lookups of that prefix, so that every
+ * container along the paths is visited only once.
+ * @code
+ * GenericAttributePathQuery query;
+ * const std::size_t bias = query.addPath(GenericAttributePath("render.shadow.bias"));
+ * const std::size_t size = query.addPath(GenericAttributePath("render.shadow.size"));
+ * std::vector<const GenericAttributeSlot *> results;
+ * query.resolve(config, results);
+ * if(results[bias] != nullptr) { ... results[bias]->toFloat() ... }
+ * @endcode
+ * @ingroup generic_attr
+ */
+class GenericAttributePathQuery {
+	public:
+		GenericAttributePathQuery() : nodes(), rootNodes(), pathCount(0) {}
+
+		/**
+		 * Add a path to the query.
+		 * @return Index of the result of the path
+		 */
+		UTILAPI std::size_t addPath(const GenericAttributePath & path);
+		std::size_t getPathCount() const		{	return pathCount;	}
+
+		/**
+		 * Resolve all paths in one traversal of the tree.
+		 * @param results Is resized to the number of paths. The entry with the
+		 * index returned by addPath() contains the element of that path, or
+		 * nullptr if there is none (see GenericAttributePath::findSlot()).
+		 */
+		UTILAPI void resolve(const GenericAttribute * root, std::vector<const GenericAttributeSlot *> & results) const;
+
+	private:
+		struct Node {
+			GenericAttributePath::Step step;
+			//! Indices of the paths that end at this node
+			std::vector<std::size_t> paths;
+			std::vector<std::size_t> children;
+		};
+		std::vector<Node> nodes;
+		std::vector<std::size_t> rootNodes;
+		std::size_t pathCount;
+
+		void resolveNodes(const GenericAttribute * container, const std::vector<std::size_t> & nodeIndices,
+						  std::vector<const GenericAttributeSlot *> & results) const;
+};
+
+}
+
+#endif /* UTIL_GENERICATTRIBUTEPATH_H */
@@ -9,18 +9,26 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "GenericAttributeSerialization.h"
+#include "Encoding.h"
 #include "Factory/WrapperFactory.h"
 #include "GenericAttribute.h"
+#include "GenericAttributePatch.h"
 #include "JSON_Parser.h"
 #include "StringIdentifier.h"
 #include "StringUtils.h"
+#include "StringView.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <typeindex>
+#include <type_traits>
 #include <typeinfo>
 #include <utility>
+#include <vector>
 
 namespace Util {
 
@@ -35,7 +43,7 @@ GenericAttributeSerialization::unserializer_factory_t & GenericAttributeSerializ
 
 static const std::string GATypeNameBool = "bool";
 static GenericAttributeSerialization::serializer_type_t serializeGABool(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
-	auto boolAttribute = dynamic_cast<const BoolAttribute *>(attributeAndContext.first);
+	auto boolAttribute = attributeAndContext.first->toType<const BoolAttribute>();
 	const std::string content = boolAttribute->get() ? "true" : "false";
 	return std::make_pair(GATypeNameBool, content);
 }
@@ -54,62 +62,61 @@ template<> const std::string getGATypeName<int>()				{return "numberInt";}
 template<> const std::string getGATypeName<unsigned int>()	{return "numberUInt";}
 template<> const std::string getGATypeName<long>()			{return "numberLong";}
 template<> const std::string getGATypeName<unsigned long>()	{return "numberULong";}
+template<> const std::string getGATypeName<long long>()		{return "numberLongLong";}
+template<> const std::string getGATypeName<unsigned long long>()	{return "numberULongLong";}
 template<> const std::string getGATypeName<short>()			{return "numberShort";}
 template<> const std::string getGATypeName<unsigned short>()	{return "numberUShort";}
 
 template<typename NumberType>
 static GenericAttributeSerialization::serializer_type_t serializeGANumber(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
-	auto numberAttribute = dynamic_cast<const _NumberAttribute<NumberType> *>(attributeAndContext.first);
-	std::ostringstream stream;
-	stream << numberAttribute->get();
-	return std::make_pair( getGATypeName<NumberType>() , stream.str());
+	auto numberAttribute = attributeAndContext.first->toType<const _NumberAttribute<NumberType>>();
+	return std::make_pair( getGATypeName<NumberType>() , StringUtils::toString(numberAttribute->get()));
 }
 template<typename NumberType>
 static _NumberAttribute<NumberType> * unserializeGANumber(const GenericAttributeSerialization::unserializer_parameter_t & contentAndContext) {
-	NumberType number;
-	std::istringstream stream(contentAndContext.first);
-	stream >> number;
-	return new _NumberAttribute<NumberType>(number);
+	return new _NumberAttribute<NumberType>(StringUtils::toNumber<NumberType>(contentAndContext.first));
 }
 
 template<> const std::string getGATypeName<char>()			{return "numberByte";}
 // Make sure that the character is converted to a number
 template<>
 GenericAttributeSerialization::serializer_type_t serializeGANumber<char>(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
-	auto numberAttribute = dynamic_cast<const _NumberAttribute<char> *>(attributeAndContext.first);
-	std::ostringstream stream;
-	stream << static_cast<short>(numberAttribute->get());
-	return std::make_pair(getGATypeName<char>(), stream.str());
+	auto numberAttribute = attributeAndContext.first->toType<const _NumberAttribute<char>>();
+	return std::make_pair(getGATypeName<char>(), StringUtils::toString(static_cast<short>(numberAttribute->get())));
 }
 template<>
 _NumberAttribute<char> * unserializeGANumber<char>(const GenericAttributeSerialization::unserializer_parameter_t & contentAndContext) {
-	short number;
-	std::istringstream stream(contentAndContext.first);
-	stream >> number;
-	return new _NumberAttribute<char>(number);
+	return new _NumberAttribute<char>(static_cast<char>(StringUtils::toNumber<short>(contentAndContext.first)));
+}
+
+template<> const std::string getGATypeName<signed char>()	{return "numberSByte";}
+// Make sure that the signed character is converted to a number
+template<>
+GenericAttributeSerialization::serializer_type_t serializeGANumber<signed char>(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
+	auto numberAttribute = attributeAndContext.first->toType<const _NumberAttribute<signed char>>();
+	return std::make_pair(getGATypeName<signed char>(), StringUtils::toString(static_cast<short>(numberAttribute->get())));
+}
+template<>
+_NumberAttribute<signed char> * unserializeGANumber<signed char>(const GenericAttributeSerialization::unserializer_parameter_t & contentAndContext) {
+	return new _NumberAttribute<signed char>(static_cast<signed char>(StringUtils::toNumber<short>(contentAndContext.first)));
 }
 
 template<> const std::string getGATypeName<unsigned char>()	{return "numberUByte";}
 // Make sure that the unsigned character is converted to a number
 template<>
 GenericAttributeSerialization::serializer_type_t serializeGANumber<unsigned char>(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
-	auto numberAttribute = dynamic_cast<const _NumberAttribute<unsigned char> *>(attributeAndContext.first);
-	std::ostringstream stream;
-	stream << static_cast<unsigned short>(numberAttribute->get());
-	return std::make_pair(getGATypeName<unsigned char>(), stream.str());
+	auto numberAttribute = attributeAndContext.first->toType<const _NumberAttribute<unsigned char>>();
+	return std::make_pair(getGATypeName<unsigned char>(), StringUtils::toString(static_cast<unsigned short>(numberAttribute->get())));
 }
 template<>
 _NumberAttribute<unsigned char> * unserializeGANumber<unsigned char>(const GenericAttributeSerialization::unserializer_parameter_t & contentAndContext) {
-	unsigned short number;
-	std::istringstream stream(contentAndContext.first);
-	stream >> number;
-	return new _NumberAttribute<unsigned char>(number);
+	return new _NumberAttribute<unsigned char>(static_cast<unsigned char>(StringUtils::toNumber<unsigned short>(contentAndContext.first)));
 }
 
 template<> const std::string getGATypeName<std::string>()	{return "string";}
 template<typename StringType>
 GenericAttributeSerialization::serializer_type_t serializeGAString(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
-	auto stringAttribute = dynamic_cast<const _StringAttribute<StringType> *>(attributeAndContext.first);
+	auto stringAttribute = attributeAndContext.first->toType<const _StringAttribute<StringType>>();
 	std::ostringstream stream;
 	stream << stringAttribute->get();
 	return std::make_pair(getGATypeName<StringType>(), stream.str());
@@ -119,9 +126,60 @@ StringAttribute * unserializeGAString(const GenericAttributeSerialization::unser
 	return new _StringAttribute<StringType>(contentAndContext.first);
 }
 
+template<typename> static const std::string getGANumberArrayTypeName();
+template<> const std::string getGANumberArrayTypeName<double>()			{return "numberArrayDouble";}
+template<> const std::string getGANumberArrayTypeName<float>()			{return "numberArrayFloat";}
+template<> const std::string getGANumberArrayTypeName<int>()			{return "numberArrayInt";}
+template<> const std::string getGANumberArrayTypeName<unsigned int>()	{return "numberArrayUInt";}
+template<> const std::string getGANumberArrayTypeName<short>()			{return "numberArrayShort";}
+template<> const std::string getGANumberArrayTypeName<unsigned short>()	{return "numberArrayUShort";}
+template<> const std::string getGANumberArrayTypeName<signed char>()	{return "numberArrayByte";}
+template<> const std::string getGANumberArrayTypeName<unsigned char>()	{return "numberArrayUByte";}
+
+static bool isLittleEndian() {
+	const uint16_t one = 1;
+	uint8_t firstByte;
+	std::memcpy(&firstByte, &one, 1);
+	return firstByte == 1;
+}
+
+//! Convert numbers between the byte order of the machine and little-endian (in both directions).
+template<typename NumberType>
+static void swapToLittleEndian(std::vector<uint8_t> & bytes) {
+	if(sizeof(NumberType) == 1 || isLittleEndian()) {
+		return;
+	}
+	for(std::size_t offset = 0; offset < bytes.size(); offset += sizeof(NumberType)) {
+		std::reverse(bytes.begin() + offset, bytes.begin() + offset + sizeof(NumberType));
+	}
+}
+
+// The numbers are stored as Base64 encoded block of memory in little-endian byte order, like in the binary format.
+template<typename NumberType>
+static GenericAttributeSerialization::serializer_type_t serializeGANumberArray(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
+	const auto & numbers = attributeAndContext.first->toType<const NumberArrayAttribute<NumberType>>()->get();
+	const uint8_t * data = reinterpret_cast<const uint8_t *>(numbers.data());
+	std::vector<uint8_t> bytes(data, data + numbers.size() * sizeof(NumberType));
+	swapToLittleEndian<NumberType>(bytes);
+	return std::make_pair(getGANumberArrayTypeName<NumberType>(), encodeBase64(bytes));
+}
+template<typename NumberType>
+static NumberArrayAttribute<NumberType> * unserializeGANumberArray(const GenericAttributeSerialization::unserializer_parameter_t & contentAndContext) {
+	std::vector<uint8_t> bytes = decodeBase64(contentAndContext.first);
+	if(bytes.size() % sizeof(NumberType) != 0) {
+		throw std::logic_error("Invalid number array representation: Size is not a multiple of the element size");
+	}
+	swapToLittleEndian<NumberType>(bytes);
+	std::vector<NumberType> numbers(bytes.size() / sizeof(NumberType));
+	if(!bytes.empty()) {
+		std::memcpy(numbers.data(), bytes.data(), bytes.size());
+	}
+	return new NumberArrayAttribute<NumberType>(std::move(numbers));
+}
+
 static const std::string GATypeNameList = "list";
 static GenericAttributeSerialization::serializer_type_t serializeGAList(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
-	auto listAttribute = dynamic_cast<const GenericAttributeList *>(attributeAndContext.first);
+	auto listAttribute = attributeAndContext.first->toType<const GenericAttributeList>();
 	std::ostringstream stream;
 	stream << '[';
 	for(auto it = listAttribute->begin(); it != listAttribute->end(); ++it) {
@@ -140,6 +198,7 @@ static GenericAttributeList * unserializeGAList(const GenericAttributeSerializat
 		throw std::logic_error("Invalid JSON representation: List expected");
 	}
 	auto list = new GenericAttributeList;
+	list->reserve(objectList->size());
 	for(auto & elem : *objectList) {
 		list->push_back(GenericAttributeSerialization::unserialize(elem->toString()));
 	}
@@ -148,11 +207,12 @@ static GenericAttributeList * unserializeGAList(const GenericAttributeSerializat
 
 static const std::string GATypeNameMap = "map";
 static GenericAttributeSerialization::serializer_type_t serializeGAMap(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
-	auto mapAttribute = dynamic_cast<const GenericAttributeMap *>(attributeAndContext.first);
+	auto mapAttribute = attributeAndContext.first->toType<const GenericAttributeMap>();
 	std::ostringstream stream;
 	stream << '{';
-	for(auto it = mapAttribute->begin(); it != mapAttribute->end(); ++it) {
-		if(it != mapAttribute->begin()) {
+	const auto & elements = mapAttribute->getElements();
+	for(auto it = elements.begin(); it != elements.end(); ++it) {
+		if(it != elements.begin()) {
 			stream << ',';
 		}
 		stream << '"' << it->first.toString() << "\":\"" << StringUtils::escape(GenericAttributeSerialization::serialize(it->second.get())) << '"';
@@ -173,23 +233,122 @@ static GenericAttributeMap * unserializeGAMap(const GenericAttributeSerializatio
 	return map;
 }
 
+// [{"op":"set","path":["key","nestedKey"],"value":"[serialized value]"}, ...]
+static const std::string GATypeNamePatch = "patch";
+static GenericAttributeSerialization::serializer_type_t serializeGAPatch(const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
+	auto patch = attributeAndContext.first->toType<const GenericAttributePatch>();
+	std::ostringstream stream;
+	stream << '[';
+	bool firstOperation = true;
+	for(const auto & operation : patch->getOperations()) {
+		if(!firstOperation) {
+			stream << ',';
+		}
+		firstOperation = false;
+		stream << "{\"op\":\"" << GenericAttributePatch::getOperationName(operation.type) << "\",\"path\":[";
+		bool firstKey = true;
+		for(const auto & step : operation.path.getSteps()) {
+			if(!firstKey) {
+				stream << ',';
+			}
+			firstKey = false;
+			stream << '"' << StringUtils::escape(step.key.toString()) << '"';
+		}
+		stream << ']';
+		if(operation.value) {
+			stream << ",\"value\":\"" << StringUtils::escape(GenericAttributeSerialization::serialize(operation.value.get(), attributeAndContext.second)) << '"';
+		}
+		stream << '}';
+	}
+	stream << ']';
+	return std::make_pair(GATypeNamePatch, stream.str());
+}
+static GenericAttributePatch * unserializeGAPatch(const GenericAttributeSerialization::unserializer_parameter_t & contentAndContext) {
+	std::unique_ptr<GenericAttribute> JSONObject(JSON_Parser::parse(contentAndContext.first));
+	auto operationList = JSONObject ? JSONObject->toType<GenericAttributeList>() : nullptr;
+	if(operationList == nullptr) {
+		throw std::logic_error("Invalid JSON representation: List expected");
+	}
+	static const StringIdentifier OP("op");
+	static const StringIdentifier PATH("path");
+	static const StringIdentifier VALUE("value");
+	std::unique_ptr<GenericAttributePatch> patch(new GenericAttributePatch);
+	for(auto & element : *operationList) {
+		auto operationMap = element->toType<GenericAttributeMap>();
+		auto pathList = operationMap == nullptr ? nullptr : operationMap->getValue<GenericAttributeList>(PATH);
+		if(pathList == nullptr) {
+			throw std::logic_error("Invalid JSON representation: Operation expected");
+		}
+		GenericAttributePath path;
+		for(const auto & key : *pathList) {
+			path.appendKey(StringIdentifier(key.toString()));
+		}
+		GenericAttributeSlot value;
+		if(operationMap->contains(VALUE)) {
+			value.reset(GenericAttributeSerialization::unserialize(operationMap->getString(VALUE), contentAndContext.second));
+		}
+		patch->addOperation(GenericAttributePatch::getOperationType(operationMap->getString(OP)), std::move(path), std::move(value));
+	}
+	return patch.release();
+}
+
+typedef GenericAttributeSerialization::serializer_type_t (*builtInSerializer_t)(const GenericAttributeSerialization::serializer_parameter_t &);
+//! Serializer of a built-in type that serialize() calls without a lookup in the factory.
+struct BuiltInSerializer {
+	const std::type_info * type;
+	builtInSerializer_t serializer;
+};
+static const std::size_t NUMBER_OF_KINDS = static_cast<std::size_t>(GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_CHAR) + 1;
+//! Indexed by GenericAttributeKind
+static BuiltInSerializer builtInSerializers[NUMBER_OF_KINDS];
+
+template<typename AttributeType>
+static void registerBuiltInSerializer(const std::string & typeName,
+									  builtInSerializer_t serializer,
+									  const GenericAttributeSerialization::unserializer_function_t & unserializer) {
+	GenericAttributeSerialization::registerSerializer<AttributeType>(typeName, serializer, unserializer);
+	BuiltInSerializer & builtIn = builtInSerializers[static_cast<std::size_t>(GenericAttributeKindOf<AttributeType>::value)];
+	builtIn.type = &typeid(AttributeType);
+	builtIn.serializer = serializer;
+}
+
+void GenericAttributeSerialization::disableBuiltInSerializer(const std::type_index & type) {
+	for(auto & builtIn : builtInSerializers) {
+		if(builtIn.type != nullptr && std::type_index(*builtIn.type) == type) {
+			builtIn.serializer = nullptr;
+		}
+	}
+}
+
 bool GenericAttributeSerialization::init() {
 	static int initializationCount = 0;
 	if(initializationCount++ == 0) {
- 		registerSerializer<BoolAttribute>(GATypeNameBool, serializeGABool, unserializeGABool);
-		registerSerializer<_NumberAttribute<double>>(getGATypeName<double>(), serializeGANumber<double>, unserializeGANumber<double>);
-		registerSerializer<_NumberAttribute<float>>(getGATypeName<float>(), serializeGANumber<float>, unserializeGANumber<float>);
-		registerSerializer<_NumberAttribute<long>>(getGATypeName<long>(), serializeGANumber<long>, unserializeGANumber<long>);
-		registerSerializer<_NumberAttribute<unsigned long>>(getGATypeName<unsigned long>(), serializeGANumber<unsigned long>, unserializeGANumber<unsigned long>);
-		registerSerializer<_NumberAttribute<int>>(getGATypeName<int>(), serializeGANumber<int>, unserializeGANumber<int>);
-		registerSerializer<_NumberAttribute<unsigned int>>(getGATypeName<unsigned int>(), serializeGANumber<unsigned int>, unserializeGANumber<unsigned int>);
-		registerSerializer<_NumberAttribute<short>>(getGATypeName<short>(), serializeGANumber<short>, unserializeGANumber<short>);
-		registerSerializer<_NumberAttribute<unsigned short>>(getGATypeName<unsigned short>(), serializeGANumber<unsigned short>, unserializeGANumber<unsigned short>);
- 		registerSerializer<_NumberAttribute<char>>(getGATypeName<char>(), serializeGANumber<char>, unserializeGANumber<char>);
- 		registerSerializer<_NumberAttribute<unsigned char>>(getGATypeName<unsigned char>(), serializeGANumber<unsigned char>, unserializeGANumber<unsigned char>);
- 		registerSerializer<_StringAttribute<std::string>>(getGATypeName<std::string>(), serializeGAString<std::string>, unserializeGAString<std::string>);
- 		registerSerializer<GenericAttributeList>(GATypeNameList, serializeGAList, unserializeGAList);
-		registerSerializer<GenericAttributeMap>(GATypeNameMap, serializeGAMap, unserializeGAMap);
+ 		registerBuiltInSerializer<BoolAttribute>(GATypeNameBool, serializeGABool, unserializeGABool);
+		registerBuiltInSerializer<_NumberAttribute<double>>(getGATypeName<double>(), serializeGANumber<double>, unserializeGANumber<double>);
+		registerBuiltInSerializer<_NumberAttribute<float>>(getGATypeName<float>(), serializeGANumber<float>, unserializeGANumber<float>);
+		registerBuiltInSerializer<_NumberAttribute<long>>(getGATypeName<long>(), serializeGANumber<long>, unserializeGANumber<long>);
+		registerBuiltInSerializer<_NumberAttribute<unsigned long>>(getGATypeName<unsigned long>(), serializeGANumber<unsigned long>, unserializeGANumber<unsigned long>);
+		registerBuiltInSerializer<_NumberAttribute<long long>>(getGATypeName<long long>(), serializeGANumber<long long>, unserializeGANumber<long long>);
+		registerBuiltInSerializer<_NumberAttribute<unsigned long long>>(getGATypeName<unsigned long long>(), serializeGANumber<unsigned long long>, unserializeGANumber<unsigned long long>);
+		registerBuiltInSerializer<_NumberAttribute<int>>(getGATypeName<int>(), serializeGANumber<int>, unserializeGANumber<int>);
+		registerBuiltInSerializer<_NumberAttribute<unsigned int>>(getGATypeName<unsigned int>(), serializeGANumber<unsigned int>, unserializeGANumber<unsigned int>);
+		registerBuiltInSerializer<_NumberAttribute<short>>(getGATypeName<short>(), serializeGANumber<short>, unserializeGANumber<short>);
+		registerBuiltInSerializer<_NumberAttribute<unsigned short>>(getGATypeName<unsigned short>(), serializeGANumber<unsigned short>, unserializeGANumber<unsigned short>);
+ 		registerBuiltInSerializer<_NumberAttribute<char>>(getGATypeName<char>(), serializeGANumber<char>, unserializeGANumber<char>);
+ 		registerBuiltInSerializer<_NumberAttribute<signed char>>(getGATypeName<signed char>(), serializeGANumber<signed char>, unserializeGANumber<signed char>);
+ 		registerBuiltInSerializer<_NumberAttribute<unsigned char>>(getGATypeName<unsigned char>(), serializeGANumber<unsigned char>, unserializeGANumber<unsigned char>);
+ 		registerBuiltInSerializer<_StringAttribute<std::string>>(getGATypeName<std::string>(), serializeGAString<std::string>, unserializeGAString<std::string>);
+ 		registerBuiltInSerializer<GenericAttributeList>(GATypeNameList, serializeGAList, unserializeGAList);
+		registerBuiltInSerializer<GenericAttributeMap>(GATypeNameMap, serializeGAMap, unserializeGAMap);
+		registerSerializer<GenericAttributePatch>(GATypeNamePatch, serializeGAPatch, unserializeGAPatch);
+		registerBuiltInSerializer<NumberArrayAttribute<double>>(getGANumberArrayTypeName<double>(), serializeGANumberArray<double>, unserializeGANumberArray<double>);
+		registerBuiltInSerializer<NumberArrayAttribute<float>>(getGANumberArrayTypeName<float>(), serializeGANumberArray<float>, unserializeGANumberArray<float>);
+		registerBuiltInSerializer<NumberArrayAttribute<int>>(getGANumberArrayTypeName<int>(), serializeGANumberArray<int>, unserializeGANumberArray<int>);
+		registerBuiltInSerializer<NumberArrayAttribute<unsigned int>>(getGANumberArrayTypeName<unsigned int>(), serializeGANumberArray<unsigned int>, unserializeGANumberArray<unsigned int>);
+		registerBuiltInSerializer<NumberArrayAttribute<short>>(getGANumberArrayTypeName<short>(), serializeGANumberArray<short>, unserializeGANumberArray<short>);
+		registerBuiltInSerializer<NumberArrayAttribute<unsigned short>>(getGANumberArrayTypeName<unsigned short>(), serializeGANumberArray<unsigned short>, unserializeGANumberArray<unsigned short>);
+		registerBuiltInSerializer<NumberArrayAttribute<signed char>>(getGANumberArrayTypeName<signed char>(), serializeGANumberArray<signed char>, unserializeGANumberArray<signed char>);
+		registerBuiltInSerializer<NumberArrayAttribute<unsigned char>>(getGANumberArrayTypeName<unsigned char>(), serializeGANumberArray<unsigned char>, unserializeGANumberArray<unsigned char>);
 	}
 	return true;
 }
@@ -200,7 +359,14 @@ std::string GenericAttributeSerialization::serialize(const GenericAttribute * at
 
 std::string GenericAttributeSerialization::serialize(const GenericAttribute * attribute,
 													 const GenericAttributeMap * context) {
-	const auto typeValuePair = getSerializerFactory().create(typeid(*attribute), std::make_pair(attribute, context));
+	if(attribute == nullptr) {
+		// Like typeid(*attribute), which was used to look up the serializer before built-in types were dispatched by kind.
+		throw std::bad_typeid();
+	}
+	const BuiltInSerializer & builtIn = builtInSerializers[static_cast<std::size_t>(attribute->getKind())];
+	const auto typeValuePair = (builtIn.serializer != nullptr && typeid(*attribute) == *builtIn.type) ?
+									builtIn.serializer(std::make_pair(attribute, context)) :
+									getSerializerFactory().create(typeid(*attribute), std::make_pair(attribute, context));
 	return std::string("{\"type\":\"") + typeValuePair.first + std::string("\",\"value\":\"") + StringUtils::escape(typeValuePair.second) + std::string("\"}");
 }
 
@@ -220,4 +386,510 @@ GenericAttribute * GenericAttributeSerialization::unserialize(const std::string
 	return getUnserializerFactory().create(objectMap->getString(TYPE), std::make_pair(objectMap->getString(VALUE), context));
 }
 
+
+/*
+ * Binary representation
+ *
+ * The representation starts with the four bytes "GAB\x01". Every attribute is
+ * stored as a tag byte followed by its content. The tags of the built-in types
+ * are the values of GenericAttributeKind:
+ * - BOOL: one byte (0 or 1)
+ * - Signed integers: zigzag-encoded variable-length integer
+ * - Unsigned integers: variable-length integer (seven bits per byte)
+ * - NUMBER_FLOAT and NUMBER_DOUBLE: raw IEEE value in little-endian byte order
+ * - STRING: length and characters
+ * - LIST: number of elements and the elements
+ * - MAP: number of elements and pairs of key (like a string) and element
+ * - NUMBER_ARRAY_*: number of elements and the raw numbers in little-endian byte order
+ * The tag UNDEFINED marks an empty element. Other types are stored with the tag
+ * BINARY_TAG_SERIALIZED followed by the representation created by serialize()
+ * (like a string).
+ */
+static const char binaryMagic[] = {'G', 'A', 'B', '\x01'};
+static const uint8_t BINARY_TAG_SERIALIZED = 0xff;
+//! Maximum number of nested lists and maps accepted by unserializeBinary().
+static const std::size_t MAX_BINARY_NESTING_DEPTH = 1000;
+
+static void writeTag(std::string & out, GenericAttributeKind kind) {
+	out.push_back(static_cast<char>(kind));
+}
+static void writeVarint(std::string & out, uint64_t value) {
+	while(value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+static void writeSigned(std::string & out, int64_t value) {
+	const uint64_t shifted = static_cast<uint64_t>(value) << 1;
+	writeVarint(out, value < 0 ? ~shifted : shifted);
+}
+static void writeBytes(std::string & out, const char * bytes, std::size_t length) {
+	writeVarint(out, length);
+	out.append(bytes, length);
+}
+template<typename Number>
+static void writeRaw(std::string & out, const Number * numbers, std::size_t count) {
+	if(sizeof(Number) == 1 || isLittleEndian()) {
+		out.append(reinterpret_cast<const char *>(numbers), count * sizeof(Number));
+		return;
+	}
+	for(std::size_t i = 0; i < count; ++i) {
+		char bytes[sizeof(Number)];
+		std::memcpy(bytes, numbers + i, sizeof(Number));
+		std::reverse(bytes, bytes + sizeof(Number));
+		out.append(bytes, sizeof(Number));
+	}
+}
+
+template<typename Number>
+static typename std::enable_if<std::is_floating_point<Number>::value>::type writeNumber(std::string & out, Number value) {
+	writeRaw(out, &value, 1);
+}
+template<typename Number>
+static typename std::enable_if<std::is_integral<Number>::value && std::is_signed<Number>::value>::type writeNumber(std::string & out, Number value) {
+	writeSigned(out, static_cast<int64_t>(value));
+}
+template<typename Number>
+static typename std::enable_if<std::is_integral<Number>::value && !std::is_signed<Number>::value>::type writeNumber(std::string & out, Number value) {
+	writeVarint(out, static_cast<uint64_t>(value));
+}
+
+//! Write the attribute if it is exactly a _NumberAttribute<Number> (and not a derived type).
+template<typename Number>
+static bool writeBinaryNumber(std::string & out, const GenericAttribute * attribute) {
+	if(typeid(*attribute) != typeid(_NumberAttribute<Number>)) {
+		return false;
+	}
+	writeTag(out, attribute->getKind());
+	writeNumber(out, static_cast<const _NumberAttribute<Number> *>(attribute)->get());
+	return true;
+}
+template<typename Number>
+static bool writeBinaryNumberArray(std::string & out, const GenericAttribute * attribute) {
+	if(typeid(*attribute) != typeid(NumberArrayAttribute<Number>)) {
+		return false;
+	}
+	writeTag(out, attribute->getKind());
+	const auto & numbers = static_cast<const NumberArrayAttribute<Number> *>(attribute)->get();
+	writeVarint(out, numbers.size());
+	writeRaw(out, numbers.data(), numbers.size());
+	return true;
+}
+
+static void writeBinary(std::string & out, const GenericAttribute * attribute, const GenericAttributeMap * context);
+
+//! Write an element of a container without converting inline values into GenericAttributes.
+static void writeBinarySlot(std::string & out, const GenericAttributeSlot & slot, const GenericAttributeMap * context) {
+	if(!slot.isInline()) {
+		writeBinary(out, slot.get(), context);
+		return;
+	}
+	writeTag(out, slot.getKind());
+	switch(slot.getKind()) {
+		case GenericAttributeKind::BOOL:
+			out.push_back(slot.getInlineBool() ? 1 : 0);
+			break;
+		case GenericAttributeKind::NUMBER_INT:
+			writeNumber(out, slot.getInlineInt());
+			break;
+		case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+			writeNumber(out, slot.getInlineUnsignedInt());
+			break;
+		case GenericAttributeKind::NUMBER_FLOAT:
+			writeNumber(out, slot.getInlineFloat());
+			break;
+		case GenericAttributeKind::NUMBER_DOUBLE:
+			writeNumber(out, slot.getInlineDouble());
+			break;
+		default: {
+			const std::string value = slot.getInlineString();
+			writeBytes(out, value.data(), value.size());
+			break;
+		}
+	}
+}
+
+static void writeBinary(std::string & out, const GenericAttribute * attribute, const GenericAttributeMap * context) {
+	if(attribute == nullptr) {
+		writeTag(out, GenericAttributeKind::UNDEFINED);
+		return;
+	}
+	// Derived types of the built-in types are handled by their registered serializers.
+	switch(attribute->getKind()) {
+		case GenericAttributeKind::BOOL:
+			if(typeid(*attribute) == typeid(BoolAttribute)) {
+				writeTag(out, GenericAttributeKind::BOOL);
+				out.push_back(static_cast<const BoolAttribute *>(attribute)->get() ? 1 : 0);
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_DOUBLE:
+			if(writeBinaryNumber<double>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_FLOAT:
+			if(writeBinaryNumber<float>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_LONG_LONG:
+			if(writeBinaryNumber<long long>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_UNSIGNED_LONG_LONG:
+			if(writeBinaryNumber<unsigned long long>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_LONG:
+			if(writeBinaryNumber<long>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_UNSIGNED_LONG:
+			if(writeBinaryNumber<unsigned long>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_INT:
+			if(writeBinaryNumber<int>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+			if(writeBinaryNumber<unsigned int>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_SHORT:
+			if(writeBinaryNumber<short>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_UNSIGNED_SHORT:
+			if(writeBinaryNumber<unsigned short>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_CHAR:
+			if(writeBinaryNumber<char>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_SIGNED_CHAR:
+			if(writeBinaryNumber<signed char>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_UNSIGNED_CHAR:
+			if(writeBinaryNumber<unsigned char>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::STRING:
+			if(typeid(*attribute) == typeid(StringAttribute)) {
+				const std::string & value = static_cast<const StringAttribute *>(attribute)->get();
+				writeTag(out, GenericAttributeKind::STRING);
+				writeBytes(out, value.data(), value.size());
+				return;
+			}
+			break;
+		case GenericAttributeKind::LIST:
+			if(typeid(*attribute) == typeid(GenericAttributeList)) {
+				const auto & elements = static_cast<const GenericAttributeList *>(attribute)->getElements();
+				writeTag(out, GenericAttributeKind::LIST);
+				writeVarint(out, elements.size());
+				for(const auto & element : elements) {
+					writeBinarySlot(out, element, context);
+				}
+				return;
+			}
+			break;
+		case GenericAttributeKind::MAP:
+			if(typeid(*attribute) == typeid(GenericAttributeMap)) {
+				const auto & elements = static_cast<const GenericAttributeMap *>(attribute)->getElements();
+				writeTag(out, GenericAttributeKind::MAP);
+				writeVarint(out, elements.size());
+				for(const auto & element : elements) {
+					const StringView key = element.first.toStringView();
+					writeBytes(out, key.data(), key.size());
+					writeBinarySlot(out, element.second, context);
+				}
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_ARRAY_DOUBLE:
+			if(writeBinaryNumberArray<double>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_ARRAY_FLOAT:
+			if(writeBinaryNumberArray<float>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_ARRAY_INT:
+			if(writeBinaryNumberArray<int>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_INT:
+			if(writeBinaryNumberArray<unsigned int>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_ARRAY_SHORT:
+			if(writeBinaryNumberArray<short>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_SHORT:
+			if(writeBinaryNumberArray<unsigned short>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_ARRAY_SIGNED_CHAR:
+			if(writeBinaryNumberArray<signed char>(out, attribute)) {
+				return;
+			}
+			break;
+		case GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_CHAR:
+			if(writeBinaryNumberArray<unsigned char>(out, attribute)) {
+				return;
+			}
+			break;
+		default:
+			break;
+	}
+	out.push_back(static_cast<char>(BINARY_TAG_SERIALIZED));
+	const std::string representation = GenericAttributeSerialization::serialize(attribute, context);
+	writeBytes(out, representation.data(), representation.size());
+}
+
+//! Position in a binary representation that is being read.
+struct BinaryReader {
+	const char * cursor;
+	const char * end;
+	const GenericAttributeMap * context;
+	//! Number of lists and maps that are currently being read.
+	std::size_t depth;
+
+	std::size_t remaining() const {
+		return static_cast<std::size_t>(end - cursor);
+	}
+	const char * readBytes(std::size_t count) {
+		if(remaining() < count) {
+			throw std::logic_error("Invalid binary representation: Unexpected end of data");
+		}
+		const char * bytes = cursor;
+		cursor += count;
+		return bytes;
+	}
+	uint8_t readByte() {
+		return static_cast<uint8_t>(*readBytes(1));
+	}
+	uint64_t readVarint() {
+		uint64_t value = 0;
+		for(unsigned int shift = 0; shift < 64; shift += 7) {
+			const uint8_t byte = readByte();
+			value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if((byte & 0x80) == 0) {
+				return value;
+			}
+		}
+		throw std::logic_error("Invalid binary representation: Integer too long");
+	}
+	int64_t readSigned() {
+		const uint64_t value = readVarint();
+		return static_cast<int64_t>((value & 1) != 0 ? ~(value >> 1) : value >> 1);
+	}
+	//! Read a number of elements that occupy at least @p elementSize bytes each.
+	std::size_t readCount(std::size_t elementSize) {
+		const uint64_t count = readVarint();
+		if(count > remaining() / elementSize) {
+			throw std::logic_error("Invalid binary representation: Unexpected end of data");
+		}
+		return static_cast<std::size_t>(count);
+	}
+	template<typename Number>
+	void readRaw(Number * numbers, std::size_t count) {
+		const char * bytes = readBytes(count * sizeof(Number));
+		if(sizeof(Number) == 1 || isLittleEndian()) {
+			std::memcpy(numbers, bytes, count * sizeof(Number));
+			return;
+		}
+		for(std::size_t i = 0; i < count; ++i) {
+			char reversed[sizeof(Number)];
+			std::reverse_copy(bytes + i * sizeof(Number), bytes + (i + 1) * sizeof(Number), reversed);
+			std::memcpy(numbers + i, reversed, sizeof(Number));
+		}
+	}
+};
+
+template<typename Number>
+static typename std::enable_if<std::is_floating_point<Number>::value, Number>::type readNumber(BinaryReader & reader) {
+	Number value;
+	reader.readRaw(&value, 1);
+	return value;
+}
+template<typename Number>
+static typename std::enable_if<std::is_integral<Number>::value && std::is_signed<Number>::value, Number>::type readNumber(BinaryReader & reader) {
+	return static_cast<Number>(reader.readSigned());
+}
+template<typename Number>
+static typename std::enable_if<std::is_integral<Number>::value && !std::is_signed<Number>::value, Number>::type readNumber(BinaryReader & reader) {
+	return static_cast<Number>(reader.readVarint());
+}
+
+template<typename Number>
+static GenericAttributeSlot readBinaryNumber(BinaryReader & reader) {
+	return GenericAttributeSlot::createNumber(readNumber<Number>(reader));
+}
+template<typename Number>
+static GenericAttributeSlot readBinaryNumberArray(BinaryReader & reader) {
+	std::vector<Number> numbers(reader.readCount(sizeof(Number)));
+	reader.readRaw(numbers.data(), numbers.size());
+	return GenericAttributeSlot(new NumberArrayAttribute<Number>(std::move(numbers)));
+}
+
+//! Read an attribute; numbers and short strings are stored inline.
+static GenericAttributeSlot readBinarySlot(BinaryReader & reader);
+
+//! Read the elements of a list or a map while keeping track of the nesting depth.
+struct BinaryNesting {
+	BinaryReader & reader;
+	explicit BinaryNesting(BinaryReader & _reader) : reader(_reader) {
+		if(reader.depth >= MAX_BINARY_NESTING_DEPTH) {
+			throw std::logic_error("Invalid binary representation: Nesting too deep");
+		}
+		++reader.depth;
+	}
+	~BinaryNesting() {
+		--reader.depth;
+	}
+	BinaryNesting(const BinaryNesting &) = delete;
+	BinaryNesting & operator=(const BinaryNesting &) = delete;
+};
+
+static GenericAttributeSlot readBinarySlot(BinaryReader & reader) {
+	const uint8_t tag = reader.readByte();
+	if(tag == BINARY_TAG_SERIALIZED) {
+		const std::size_t length = reader.readCount(1);
+		const char * representation = reader.readBytes(length);
+		return GenericAttributeSlot(GenericAttributeSerialization::unserialize(std::string(representation, length), reader.context));
+	}
+	switch(static_cast<GenericAttributeKind>(tag)) {
+		case GenericAttributeKind::UNDEFINED:
+			return GenericAttributeSlot();
+		case GenericAttributeKind::BOOL:
+			return GenericAttributeSlot::createBool(reader.readByte() != 0);
+		case GenericAttributeKind::NUMBER_DOUBLE:
+			return readBinaryNumber<double>(reader);
+		case GenericAttributeKind::NUMBER_FLOAT:
+			return readBinaryNumber<float>(reader);
+		case GenericAttributeKind::NUMBER_LONG_LONG:
+			return readBinaryNumber<long long>(reader);
+		case GenericAttributeKind::NUMBER_UNSIGNED_LONG_LONG:
+			return readBinaryNumber<unsigned long long>(reader);
+		case GenericAttributeKind::NUMBER_LONG:
+			return readBinaryNumber<long>(reader);
+		case GenericAttributeKind::NUMBER_UNSIGNED_LONG:
+			return readBinaryNumber<unsigned long>(reader);
+		case GenericAttributeKind::NUMBER_INT:
+			return readBinaryNumber<int>(reader);
+		case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+			return readBinaryNumber<unsigned int>(reader);
+		case GenericAttributeKind::NUMBER_SHORT:
+			return readBinaryNumber<short>(reader);
+		case GenericAttributeKind::NUMBER_UNSIGNED_SHORT:
+			return readBinaryNumber<unsigned short>(reader);
+		case GenericAttributeKind::NUMBER_CHAR:
+			return readBinaryNumber<char>(reader);
+		case GenericAttributeKind::NUMBER_SIGNED_CHAR:
+			return readBinaryNumber<signed char>(reader);
+		case GenericAttributeKind::NUMBER_UNSIGNED_CHAR:
+			return readBinaryNumber<unsigned char>(reader);
+		case GenericAttributeKind::STRING: {
+			const std::size_t length = reader.readCount(1);
+			const char * characters = reader.readBytes(length);
+			if(length > GenericAttributeSlot::MAX_INLINE_STRING_LENGTH) {
+				return GenericAttributeSlot(GenericAttribute::createString(std::string(characters, length)));
+			}
+			return GenericAttributeSlot::createString(std::string(characters, length));
+		}
+		case GenericAttributeKind::LIST: {
+			BinaryNesting nesting(reader);
+			const std::size_t count = reader.readCount(1);
+			std::unique_ptr<GenericAttributeList> list(new GenericAttributeList);
+			list->reserve(count);
+			for(std::size_t i = 0; i < count; ++i) {
+				list->push_back(readBinarySlot(reader));
+			}
+			return GenericAttributeSlot(list.release());
+		}
+		case GenericAttributeKind::MAP: {
+			BinaryNesting nesting(reader);
+			// Every element consists of at least the length of the key and a tag.
+			const std::size_t count = reader.readCount(2);
+			std::unique_ptr<GenericAttributeMap> map(new GenericAttributeMap);
+			map->reserve(count);
+			for(std::size_t i = 0; i < count; ++i) {
+				const std::size_t length = reader.readCount(1);
+				const char * key = reader.readBytes(length);
+				map->setValue(StringIdentifier(key, length), readBinarySlot(reader));
+			}
+			return GenericAttributeSlot(map.release());
+		}
+		case GenericAttributeKind::NUMBER_ARRAY_DOUBLE:
+			return readBinaryNumberArray<double>(reader);
+		case GenericAttributeKind::NUMBER_ARRAY_FLOAT:
+			return readBinaryNumberArray<float>(reader);
+		case GenericAttributeKind::NUMBER_ARRAY_INT:
+			return readBinaryNumberArray<int>(reader);
+		case GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_INT:
+			return readBinaryNumberArray<unsigned int>(reader);
+		case GenericAttributeKind::NUMBER_ARRAY_SHORT:
+			return readBinaryNumberArray<short>(reader);
+		case GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_SHORT:
+			return readBinaryNumberArray<unsigned short>(reader);
+		case GenericAttributeKind::NUMBER_ARRAY_SIGNED_CHAR:
+			return readBinaryNumberArray<signed char>(reader);
+		case GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_CHAR:
+			return readBinaryNumberArray<unsigned char>(reader);
+		default:
+			throw std::logic_error("Invalid binary representation: Unknown tag");
+	}
+}
+
+std::string GenericAttributeSerialization::serializeBinary(const GenericAttribute * attribute) {
+	return serializeBinary(attribute, nullptr);
+}
+
+std::string GenericAttributeSerialization::serializeBinary(const GenericAttribute * attribute,
+														   const GenericAttributeMap * context) {
+	std::string representation(binaryMagic, sizeof(binaryMagic));
+	writeBinary(representation, attribute, context);
+	return representation;
+}
+
+GenericAttribute * GenericAttributeSerialization::unserializeBinary(const std::string & representation) {
+	return unserializeBinary(representation, nullptr);
+}
+
+GenericAttribute * GenericAttributeSerialization::unserializeBinary(const std::string & representation,
+																	const GenericAttributeMap * context) {
+	if(representation.compare(0, sizeof(binaryMagic), binaryMagic, sizeof(binaryMagic)) != 0) {
+		throw std::logic_error("Invalid binary representation: Unknown format");
+	}
+	BinaryReader reader{representation.data() + sizeof(binaryMagic), representation.data() + representation.size(), context, 0};
+	GenericAttributeSlot slot(readBinarySlot(reader));
+	if(reader.cursor != reader.end) {
+		throw std::logic_error("Invalid binary representation: Unexpected data after the attribute");
+	}
+	return slot.release();
+}
+
 }
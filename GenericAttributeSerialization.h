@@ -16,6 +16,7 @@
 #include <string>
 #include <typeindex>
 #include <typeinfo>
+#include <unordered_map>
 #include <utility>
 namespace Util {
 class GenericAttribute;
@@ -39,17 +40,29 @@ class GenericAttributeSerialization {
 		typedef std::pair<std::string,
 						  const GenericAttributeMap *> unserializer_parameter_t;
 
+		typedef std::function<serializer_type_t (const serializer_parameter_t &)> serializer_function_t;
+		typedef std::function<unserializer_type_t (const unserializer_parameter_t &)> unserializer_function_t;
+
 	private:
 		typedef WrapperFactory<serializer_parameter_t,
 							   serializer_type_t,
-							   std::type_index> serializer_factory_t;
+							   std::type_index,
+							   serializer_function_t,
+							   FallbackPolicies::ExceptionFallback,
+							   std::unordered_map<std::type_index, serializer_function_t>> serializer_factory_t;
 		UTILAPI static serializer_factory_t & getSerializerFactory();
 
 		typedef WrapperFactory<unserializer_parameter_t,
 							   unserializer_type_t,
-							   std::string> unserializer_factory_t;
+							   std::string,
+							   unserializer_function_t,
+							   FallbackPolicies::ExceptionFallback,
+							   std::unordered_map<std::string, unserializer_function_t>> unserializer_factory_t;
 		UTILAPI static unserializer_factory_t & getUnserializerFactory();
 
+		//! Make serialize() use the factory for a built-in type whose serializer is replaced.
+		UTILAPI static void disableBuiltInSerializer(const std::type_index & type);
+
 	public:
 		/**
 		 * Initialize the serializers for the standard GenericAttributes.
@@ -74,6 +87,7 @@ class GenericAttributeSerialization {
 		 *
 		 * @param attribute Generic attribute that is to be converted
 		 * @return String representation
+		 * @throw std::bad_typeid if @p attribute is @c nullptr
 		 */
 		UTILAPI static std::string serialize(const GenericAttribute * attribute);
 
@@ -85,6 +99,7 @@ class GenericAttributeSerialization {
 		 * @param context A map containing specific information that is needed
 		 * during unserialization
 		 * @return String representation
+		 * @throw std::bad_typeid if @p attribute is @c nullptr
 		 */
 		UTILAPI static std::string serialize(const GenericAttribute * attribute, 
 									 const GenericAttributeMap * context);
@@ -113,6 +128,57 @@ class GenericAttributeSerialization {
 		UTILAPI static GenericAttribute * unserialize(const std::string & representation, 
 											  const GenericAttributeMap * context);
 
+		/**
+		 * Convert the given generic attribute into a compact binary representation.
+		 * The representation is a tag-length-value stream: integers are stored
+		 * as variable-length integers, floating-point numbers as raw IEEE values
+		 * in little-endian byte order, and strings with a length prefix.
+		 * Attributes that are not built-in types are stored using their
+		 * registered serializer.
+		 *
+		 * @param attribute Generic attribute that is to be converted (may be nullptr)
+		 * @return Binary representation
+		 */
+		UTILAPI static std::string serializeBinary(const GenericAttribute * attribute);
+
+		/**
+		 * Convert the given generic attribute into a compact binary representation.
+		 * Use the given context for attributes that are not built-in types.
+		 *
+		 * @param attribute Generic attribute that is to be converted (may be nullptr)
+		 * @param context A map containing specific information that is needed
+		 * during serialization
+		 * @return Binary representation
+		 */
+		UTILAPI static std::string serializeBinary(const GenericAttribute * attribute,
+												   const GenericAttributeMap * context);
+
+		/**
+		 * Convert the given binary representation to a generic attribute.
+		 *
+		 * @param representation Binary representation that was created by
+		 * serializeBinary()
+		 * @return Newly constructed, generic attribute
+		 * @throw std::logic_error if the representation is invalid
+		 * @note The caller has to free the memory for the generic attribute.
+		 */
+		UTILAPI static GenericAttribute * unserializeBinary(const std::string & representation);
+
+		/**
+		 * Convert the given binary representation to a generic attribute.
+		 * Use the given context for attributes that are not built-in types.
+		 *
+		 * @param representation Binary representation that was created by
+		 * serializeBinary()
+		 * @param context A map containing specific information that is needed
+		 * during unserialization
+		 * @return Newly constructed, generic attribute
+		 * @throw std::logic_error if the representation is invalid
+		 * @note The caller has to free the memory for the generic attribute.
+		 */
+		UTILAPI static GenericAttribute * unserializeBinary(const std::string & representation,
+															const GenericAttributeMap * context);
+
 		/**
 		 * Register a serializer and unserializer for a generic attribute type.
 		 *
@@ -125,8 +191,9 @@ class GenericAttributeSerialization {
 		 */
 		template<typename AttributeType>
 		static bool registerSerializer(const std::string & typeName,
-									   const std::function<serializer_type_t (const serializer_parameter_t &)> & serializer,
-									   const std::function<unserializer_type_t (const unserializer_parameter_t &)> & unserializer) {
+									   const serializer_function_t & serializer,
+									   const unserializer_function_t & unserializer) {
+			disableBuiltInSerializer(typeid(AttributeType));
 			getSerializerFactory().unregisterType(typeid(AttributeType));
 			getUnserializerFactory().unregisterType(typeName);
 			return getSerializerFactory().registerType(typeid(AttributeType), serializer) &&
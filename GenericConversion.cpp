@@ -14,7 +14,11 @@
 #include "StringUtils.h"
 #include <istream>
 #include <ostream>
-#include <memory>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
 
 namespace Util {
 namespace GenericConversion {
@@ -22,239 +26,328 @@ namespace GenericConversion {
 typedef std::vector<Generic> GenericArray;
 typedef std::unordered_map<StringIdentifier, Generic> GenericMap;
 
-static Generic fromGenericAttribute(const GenericAttribute * attr) {
-	{
-		auto boolAttr = dynamic_cast<const BoolAttribute *>(attr);
-		if(boolAttr != nullptr) {
-			return Generic(boolAttr->get());
-		}
-	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<double> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
-	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<float> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
-	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<long> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
-	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<unsigned long> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
-	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<int> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
-	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<unsigned int> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
-	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<short> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
-	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<unsigned short> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
-	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<char> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
+template<typename Number>
+static Generic fromNumberAttribute(const GenericAttribute * attr) {
+	return Generic(static_cast<const _NumberAttribute<Number> *>(attr)->get());
+}
+
+template<typename Number>
+static Generic fromNumberArrayAttribute(const GenericAttribute * attr) {
+	return Generic(static_cast<const NumberArrayAttribute<Number> *>(attr)->get());
+}
+
+//! Convert an element of a container without converting inline values into GenericAttributes.
+static Generic fromGenericAttributeSlot(const GenericAttributeSlot & slot) {
+	if(!slot.isInline()) {
+		return fromGenericAttribute(slot.get());
 	}
-	{
-		auto numberAttr = dynamic_cast<const _NumberAttribute<unsigned char> *>(attr);
-		if(numberAttr != nullptr) {
-			return Generic(numberAttr->get());
-		}
+	switch(slot.getKind()) {
+		case GenericAttributeKind::BOOL:
+			return Generic(slot.getInlineBool());
+		case GenericAttributeKind::NUMBER_INT:
+			return Generic(slot.getInlineInt());
+		case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+			return Generic(slot.getInlineUnsignedInt());
+		case GenericAttributeKind::NUMBER_FLOAT:
+			return Generic(slot.getInlineFloat());
+		case GenericAttributeKind::NUMBER_DOUBLE:
+			return Generic(slot.getInlineDouble());
+		default:
+			return Generic(slot.getInlineString());
 	}
-	{
-		auto stringAttr = dynamic_cast<const _StringAttribute<std::string> *>(attr);
-		if(stringAttr != nullptr) {
-			return Generic(stringAttr->get());
-		}
+}
+
+Generic fromGenericAttribute(const GenericAttribute * attr) {
+	if(attr == nullptr) {
+		return Generic();
 	}
-	{
-		auto listAttr = dynamic_cast<const GenericAttributeList *>(attr);
-		if(listAttr != nullptr) {
+	switch(attr->getKind()) {
+		case GenericAttributeKind::BOOL:
+			return Generic(static_cast<const BoolAttribute *>(attr)->get());
+		case GenericAttributeKind::NUMBER_DOUBLE:
+			return fromNumberAttribute<double>(attr);
+		case GenericAttributeKind::NUMBER_FLOAT:
+			return fromNumberAttribute<float>(attr);
+		case GenericAttributeKind::NUMBER_LONG_LONG:
+			return fromNumberAttribute<long long>(attr);
+		case GenericAttributeKind::NUMBER_UNSIGNED_LONG_LONG:
+			return fromNumberAttribute<unsigned long long>(attr);
+		case GenericAttributeKind::NUMBER_LONG:
+			return fromNumberAttribute<long>(attr);
+		case GenericAttributeKind::NUMBER_UNSIGNED_LONG:
+			return fromNumberAttribute<unsigned long>(attr);
+		case GenericAttributeKind::NUMBER_INT:
+			return fromNumberAttribute<int>(attr);
+		case GenericAttributeKind::NUMBER_UNSIGNED_INT:
+			return fromNumberAttribute<unsigned int>(attr);
+		case GenericAttributeKind::NUMBER_SHORT:
+			return fromNumberAttribute<short>(attr);
+		case GenericAttributeKind::NUMBER_UNSIGNED_SHORT:
+			return fromNumberAttribute<unsigned short>(attr);
+		case GenericAttributeKind::NUMBER_CHAR:
+			return fromNumberAttribute<char>(attr);
+		case GenericAttributeKind::NUMBER_SIGNED_CHAR:
+			return fromNumberAttribute<signed char>(attr);
+		case GenericAttributeKind::NUMBER_UNSIGNED_CHAR:
+			return fromNumberAttribute<unsigned char>(attr);
+		case GenericAttributeKind::STRING:
+			return Generic(static_cast<const StringAttribute *>(attr)->get());
+		case GenericAttributeKind::LIST: {
+			auto listAttr = static_cast<const GenericAttributeList *>(attr);
 			GenericArray genericArray;
 			genericArray.reserve(listAttr->size());
 			for(const auto & element : *listAttr) {
-				genericArray.emplace_back(fromGenericAttribute(element.get()));
+				genericArray.emplace_back(fromGenericAttributeSlot(element));
 			}
 			return Generic(std::move(genericArray));
 		}
-	}
-	{
-		auto mapAttr = dynamic_cast<const GenericAttributeMap *>(attr);
-		if(mapAttr != nullptr) {
+		case GenericAttributeKind::MAP: {
+			auto mapAttr = static_cast<const GenericAttributeMap *>(attr);
 			GenericMap genericMap;
 			genericMap.reserve(mapAttr->size());
-			for(const auto & element : *mapAttr) {
-				genericMap.emplace(element.first, fromGenericAttribute(element.second.get()));
+			for(const auto & element : mapAttr->getElements()) {
+				genericMap.emplace(element.first, fromGenericAttributeSlot(element.second));
 			}
 			return Generic(std::move(genericMap));
 		}
+		case GenericAttributeKind::NUMBER_ARRAY_DOUBLE:
+			return fromNumberArrayAttribute<double>(attr);
+		case GenericAttributeKind::NUMBER_ARRAY_FLOAT:
+			return fromNumberArrayAttribute<float>(attr);
+		case GenericAttributeKind::NUMBER_ARRAY_INT:
+			return fromNumberArrayAttribute<int>(attr);
+		case GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_INT:
+			return fromNumberArrayAttribute<unsigned int>(attr);
+		case GenericAttributeKind::NUMBER_ARRAY_SHORT:
+			return fromNumberArrayAttribute<short>(attr);
+		case GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_SHORT:
+			return fromNumberArrayAttribute<unsigned short>(attr);
+		case GenericAttributeKind::NUMBER_ARRAY_SIGNED_CHAR:
+			return fromNumberArrayAttribute<signed char>(attr);
+		case GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_CHAR:
+			return fromNumberArrayAttribute<unsigned char>(attr);
+		default:
+			// Types that cannot be represented by Generic
+			return Generic();
 	}
-	return Generic();
 }
 
-Generic fromJSON(std::istream & in) {
-	// To prevent duplicate code, use the existing JSON parser.
-	// Maybe, this can be replaced by a better suited parser in the future.
-	
-	in.seekg(0, std::ios::end);
-	std::string data(static_cast<std::size_t>(in.tellg()), '\0');
-	in.seekg(0, std::ios::beg);
-	in.read(const_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
-
-	JSON_Parser parser;
-	std::unique_ptr<GenericAttribute> attr(parser.parse(data));
+/**
+ * (internal) Build a Generic from the events of JSON_Parser::traverse().
+ * The containers are kept on a stack until they are complete; the values are
+ * moved into their parents, so that nothing is copied.
+ */
+class GenericBuilder : public JSON_Parser::Visitor {
+	private:
+		// long is preferred where it has 64 bits like in JSON_Parser::parse().
+		typedef std::conditional<sizeof(long) >= 8, long, long long>::type integer64_t;
+		typedef std::conditional<sizeof(long) >= 8, unsigned long, unsigned long long>::type unsigned64_t;
 
-	return fromGenericAttribute(attr.get());
-}
+		struct Container {
+			bool isMap;
+			GenericArray array;
+			GenericMap map;
+			//! Key of the next value of a map
+			StringIdentifier key;
+			explicit Container(bool _isMap) : isMap(_isMap), array(), map(), key() {
+			}
+		};
+		std::vector<Container> openContainers;
+		Generic result;
 
-void toJSON(const Generic & data, std::ostream & out) {
-	{
-		auto boolData = data.get<bool>();
-		if(boolData != nullptr) {
-			out << (*boolData ? "true" : "false");
-			return;
+		bool add(Generic && value) {
+			if(openContainers.empty()) {
+				result = std::move(value);
+			} else if(openContainers.back().isMap) {
+				Container & container = openContainers.back();
+				container.map[container.key] = std::move(value);
+			} else {
+				openContainers.back().array.emplace_back(std::move(value));
+			}
+			return true;
 		}
-	}
-	{
-		auto numberData = data.get<double>();
-		if(numberData != nullptr) {
-			out << *numberData;
-			return;
+		//! Add the innermost open container to its parent.
+		bool close() {
+			Container & container = openContainers.back();
+			Generic value = container.isMap ? Generic(std::move(container.map)) : Generic(std::move(container.array));
+			openContainers.pop_back();
+			return add(std::move(value));
 		}
-	}
-	{
-		auto numberData = data.get<float>();
-		if(numberData != nullptr) {
-			out << *numberData;
-			return;
+
+	public:
+		bool enterObject() override {
+			openContainers.emplace_back(true);
+			return true;
 		}
-	}
-	{
-		auto numberData = data.get<long>();
-		if(numberData != nullptr) {
-			out << *numberData;
-			return;
+		bool leaveObject() override								{	return close();	}
+		bool enterArray() override {
+			openContainers.emplace_back(false);
+			return true;
 		}
-	}
-	{
-		auto numberData = data.get<unsigned long>();
-		if(numberData != nullptr) {
-			out << *numberData;
-			return;
+		bool leaveArray() override								{	return close();	}
+		bool visitKey(const std::string & key) override {
+			openContainers.back().key = StringIdentifier(key.data(), key.size());
+			return true;
 		}
-	}
-	{
-		auto numberData = data.get<int>();
-		if(numberData != nullptr) {
-			out << *numberData;
-			return;
+		bool visitString(const std::string & value) override	{	return add(Generic(value));	}
+		bool visitNumber(double value) override					{	return add(Generic(value));	}
+		bool visitInteger(long long value) override {
+			if(value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()) {
+				return add(Generic(static_cast<int>(value)));
+			}
+			return add(Generic(static_cast<integer64_t>(value)));
 		}
-	}
-	{
-		auto numberData = data.get<unsigned int>();
-		if(numberData != nullptr) {
-			out << *numberData;
-			return;
+		bool visitUnsignedInteger(unsigned long long value) override	{	return add(Generic(static_cast<unsigned64_t>(value)));	}
+		bool visitBool(bool value) override						{	return add(Generic(value));	}
+		bool visitNull() override								{	return add(Generic());	}
+
+		/**
+		 * Return the built Generic. Like JSON_Parser::parse(), the part that
+		 * has been read from invalid data is returned.
+		 */
+		Generic finish() {
+			while(!openContainers.empty()) {
+				close();
+			}
+			return std::move(result);
 		}
-	}
-	{
-		auto numberData = data.get<short>();
-		if(numberData != nullptr) {
-			out << *numberData;
-			return;
+};
+
+Generic fromJSON(std::istream & in) {
+	GenericBuilder builder;
+	JSON_Parser::traverse(in, builder);
+	return builder.finish();
+}
+
+/**
+ * (internal) Write JSON text to a buffer that is passed to the stream in
+ * large blocks instead of writing every token to the stream.
+ */
+class JSONWriter {
+	private:
+		static const std::size_t FLUSH_SIZE = 64 * 1024;
+
+		std::ostream & out;
+		std::string buffer;
+
+		template<typename Number>
+		bool writeNumber(const Generic & data) {
+			if(data.getType() != typeid(Number)) {
+				return false;
+			}
+			char digits[StringUtils::MAX_NUMBER_LENGTH];
+			buffer.append(digits, StringUtils::formatNumber(digits, *data.get<Number>()));
+			return true;
 		}
-	}
-	{
-		auto numberData = data.get<unsigned short>();
-		if(numberData != nullptr) {
-			out << *numberData;
-			return;
+
+		//! Write the array if @p data contains a std::vector<Number>.
+		template<typename Number>
+		bool writeNumberArray(const Generic & data) {
+			if(data.getType() != typeid(std::vector<Number>)) {
+				return false;
+			}
+			const std::vector<Number> & numbers = *data.get<std::vector<Number>>();
+			char digits[StringUtils::MAX_NUMBER_LENGTH];
+			buffer += '[';
+			for(std::size_t i = 0; i < numbers.size(); ++i) {
+				if(i != 0) {
+					buffer += ',';
+				}
+				buffer.append(digits, StringUtils::formatNumber(digits, numbers[i]));
+				flushIfFull();
+			}
+			buffer += ']';
+			return true;
 		}
-	}
-	{
-		auto numberData = data.get<char>();
-		if(numberData != nullptr) {
-			out << static_cast<short>(*numberData);
-			return;
+
+		void writeString(const std::string & str) {
+			buffer += '"';
+			StringUtils::appendEscaped(buffer, str.data(), str.size());
+			buffer += '"';
 		}
-	}
-	{
-		auto numberData = data.get<unsigned char>();
-		if(numberData != nullptr) {
-			out << static_cast<unsigned short>(*numberData);
-			return;
+
+		void flushIfFull() {
+			if(buffer.size() >= FLUSH_SIZE) {
+				flush();
+			}
 		}
-	}
-	{
-		auto stringData = data.get<std::string>();
-		if(stringData != nullptr) {
-			out << '"' << Util::StringUtils::escape(*stringData) << '"';
-			return;
+
+	public:
+		explicit JSONWriter(std::ostream & _out) : out(_out), buffer() {
+			buffer.reserve(FLUSH_SIZE + 1024);
 		}
-	}
-	{
-		auto arrayData = data.get<GenericArray>();
-		if(arrayData != nullptr) {
-			out << '[';
-			bool first = true;
-			for(const auto & element : *arrayData) {
-				if(first) {
-					first = false;
-				} else {
-					out << ",";
-				}
-				toJSON(element, out);
-			}
-			out << ']';
-			return;
+
+		void flush() {
+			out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			buffer.clear();
 		}
-	}
-	{
-		auto mapData = data.get<GenericMap>();
-		if(mapData != nullptr) {
-			out << '{';
-			bool first = true;
-			for(const auto & element : *mapData) {
-				if(first) {
-					first = false;
-				} else {
-					out << ",";
+
+		//! Append the JSON representation of @p data. Types that cannot be represented are skipped.
+		void write(const Generic & data) {
+			const std::type_info & type = data.getType();
+			if(type == typeid(GenericMap)) {
+				buffer += '{';
+				bool first = true;
+				for(const auto & element : *data.get<GenericMap>()) {
+					if(first) {
+						first = false;
+					} else {
+						buffer += ',';
+					}
+					writeString(element.first.toString());
+					buffer += ':';
+					write(element.second);
+					flushIfFull();
 				}
-				out << '"' << Util::StringUtils::escape(element.first.toString()) << "\":";
-				toJSON(element.second, out);
+				buffer += '}';
+			} else if(type == typeid(GenericArray)) {
+				buffer += '[';
+				bool first = true;
+				for(const auto & element : *data.get<GenericArray>()) {
+					if(first) {
+						first = false;
+					} else {
+						buffer += ',';
+					}
+					write(element);
+					flushIfFull();
+				}
+				buffer += ']';
+			} else if(type == typeid(std::string)) {
+				writeString(*data.get<std::string>());
+			} else if(type == typeid(bool)) {
+				buffer += *data.get<bool>() ? "true" : "false";
+			} else if(writeNumber<double>(data) ||
+					writeNumber<float>(data) ||
+					writeNumber<int>(data) ||
+					writeNumber<unsigned int>(data) ||
+					writeNumber<long long>(data) ||
+					writeNumber<unsigned long long>(data) ||
+					writeNumber<long>(data) ||
+					writeNumber<unsigned long>(data) ||
+					writeNumber<short>(data) ||
+					writeNumber<unsigned short>(data) ||
+					writeNumber<char>(data) ||
+					writeNumber<signed char>(data) ||
+					writeNumber<unsigned char>(data)) {
+				return;
+			} else if(writeNumberArray<double>(data) ||
+					writeNumberArray<float>(data) ||
+					writeNumberArray<int>(data) ||
+					writeNumberArray<unsigned int>(data) ||
+					writeNumberArray<short>(data) ||
+					writeNumberArray<unsigned short>(data) ||
+					writeNumberArray<signed char>(data) ||
+					writeNumberArray<unsigned char>(data)) {
+				return;
 			}
-			out << '}';
-			return;
 		}
-	}
+};
+
+void toJSON(const Generic & data, std::ostream & out) {
+	JSONWriter writer(out);
+	writer.write(data);
+	writer.flush();
 }
 
 }
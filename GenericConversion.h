@@ -13,6 +13,7 @@
 
 namespace Util {
 class Generic;
+class GenericAttribute;
 /**
  * @brief Conversion to and from Generic
  * 
@@ -25,15 +26,33 @@ namespace GenericConversion {
 /**
  * Read JavaScript Object Notation (JSON) from the given stream and convert the
  * data to Generic.
+ * Integers are stored exactly as int, or as long (long long where long has
+ * less than 64 bits) or the unsigned type if they exceed int. All other
+ * numbers are stored as double.
+ * The Generic values are created directly while the data is parsed; no
+ * GenericAttributes are created.
  * 
  * @param in Stream containing JSON data
  * @return Generic representation of the JSON data
  */
 UTILAPI Generic fromJSON(std::istream & in);
 
+/**
+ * Convert the given generic attribute tree to Generic. Lists become
+ * std::vector<Generic>, maps std::unordered_map<StringIdentifier, Generic>,
+ * and NumberArrayAttributes a std::vector of their number type. Attributes of
+ * other types result in an invalid Generic.
+ *
+ * @param attr Root of the tree; may be nullptr
+ * @return Generic representation of the attributes
+ */
+UTILAPI Generic fromGenericAttribute(const GenericAttribute * attr);
+
 /**
  * Convert the given data to JavaScript Object Notation (JSON) and write it to
- * the given stream.
+ * the given stream. Floating-point numbers are written with the shortest
+ * representation that is read back as the same value. The text is written in
+ * large blocks.
  * 
  * @param data Generic representation of the data
  * @param out Stream to which the JSON data will be written
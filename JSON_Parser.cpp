@@ -11,195 +11,567 @@
 #include "JSON_Parser.h"
 #include "GenericAttribute.h"
 #include "Macros.h"
+#include "StringIdentifier.h"
+#include "StringUtils.h"
 
 #include <cctype>
-#include <sstream>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTIL_JSON_SSE2
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define UTIL_JSON_AVX2
+#endif
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace Util {
 
-struct JSON_Token {
-	enum token_t {
-		T_UNDEFINED, T_NUMBER, T_STRING, T_TRUE, T_FALSE, T_NULL,
-		T_MAP_OPEN, T_MAP_COLON, T_MAP_CLOSE,
-		T_ARRAY_OPEN, T_ARRAY_CLOSE, T_DELIMITER
-	} type;
-	union {
-		float floatValue;
-		std::string * stringPtr;
-	};
-	JSON_Token(token_t _type) : type(_type), stringPtr(nullptr) {
+/*
+ * Scanning of JSON data
+ *
+ * The functions return the first position in [cursor, end) that is a quote or
+ * backslash (findStringSpecial), or that is no white space (skipSpace), or end.
+ * findStringSpecial also sets nonAscii if it passes a byte that is no ASCII
+ * character, so that only those strings have to be validated as UTF-8.
+ * The vectorized versions classify 64 bytes at a time. The versions for the
+ * processor are chosen at runtime.
+ */
+static bool isSpace(char c) {
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+static const char * findStringSpecialScalar(const char * cursor, const char * end, bool & nonAscii) {
+	char highBits = 0;
+	while(cursor != end && *cursor != '"' && *cursor != '\\') {
+		highBits |= *cursor;
+		++cursor;
 	}
-	JSON_Token(float number) : type(T_NUMBER), floatValue(number) {
+	nonAscii = nonAscii || (highBits & 0x80) != 0;
+	return cursor;
+}
+static const char * skipSpaceScalar(const char * cursor, const char * end) {
+	while(cursor != end && isSpace(*cursor)) {
+		++cursor;
 	}
-	JSON_Token(const std::string & s, token_t _type = T_STRING) : type(_type), stringPtr(new std::string(s)) {
+	return cursor;
+}
+
+#if defined(UTIL_JSON_SSE2)
+static unsigned int countTrailingZeros(uint64_t mask) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	if(_BitScanForward(&index, static_cast<unsigned long>(mask))) {
+		return index;
 	}
-	JSON_Token(const JSON_Token &) = delete;
-	JSON_Token(JSON_Token && other) : type(other.type) {
-		if(other.type == T_NUMBER) {
-			floatValue = other.floatValue;
-		} else {
-			stringPtr = other.stringPtr;
-			other.stringPtr = nullptr;
-		}
+	_BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+	return index + 32;
+#else
+	return static_cast<unsigned int>(__builtin_ctzll(mask));
+#endif
+}
+
+static __m128i matchStringSpecialSSE2(__m128i chunk) {
+	return _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+}
+static __m128i matchSpaceSSE2(__m128i chunk) {
+	// '\t' to '\r' are the bytes that are at most four after subtracting '\t'.
+	const __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+	const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+	return _mm_or_si128(control, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')));
+}
+//! One bit for every of the 64 bytes at @p cursor that matches.
+template<__m128i (*match)(__m128i)>
+static uint64_t getMaskSSE2(const char * cursor) {
+	uint64_t mask = 0;
+	for(unsigned int i = 0; i < 4; ++i) {
+		const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cursor + 16 * i));
+		mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(match(chunk)))) << (16 * i);
 	}
-	~JSON_Token() {
-		if(type == T_STRING || type == T_UNDEFINED) {
-			delete stringPtr;
-		}
+	return mask;
+}
+/**
+ * Return the position of the first special byte in a block of 64 bytes, or
+ * nullptr if there is none; record the non-ASCII bytes in front of it.
+ */
+static const char * findInBlock(const char * cursor, uint64_t specialMask, uint64_t nonAsciiMask, bool & nonAscii) {
+	if(specialMask == 0) {
+		nonAscii = nonAscii || nonAsciiMask != 0;
+		return nullptr;
 	}
-	JSON_Token & operator=(const JSON_Token &) = delete;
-	JSON_Token & operator=(JSON_Token && other) {
-		// Handle self-assignment.
-		if(this == &other) {
-			return *this;
+	const unsigned int position = countTrailingZeros(specialMask);
+	nonAscii = nonAscii || (nonAsciiMask & ((static_cast<uint64_t>(1) << position) - 1)) != 0;
+	return cursor + position;
+}
+static const char * findStringSpecialSSE2(const char * cursor, const char * end, bool & nonAscii) {
+	for(; end - cursor >= 64; cursor += 64) {
+		uint64_t specialMask = 0;
+		uint64_t nonAsciiMask = 0;
+		for(unsigned int i = 0; i < 4; ++i) {
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cursor + 16 * i));
+			specialMask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(matchStringSpecialSSE2(chunk)))) << (16 * i);
+			nonAsciiMask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(chunk))) << (16 * i);
 		}
-		if(type == T_STRING || type == T_UNDEFINED) {
-			delete stringPtr;
+		const char * special = findInBlock(cursor, specialMask, nonAsciiMask, nonAscii);
+		if(special != nullptr) {
+			return special;
 		}
-		stringPtr = nullptr;
-		type = other.type;
-		if(other.type == T_NUMBER) {
-			floatValue = other.floatValue;
-		} else {
-			stringPtr = other.stringPtr;
-			other.stringPtr = nullptr;
+	}
+	return findStringSpecialScalar(cursor, end, nonAscii);
+}
+static const char * skipSpaceSSE2(const char * cursor, const char * end) {
+	// Most tokens are not preceded by white space.
+	if(cursor != end && !isSpace(*cursor)) {
+		return cursor;
+	}
+	for(; end - cursor >= 64; cursor += 64) {
+		const uint64_t mask = ~getMaskSSE2<matchSpaceSSE2>(cursor);
+		if(mask != 0) {
+			return cursor + countTrailingZeros(mask);
 		}
-		return *this;
 	}
-	std::string getString() const {
-		return (type == T_STRING && stringPtr != nullptr) ? std::string(*stringPtr) : "";
+	return skipSpaceScalar(cursor, end);
+}
+#endif
+
+#if defined(UTIL_JSON_AVX2)
+__attribute__((target("avx2")))
+static uint64_t getStringSpecialMaskAVX2(const char * cursor, uint64_t & nonAsciiMask) {
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cursor));
+	const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cursor + 32));
+	const uint32_t lowMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(low, quote), _mm256_cmpeq_epi8(low, backslash))));
+	const uint32_t highMask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(high, quote), _mm256_cmpeq_epi8(high, backslash))));
+	nonAsciiMask = static_cast<uint32_t>(_mm256_movemask_epi8(low)) | (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(high))) << 32);
+	return lowMask | (static_cast<uint64_t>(highMask) << 32);
+}
+__attribute__((target("avx2")))
+static uint64_t getSpaceMaskAVX2(const char * cursor) {
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i controlRange = _mm256_set1_epi8('\r' - '\t');
+	const __m256i space = _mm256_set1_epi8(' ');
+	uint64_t mask = 0;
+	for(unsigned int i = 0; i < 2; ++i) {
+		const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cursor + 32 * i));
+		const __m256i shifted = _mm256_sub_epi8(chunk, tab);
+		const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, controlRange), shifted);
+		const __m256i matches = _mm256_or_si256(control, _mm256_cmpeq_epi8(chunk, space));
+		mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(matches))) << (32 * i);
+	}
+	return mask;
+}
+__attribute__((target("avx2")))
+static const char * findStringSpecialAVX2(const char * cursor, const char * end, bool & nonAscii) {
+	for(; end - cursor >= 64; cursor += 64) {
+		uint64_t nonAsciiMask;
+		const uint64_t specialMask = getStringSpecialMaskAVX2(cursor, nonAsciiMask);
+		const char * special = findInBlock(cursor, specialMask, nonAsciiMask, nonAscii);
+		if(special != nullptr) {
+			return special;
+		}
 	}
+	return findStringSpecialScalar(cursor, end, nonAscii);
+}
+__attribute__((target("avx2")))
+static const char * skipSpaceAVX2(const char * cursor, const char * end) {
+	if(cursor != end && !isSpace(*cursor)) {
+		return cursor;
+	}
+	for(; end - cursor >= 64; cursor += 64) {
+		const uint64_t mask = ~getSpaceMaskAVX2(cursor);
+		if(mask != 0) {
+			return cursor + countTrailingZeros(mask);
+		}
+	}
+	return skipSpaceScalar(cursor, end);
+}
+#endif
+
+//! (internal) Scanning functions for the processor
+struct JSON_Scanner {
+	const char * (*findStringSpecial)(const char *, const char *, bool &);
+	const char * (*skipSpace)(const char *, const char *);
 };
-typedef std::vector<JSON_Token> tokenArray_t;
+static JSON_Scanner createScanner() {
+#if defined(UTIL_JSON_AVX2)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")) {
+		return JSON_Scanner{findStringSpecialAVX2, skipSpaceAVX2};
+	}
+#endif
+#if defined(UTIL_JSON_SSE2)
+	return JSON_Scanner{findStringSpecialSSE2, skipSpaceSSE2};
+#else
+	return JSON_Scanner{findStringSpecialScalar, skipSpaceScalar};
+#endif
+}
+static const JSON_Scanner & getScanner() {
+	static const JSON_Scanner scanner = createScanner();
+	return scanner;
+}
 
 /**
- * (internal) Convert a string into an array of tokens.
+ * (internal) Reads the tokens of JSON data one after another, either from a
+ * string or in chunks from a stream. Only the current token is stored.
  * \note escaped unicode characters are not supported.
  */
-static tokenArray_t tokenize(const std::string & input) {
-	tokenArray_t tokens;
-	std::istringstream iss (input);
-	while (  iss.good() ) {
-		char c = static_cast<char>(iss.peek());
+class JSON_Reader {
+	public:
+		enum token_t {
+			T_END, T_UNDEFINED, T_NUMBER, T_STRING, T_TRUE, T_FALSE, T_NULL,
+			T_MAP_OPEN, T_MAP_COLON, T_MAP_CLOSE,
+			T_ARRAY_OPEN, T_ARRAY_CLOSE, T_DELIMITER
+		};
+
+	private:
+		static const std::size_t CHUNK_SIZE = 64 * 1024;
+
+		const JSON_Scanner scanner;
+		std::istream * stream;
+		std::vector<char> chunk;
+		const char * cursor;
+		const char * end;
 
-		// skip spaces
-		if (isspace(c)) {
-			iss.get();
-			continue;
+		token_t type;
+		//! Characters of the current token; the buffer is reused for all tokens.
+		std::string text;
+		//! True if the current number token has neither a fraction nor an exponent.
+		bool integer;
+		//! Number of strings that are not valid UTF-8; they are reported once when reading ends.
+		std::size_t invalidStringCount;
+
+		//! Read the next chunk from the stream. Return false at the end of the input.
+		bool refill() {
+			if(stream == nullptr || !stream->good()) {
+				return false;
+			}
+			stream->read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+			cursor = chunk.data();
+			end = cursor + stream->gcount();
+			return cursor != end;
 		}
-		// read constants (true,false,null)
-		else if (isalpha(c)) {
-			std::string s;
-			while (iss.good() && isalnum(c)) {
-				s+=c;
-				iss.get();
-				c = static_cast<char>(iss.peek());
+		bool hasMore() {
+			return cursor != end || refill();
+		}
+		//! Stop reading; all following tokens are T_END.
+		void finish() {
+			cursor = end;
+			stream = nullptr;
+			type = T_END;
+		}
+		static bool isAlpha(char c)	{	return std::isalpha(static_cast<unsigned char>(c)) != 0;	}
+		static bool isAlnum(char c)	{	return std::isalnum(static_cast<unsigned char>(c)) != 0;	}
+		static bool isDigit(char c)	{	return c >= '0' && c <= '9';	}
+
+		//! Append the characters for which @p accept returns true.
+		void appendWhile(bool (*accept)(char)) {
+			while(hasMore()) {
+				const char * runEnd = cursor;
+				while(runEnd != end && accept(*runEnd)) {
+					++runEnd;
+				}
+				text.append(cursor, runEnd);
+				cursor = runEnd;
+				if(cursor != end) {
+					return;
+				}
 			}
-			if(s == "true") {
-				tokens.push_back(JSON_Token(JSON_Token::T_TRUE));
-			} else if(s == "false") {
-				tokens.push_back(JSON_Token(JSON_Token::T_FALSE));
-			} else if(s == "null") {
-				tokens.push_back(JSON_Token(JSON_Token::T_NULL));
+		}
+		void appendDigits() {
+			appendWhile(isDigit);
+		}
+
+		//! Read a constant (true, false, null).
+		void readWord() {
+			text.clear();
+			appendWhile(isAlnum);
+			if(text == "true") {
+				type = T_TRUE;
+			} else if(text == "false") {
+				type = T_FALSE;
+			} else if(text == "null") {
+				type = T_NULL;
 			} else {
-				tokens.push_back(JSON_Token(s, JSON_Token::T_UNDEFINED));
+				type = T_UNDEFINED;
 			}
-			continue;
-		// read number
-		} else if (isdigit(c) || c=='-') {
-			float f;
-			iss >> f;
-			tokens.push_back(JSON_Token(f));
-			continue;
-		// read string
-		} else if ( c=='"') {
-			std::string s;
-			iss.get();
-			c=iss.peek();
-			while (iss.good() && c!='"') {
-				if (c=='\\') { // escape sequence
-					iss.get();
-					c = static_cast<char>(iss.peek());
-					switch (c) {
-						case 'b':	s+='\b';	break;
-						case 'f':	s+='\f';	break;
-						case 'n':	s+='\n';	break;
-						case 'r':	s+='\r';	break;
-						case 't':	s+='\t';	break;
-						default:	s+=c;		break;
-					}
-					iss.get();
-					c = static_cast<char>(iss.peek());
+		}
+
+		void readNumber() {
+			text.clear();
+			if(*cursor == '-') {
+				text.push_back(*cursor++);
+			}
+			appendDigits();
+			integer = true;
+			if(hasMore() && *cursor == '.') {
+				integer = false;
+				text.push_back(*cursor++);
+				appendDigits();
+			}
+			if(hasMore() && (*cursor == 'e' || *cursor == 'E')) {
+				integer = false;
+				text.push_back(*cursor++);
+				if(hasMore() && (*cursor == '+' || *cursor == '-')) {
+					text.push_back(*cursor++);
+				}
+				appendDigits();
+			}
+			if(text.find_first_of("0123456789") == std::string::npos) {
+				// An invalid number ends the input.
+				finish();
+				return;
+			}
+			type = T_NUMBER;
+		}
+
+		void readString() {
+			text.clear();
+			++cursor;
+			// Only strings containing non-ASCII characters have to be validated.
+			bool nonAscii = false;
+			while(hasMore()) {
+				// Copy the characters up to the next quote or escape sequence at once.
+				const char * plainEnd = scanner.findStringSpecial(cursor, end, nonAscii);
+				text.append(cursor, plainEnd);
+				cursor = plainEnd;
+				if(cursor == end) {
 					continue;
 				}
-				s+=c;
-				iss.get();
-				c = static_cast<char>(iss.peek());
+				if(*cursor++ == '"') {
+					type = T_STRING;
+					// Invalid strings are kept, but reported.
+					if(nonAscii && !StringUtils::isValidUTF8(text)) {
+						++invalidStringCount;
+					}
+					return;
+				}
+				if(!hasMore()) {
+					break;
+				}
+				switch(*cursor) {
+					case 'b':	text += '\b';		break;
+					case 'f':	text += '\f';		break;
+					case 'n':	text += '\n';		break;
+					case 'r':	text += '\r';		break;
+					case 't':	text += '\t';		break;
+					default:	nonAscii = nonAscii || (*cursor & 0x80) != 0;	text += *cursor;	break;
+				}
+				++cursor;
 			}
-			if (c!='"') {
-				tokens.push_back(JSON_Token(s,JSON_Token::T_UNDEFINED));
-				WARN("JSON_Parser: unclosed string '"+s+'\'');
-				continue;
+			type = T_UNDEFINED;
+			WARN("JSON_Parser: unclosed string '" + text + '\'');
+		}
+
+	public:
+		JSON_Reader(const char * begin, const char * _end) :
+				scanner(getScanner()), stream(nullptr), chunk(), cursor(begin), end(_end), type(T_END), text(), integer(false), invalidStringCount(0) {
+			next();
+		}
+		explicit JSON_Reader(std::istream & in) :
+				scanner(getScanner()), stream(&in), chunk(CHUNK_SIZE), cursor(nullptr), end(nullptr), type(T_END), text(), integer(false), invalidStringCount(0) {
+			next();
+		}
+		~JSON_Reader() {
+			if(invalidStringCount != 0) {
+				WARN("JSON_Parser: " + StringUtils::toString(invalidStringCount) + " string(s) are not valid UTF-8.");
 			}
-			iss.get();
-			tokens.push_back(JSON_Token(s));
-			continue;
 		}
-		// read single char token
-		iss.get();
-		if(iss.fail()) {
-			break;
+
+		token_t getType() const				{	return type;	}
+
+		enum integer_t {
+			NO_INTEGER, SIGNED_INTEGER, UNSIGNED_INTEGER
+		};
+		/**
+		 * Read the current number token exactly if it is written as an integer.
+		 * @return SIGNED_INTEGER if the value fits into @p signedValue,
+		 * UNSIGNED_INTEGER if it only fits into @p unsignedValue, and
+		 * NO_INTEGER for other numbers, which have to be read with getNumber().
+		 */
+		integer_t getInteger(long long & signedValue, unsigned long long & unsignedValue) const {
+			if(!integer) {
+				return NO_INTEGER;
+			}
+			const bool negative = text[0] == '-';
+			unsigned long long magnitude = 0;
+			for(std::size_t i = negative ? 1 : 0; i < text.size(); ++i) {
+				const unsigned long long digit = static_cast<unsigned long long>(text[i] - '0');
+				if(magnitude > (std::numeric_limits<unsigned long long>::max() - digit) / 10) {
+					return NO_INTEGER;
+				}
+				magnitude = magnitude * 10 + digit;
+			}
+			const unsigned long long maxSigned = static_cast<unsigned long long>(std::numeric_limits<long long>::max());
+			if(!negative) {
+				if(magnitude > maxSigned) {
+					unsignedValue = magnitude;
+					return UNSIGNED_INTEGER;
+				}
+				signedValue = static_cast<long long>(magnitude);
+			} else if(magnitude <= maxSigned) {
+				signedValue = -static_cast<long long>(magnitude);
+			} else if(magnitude == maxSigned + 1) {
+				signedValue = std::numeric_limits<long long>::min();
+			} else {
+				return NO_INTEGER;
+			}
+			return SIGNED_INTEGER;
 		}
+		//! Value of a number token; it is converted on request only.
+		template<typename Number>
+		Number getNumber() const {
+			Number number;
+			StringUtils::parseFloat(text.data(), text.data() + text.size(), number);
+			return number;
+		}
+		const std::string & getText() const	{	return text;	}
+		//! Take the characters of the current token without copying them.
+		std::string takeText()				{	return std::move(text);	}
 
-		switch (c) {
-			case '[':	tokens.push_back(JSON_Token(JSON_Token::T_ARRAY_OPEN));     continue;
-			case ']':	tokens.push_back(JSON_Token(JSON_Token::T_ARRAY_CLOSE));    continue;
-			case '{':	tokens.push_back(JSON_Token(JSON_Token::T_MAP_OPEN));       continue;
-			case '}':	tokens.push_back(JSON_Token(JSON_Token::T_MAP_CLOSE));      continue;
-			case ':':	tokens.push_back(JSON_Token(JSON_Token::T_MAP_COLON));      continue;
-			case ',':	tokens.push_back(JSON_Token(JSON_Token::T_DELIMITER));      continue;
-			default:
-				tokens.push_back(JSON_Token(std::string(1, c), JSON_Token::T_UNDEFINED));
-				WARN("JSON_Parser: Unknown character.");
+		//! Advance to the next token.
+		void next() {
+			do {
+				cursor = scanner.skipSpace(cursor, end);
+			} while(cursor == end && refill());
+			if(cursor == end) {
+				type = T_END;
+				return;
+			}
+			const char c = *cursor;
+			if(isAlpha(c)) {
+				readWord();
+				return;
+			} else if(isDigit(c) || c == '-') {
+				readNumber();
+				return;
+			} else if(c == '"') {
+				readString();
+				return;
+			}
+			++cursor;
+			switch(c) {
+				case '[':	type = T_ARRAY_OPEN;	return;
+				case ']':	type = T_ARRAY_CLOSE;	return;
+				case '{':	type = T_MAP_OPEN;		return;
+				case '}':	type = T_MAP_CLOSE;		return;
+				case ':':	type = T_MAP_COLON;		return;
+				case ',':	type = T_DELIMITER;		return;
+				default:
+					type = T_UNDEFINED;
+					text.assign(1, c);
+					WARN("JSON_Parser: Unknown character.");
+			}
 		}
+};
+
+/**
+ * (internal) Create the slot for a number token. Integers are stored exactly
+ * with the smallest of the types int, 64-bit signed and 64-bit unsigned
+ * integer that holds the value; values in the range of int are stored inline.
+ * Other numbers and integers beyond 64 bits become doubles.
+ */
+static GenericAttributeSlot getNumberSlot(const JSON_Reader & reader) {
+	// long is preferred where it has 64 bits, because it is supported by all conversions.
+	typedef std::conditional<sizeof(long) >= sizeof(int64_t), long, long long>::type signed_t;
+	typedef std::conditional<sizeof(long) >= sizeof(int64_t), unsigned long, unsigned long long>::type unsigned_t;
+
+	long long signedValue;
+	unsigned long long unsignedValue;
+	switch(reader.getInteger(signedValue, unsignedValue)) {
+		case JSON_Reader::SIGNED_INTEGER:
+			if(signedValue >= std::numeric_limits<int>::min() && signedValue <= std::numeric_limits<int>::max()) {
+				return GenericAttributeSlot::createNumber(static_cast<int>(signedValue));
+			}
+			return GenericAttributeSlot::createNumber(static_cast<signed_t>(signedValue));
+		case JSON_Reader::UNSIGNED_INTEGER:
+			return GenericAttributeSlot::createNumber(static_cast<unsigned_t>(unsignedValue));
+		default:
+			return GenericAttributeSlot::createNumber(reader.getNumber<double>());
 	}
-	return tokens;
 }
 
-//! (internal) Convert an array of tokens into a GenericAttribute.
-static GenericAttribute * getGenericAttribute(const tokenArray_t & tokens, tokenArray_t::const_iterator & it) {
-	if(it == tokens.end()) {
-		return nullptr;
+/**
+ * (internal) Create the slot of a container element for a scalar token without
+ * allocating a GenericAttribute and advance to the next token.
+ * Return false if the token is no scalar.
+ */
+static bool getScalarSlot(JSON_Reader & reader, GenericAttributeSlot & slot) {
+	switch(reader.getType()) {
+		case JSON_Reader::T_NUMBER:
+			slot = getNumberSlot(reader);
+			break;
+		case JSON_Reader::T_STRING:
+			if(reader.getText().size() > GenericAttributeSlot::MAX_INLINE_STRING_LENGTH) {
+				slot.reset(GenericAttribute::createString(reader.takeText()));
+			} else {
+				slot = GenericAttributeSlot::createString(reader.getText());
+			}
+			break;
+		case JSON_Reader::T_TRUE:
+			slot = GenericAttributeSlot::createBool(true);
+			break;
+		case JSON_Reader::T_FALSE:
+			slot = GenericAttributeSlot::createBool(false);
+			break;
+		default:
+			return false;
 	}
-	const JSON_Token & t = *it;
-	++it;
-	switch (t.type) {
-		case JSON_Token::T_NUMBER:  return GenericAttribute::createNumber<float>(t.floatValue);
-		case JSON_Token::T_STRING:  return GenericAttribute::createString(t.getString());
-		case JSON_Token::T_TRUE:    return GenericAttribute::createBool(true);
-		case JSON_Token::T_FALSE:   return GenericAttribute::createBool(false);
-		case JSON_Token::T_NULL:    return GenericAttribute::createUndefined<void *>(nullptr);
-		case JSON_Token::T_ARRAY_OPEN:  {
+	reader.next();
+	return true;
+}
+
+//! (internal) Convert the tokens starting with the current one into a GenericAttribute.
+static GenericAttribute * getGenericAttribute(JSON_Reader & reader) {
+	switch(reader.getType()) {
+		case JSON_Reader::T_END:
+			return nullptr;
+		case JSON_Reader::T_NUMBER:
+		case JSON_Reader::T_STRING:
+		case JSON_Reader::T_TRUE:
+		case JSON_Reader::T_FALSE: {
+				GenericAttributeSlot scalar;
+				getScalarSlot(reader, scalar);
+				return scalar.release();
+			}
+		case JSON_Reader::T_NULL:
+			reader.next();
+			return GenericAttribute::createUndefined<void *>(nullptr);
+		case JSON_Reader::T_ARRAY_OPEN: {
+				reader.next();
 				auto l = new GenericAttributeList;
 				while (true) {
-					if (it==tokens.end()) {
+					if (reader.getType()==JSON_Reader::T_END) {
 						WARN("JSON_Parser: Unclosed array.");
 						break;
-					} else if (it->type==JSON_Token::T_ARRAY_CLOSE) {
-						++it;
+					} else if (reader.getType()==JSON_Reader::T_ARRAY_CLOSE) {
+						reader.next();
 						break;
 					}
-					GenericAttribute * a=getGenericAttribute(tokens,it);
-					if (a==nullptr) {
-						WARN("JSON_Parser: Error in array (1).");
-						break;
+					GenericAttributeSlot scalar;
+					if (getScalarSlot(reader, scalar)) {
+						l->push_back(std::move(scalar));
+					} else {
+						GenericAttribute * a=getGenericAttribute(reader);
+						if (a==nullptr) {
+							WARN("JSON_Parser: Error in array (1).");
+							break;
+						}
+						l->push_back(a);
 					}
-					l->push_back(a);
-					if (it==tokens.end() || it->type==JSON_Token::T_ARRAY_CLOSE) {
+					if (reader.getType()==JSON_Reader::T_END || reader.getType()==JSON_Reader::T_ARRAY_CLOSE) {
 						continue;
-					} else if (it->type==JSON_Token::T_DELIMITER) { // this allows [1,2,]
-						++it;
+					} else if (reader.getType()==JSON_Reader::T_DELIMITER) { // this allows [1,2,]
+						reader.next();
 						continue;
 					} else {
 						WARN("JSON_Parser: Error in array (2). Delimiter expected!");
@@ -208,37 +580,43 @@ static GenericAttribute * getGenericAttribute(const tokenArray_t & tokens, token
 				}
 				return l;
 			}
-		case JSON_Token::T_MAP_OPEN:  {
+		case JSON_Reader::T_MAP_OPEN: {
+				reader.next();
 				auto m = new GenericAttributeMap;
 				while (true) {
-					if (it==tokens.end()) {
+					if (reader.getType()==JSON_Reader::T_END) {
 						WARN("JSON_Parser: Unclosed map.");
 						break;
-					} else if (it->type==JSON_Token::T_MAP_CLOSE) {
-						++it;
+					} else if (reader.getType()==JSON_Reader::T_MAP_CLOSE) {
+						reader.next();
 						break;
-					} else if ( it->type != JSON_Token::T_STRING) {
+					} else if (reader.getType()!=JSON_Reader::T_STRING) {
 						WARN("JSON_Parser: Key in map is not a string.");
 						break;
 					}
-					std::string key=it->getString();
-					++it;
-					if ( it==tokens.end() || it->type != JSON_Token::T_MAP_COLON) {
+					// The key is hashed directly from the token; no string is allocated.
+					const StringIdentifier key(reader.getText().data(), reader.getText().size());
+					reader.next();
+					if (reader.getType()!=JSON_Reader::T_MAP_COLON) {
 						WARN("JSON_Parser: Expected ':' between key and value-");
 						break;
 					}
-					++it;
-					GenericAttribute * value=getGenericAttribute(tokens,it);
-					if (value==nullptr) {
-						WARN("JSON_Parser: Error in map (1).");
-						break;
+					reader.next();
+					GenericAttributeSlot scalar;
+					if (getScalarSlot(reader, scalar)) {
+						m->setValue(key,std::move(scalar));
+					} else {
+						GenericAttribute * value=getGenericAttribute(reader);
+						if (value==nullptr) {
+							WARN("JSON_Parser: Error in map (1).");
+							break;
+						}
+						m->setValue(key,value);
 					}
-
-					m->setValue(key,value);
-					if (it==tokens.end() || it->type==JSON_Token::T_MAP_CLOSE) {
+					if (reader.getType()==JSON_Reader::T_END || reader.getType()==JSON_Reader::T_MAP_CLOSE) {
 						continue;
-					} else if (it->type==JSON_Token::T_DELIMITER) { // this allows [1,2,]
-						++it;
+					} else if (reader.getType()==JSON_Reader::T_DELIMITER) { // this allows [1,2,]
+						reader.next();
 						continue;
 					} else {
 						WARN("JSON_Parser: Error in map (2). Delimiter expected!");
@@ -247,25 +625,137 @@ static GenericAttribute * getGenericAttribute(const tokenArray_t & tokens, token
 				}
 				return m;
 			}
-		case JSON_Token::T_UNDEFINED:
-		case JSON_Token::T_MAP_COLON:
-		case JSON_Token::T_MAP_CLOSE:
-		case JSON_Token::T_ARRAY_CLOSE:
-		case JSON_Token::T_DELIMITER:
-			WARN("JSON_Parser: Read unexpected token '"+t.getString()+'\'');
-			return nullptr;
 		default: {
-				WARN("JSON_Parser: Read undefined token '"+t.getString()+'\'');
+				WARN("JSON_Parser: Read unexpected token '"+reader.getText()+'\'');
+				reader.next();
 				return nullptr;
 			}
+	}
+}
 
+/**
+ * (internal) Report the value starting with the current token to the visitor.
+ * Return false if the visitor stops the traversal or the data is invalid.
+ */
+static bool traverseValue(JSON_Reader & reader, JSON_Parser::Visitor & visitor) {
+	switch(reader.getType()) {
+		case JSON_Reader::T_NUMBER: {
+				long long signedValue;
+				unsigned long long unsignedValue;
+				bool proceed;
+				switch(reader.getInteger(signedValue, unsignedValue)) {
+					case JSON_Reader::SIGNED_INTEGER:
+						proceed = visitor.visitInteger(signedValue);
+						break;
+					case JSON_Reader::UNSIGNED_INTEGER:
+						proceed = visitor.visitUnsignedInteger(unsignedValue);
+						break;
+					default:
+						proceed = visitor.visitNumber(reader.getNumber<double>());
+				}
+				if(!proceed) {
+					return false;
+				}
+				break;
+			}
+		case JSON_Reader::T_STRING:
+			if(!visitor.visitString(reader.getText())) {
+				return false;
+			}
+			break;
+		case JSON_Reader::T_TRUE:
+		case JSON_Reader::T_FALSE:
+			if(!visitor.visitBool(reader.getType() == JSON_Reader::T_TRUE)) {
+				return false;
+			}
+			break;
+		case JSON_Reader::T_NULL:
+			if(!visitor.visitNull()) {
+				return false;
+			}
+			break;
+		case JSON_Reader::T_ARRAY_OPEN:
+			if(!visitor.enterArray()) {
+				return false;
+			}
+			reader.next();
+			while(reader.getType() != JSON_Reader::T_ARRAY_CLOSE) {
+				if(!traverseValue(reader, visitor)) {
+					return false;
+				}
+				if(reader.getType() == JSON_Reader::T_DELIMITER) { // this allows [1,2,]
+					reader.next();
+				} else if(reader.getType() != JSON_Reader::T_ARRAY_CLOSE) {
+					WARN("JSON_Parser: Error in array. Delimiter expected!");
+					return false;
+				}
+			}
+			if(!visitor.leaveArray()) {
+				return false;
+			}
+			break;
+		case JSON_Reader::T_MAP_OPEN:
+			if(!visitor.enterObject()) {
+				return false;
+			}
+			reader.next();
+			while(reader.getType() != JSON_Reader::T_MAP_CLOSE) {
+				if(reader.getType() != JSON_Reader::T_STRING) {
+					WARN("JSON_Parser: Key in map is not a string.");
+					return false;
+				}
+				if(!visitor.visitKey(reader.getText())) {
+					return false;
+				}
+				reader.next();
+				if(reader.getType() != JSON_Reader::T_MAP_COLON) {
+					WARN("JSON_Parser: Expected ':' between key and value-");
+					return false;
+				}
+				reader.next();
+				if(!traverseValue(reader, visitor)) {
+					return false;
+				}
+				if(reader.getType() == JSON_Reader::T_DELIMITER) { // this allows {"a":1,}
+					reader.next();
+				} else if(reader.getType() != JSON_Reader::T_MAP_CLOSE) {
+					WARN("JSON_Parser: Error in map. Delimiter expected!");
+					return false;
+				}
+			}
+			if(!visitor.leaveObject()) {
+				return false;
+			}
+			break;
+		case JSON_Reader::T_END:
+			WARN("JSON_Parser: Unexpected end of data.");
+			return false;
+		default:
+			WARN("JSON_Parser: Read unexpected token '"+reader.getText()+'\'');
+			return false;
 	}
+	reader.next();
+	return true;
 }
 
 GenericAttribute * JSON_Parser::parse(const std::string & str) {
-	const tokenArray_t tokens = tokenize(str);
-	auto it = tokens.begin();
-	return getGenericAttribute(tokens, it);
+	JSON_Reader reader(str.data(), str.data() + str.size());
+	return getGenericAttribute(reader);
+}
+
+GenericAttribute * JSON_Parser::parse(std::istream & in) {
+	JSON_Reader reader(in);
+	return getGenericAttribute(reader);
+}
+
+bool JSON_Parser::traverse(const std::string & str, Visitor & visitor) {
+	JSON_Reader reader(str.data(), str.data() + str.size());
+	return traverseValue(reader, visitor);
+}
+
+bool JSON_Parser::traverse(std::istream & in, Visitor & visitor) {
+	JSON_Reader reader(in);
+	return traverseValue(reader, visitor);
 }
 
 }
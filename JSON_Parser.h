@@ -11,6 +11,7 @@
 #ifndef UTIL_JSON_PARSER_H
 #define UTIL_JSON_PARSER_H
 
+#include <iosfwd>
 #include <string>
 
 namespace Util{
@@ -35,8 +36,52 @@ class GenericAttribute;
  */
 class JSON_Parser {
 	public:
+		/**
+		 * Receiver of the events of traverse(). Every function returns
+		 * @c true to continue the traversal, or @c false to stop it.
+		 * The default implementations ignore the event.
+		 */
+		class Visitor {
+			public:
+				virtual ~Visitor() {}
+				virtual bool enterObject()								{	return true;	}
+				virtual bool leaveObject()								{	return true;	}
+				virtual bool enterArray()								{	return true;	}
+				virtual bool leaveArray()								{	return true;	}
+				//! Key of the following value of an object
+				virtual bool visitKey(const std::string & /*key*/)		{	return true;	}
+				virtual bool visitString(const std::string & /*value*/)	{	return true;	}
+				virtual bool visitNumber(double /*value*/)				{	return true;	}
+				/**
+				 * Numbers without fraction and exponent that fit into 64 bits are
+				 * reported exactly; by default, they are passed to visitNumber().
+				 * visitUnsignedInteger() is used for values beyond the range of long long.
+				 */
+				virtual bool visitInteger(long long value)				{	return visitNumber(static_cast<double>(value));	}
+				virtual bool visitUnsignedInteger(unsigned long long value)	{	return visitNumber(static_cast<double>(value));	}
+				virtual bool visitBool(bool /*value*/)					{	return true;	}
+				virtual bool visitNull()								{	return true;	}
+		};
+
 		//! Try to convert a JSON formatted string into a GenericAttribute.
 		UTILAPI static GenericAttribute * parse(const std::string & str);
+
+		/**
+		 * Try to convert JSON data read from a stream into a GenericAttribute.
+		 * The stream is read in chunks, so the data is never stored completely in memory.
+		 * @note Characters following the JSON value may be consumed from the stream.
+		 */
+		UTILAPI static GenericAttribute * parse(std::istream & in);
+
+		/**
+		 * Report the JSON value in the string to the visitor without creating
+		 * GenericAttributes.
+		 * @return @c true if the whole value has been traversed, @c false if
+		 * the visitor stopped the traversal or the data is invalid
+		 */
+		UTILAPI static bool traverse(const std::string & str, Visitor & visitor);
+		//! Report the JSON value read in chunks from the stream to the visitor.
+		UTILAPI static bool traverse(std::istream & in, Visitor & visitor);
 };
 
 }
@@ -72,8 +72,8 @@ void DataConnection::run() {
 				const dataPacket_t & data = kValue.second;
 				
 				const uint16_t channelId = kValue.first.first;
-				const std::string key = kValue.first.second.toString();
-				const uint16_t keyLen = key.length()>0xffff ? 0xffff : static_cast<uint16_t>(key.length());
+				const StringView key = kValue.first.second.toStringView();
+				const uint16_t keyLen = key.size()>0xffff ? 0xffff : static_cast<uint16_t>(key.size());
 				
 				// 4 size, 2 packet type, 2 data type, 2 keyLength, key, data
 				const std::size_t msgSize = (4 + 2 + 2 + 2) + data.size() + keyLen;
@@ -147,7 +147,7 @@ void DataConnection::run() {
 						dataError();
 						return;
 					}
-					const std::string key(std::next(msg.data(),6),std::next(msg.data(),keyEnd) );
+					const StringIdentifier key(reinterpret_cast<const char *>(msg.data() + 6), keyLength);
 					
 					const std::vector<uint8_t> data(std::next(msg.begin(), keyEnd), msg.end());
 					std::lock_guard<std::mutex> lock(incomingKeyValuePairsMutex);
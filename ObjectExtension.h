@@ -121,7 +121,8 @@ extension_t * addObjectExtension(typename std::enable_if<!std::is_polymorphic<ex
 template<typename extension_t> 
 extension_t * getObjectExtension(typename std::enable_if<!std::is_polymorphic<extension_t>::value>::type*,
 								const Util::StringIdentifier & extName,const Util::AttributeProvider * obj){
-	auto attr = obj->getAttribute<Util::WrapperAttribute<extension_t>>(extName);
+	// The extension may be modified, so it must not be shared with copies of the object.
+	auto attr = const_cast<Util::AttributeProvider *>(obj)->getMutableAttribute<Util::WrapperAttribute<extension_t>>(extName);
 	return attr ? &attr->ref() : nullptr;
 }
 // ---------------------------
@@ -151,7 +152,7 @@ extension_t * addObjectExtension(typename std::enable_if<std::is_polymorphic<ext
 template<typename extension_t> 
 extension_t * getObjectExtension(typename std::enable_if<std::is_polymorphic<extension_t>::value>::type*,
 								const Util::StringIdentifier & extName,const Util::AttributeProvider * obj){
-	auto attr = obj->getAttribute<PolymorphicObjectExtensionWrapper<typename extension_t::extentsionBase_t>>(extName);
+	auto attr = const_cast<Util::AttributeProvider *>(obj)->getMutableAttribute<PolymorphicObjectExtensionWrapper<typename extension_t::extentsionBase_t>>(extName);
 	return attr ? attr->ref() : nullptr;
 }
 
@@ -9,66 +9,559 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "StringIdentifier.h"
+#include "Macros.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <istream>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <ostream>
 #include <sstream>
-#include <unordered_map>
+#include <vector>
 
 namespace Util {
 
-typedef std::unordered_map<uint32_t, std::string> stringIdTable_t;
+/*
+ * The lookup table is split into shards selected by the lowest bits of the id.
+ * Each shard stores its entries in an open addressing array of atomic pointers.
+ * Entries are never removed or modified after they have been published, so
+ * readers can search the array without taking the lock of the shard.
+ * Only the insertion of a new entry locks the shard. If the array has to grow,
+ * a new array is published and the old one is kept alive until the end of the
+ * program, because other threads may still be reading it.
+ * The entry stored at the hash value of a string is the first element of a
+ * chain of all strings with that hash value. The other elements of the chain
+ * get numbers with the COLLISION_FLAG that belong to the same shard.
+ * The characters of the strings are stored in an append-only arena per shard.
+ * They never move, so views of them stay valid until the end of the program.
+ */
+namespace {
+
+struct Entry {
+	const uint32_t id;
+	const std::size_t length;
+	//! Null-terminated characters inside the arena of the shard
+	const char * const str;
+	//! Next entry with the same hash value
+	std::atomic<const Entry *> nextCollision;
+	Entry(uint32_t _id, const char * _str, std::size_t _length) : id(_id), length(_length), str(_str), nextCollision(nullptr) {}
+
+	bool equals(const char * otherStr, std::size_t otherLength) const {
+		return length == otherLength && std::memcmp(str, otherStr, length) == 0;
+	}
+};
+
+//! Append-only storage for characters
+class StringArena {
+		static const std::size_t BLOCK_SIZE = 4096;
+		std::vector<std::unique_ptr<char[]>> blocks;
+		char * cursor;
+		std::size_t available;
+	public:
+		StringArena() : cursor(nullptr), available(0) {}
+
+		//! Copy the characters into the arena and append a null character.
+		const char * store(const char * str, std::size_t length) {
+			const std::size_t required = length + 1;
+			char * target;
+			if(required > BLOCK_SIZE / 4) {
+				// Large strings get their own block to not waste the rest of the current one.
+				blocks.emplace_back(new char[required]);
+				target = blocks.back().get();
+			} else {
+				if(required > available) {
+					blocks.emplace_back(new char[BLOCK_SIZE]);
+					cursor = blocks.back().get();
+					available = BLOCK_SIZE;
+				}
+				target = cursor;
+				cursor += required;
+				available -= required;
+			}
+			std::memcpy(target, str, length);
+			target[length] = '\0';
+			return target;
+		}
+};
+
+struct SlotArray {
+	const uint32_t mask;
+	std::unique_ptr<std::atomic<const Entry *>[]> slots;
+
+	explicit SlotArray(uint32_t capacity) : mask(capacity - 1), slots(new std::atomic<const Entry *>[capacity]) {
+		for(uint32_t i = 0; i < capacity; ++i) {
+			slots[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+};
+
+static const uint32_t SHARD_BITS = 6;
+static const uint32_t SHARD_COUNT = 1u << SHARD_BITS;
+static const uint32_t INITIAL_SLOT_COUNT = 16;
+
+class Shard {
+		std::atomic<SlotArray *> slotArray;
+		//! Current and retired slot arrays.
+		std::vector<std::unique_ptr<SlotArray>> slotArrays;
+		//! Storage of the entries; a deque does not move its elements when growing.
+		std::deque<Entry> entries;
+		StringArena arena;
+		//! Number of collision ids that have been assigned in this shard.
+		uint32_t collisionCount;
+
+		static uint32_t getSlotIndex(uint32_t id, uint32_t mask) {
+			return (id >> SHARD_BITS) & mask;
+		}
+		static void insertIntoArray(SlotArray & array, const Entry * entry) {
+			uint32_t index = getSlotIndex(entry->id, array.mask);
+			while(array.slots[index].load(std::memory_order_relaxed) != nullptr) {
+				index = (index + 1) & array.mask;
+			}
+			array.slots[index].store(entry, std::memory_order_release);
+		}
+		//! Publish a new slot array with the given capacity containing all entries.
+		void rebuild(uint32_t capacity) {
+			std::unique_ptr<SlotArray> grownArray(new SlotArray(capacity));
+			for(const auto & entry : entries) {
+				insertIntoArray(*grownArray, &entry);
+			}
+			slotArray.store(grownArray.get(), std::memory_order_release);
+			slotArrays.emplace_back(std::move(grownArray));
+		}
+	public:
+		//! Has to be locked for inserting entries.
+		std::mutex mutex;
+
+		Shard() : slotArray(nullptr), collisionCount(0) {
+			slotArrays.emplace_back(new SlotArray(INITIAL_SLOT_COUNT));
+			slotArray.store(slotArrays.back().get(), std::memory_order_release);
+		}
+
+		//! Lock-free search for the entry with the given id.
+		const Entry * find(uint32_t id) const {
+			const SlotArray * array = slotArray.load(std::memory_order_acquire);
+			// The load factor is kept below one half; there always is an empty slot.
+			for(uint32_t index = getSlotIndex(id, array->mask); ; index = (index + 1) & array->mask) {
+				const Entry * entry = array->slots[index].load(std::memory_order_acquire);
+				if(entry == nullptr || entry->id == id) {
+					return entry;
+				}
+			}
+		}
+
+		//! Insert a new entry. The mutex has to be locked by the caller.
+		const Entry * insert(uint32_t id, const char * str, std::size_t length) {
+			return insertStored(id, arena.store(str, length), length);
+		}
+
+		/**
+		 * Insert a new entry for null-terminated characters that stay valid
+		 * until the end of the program. The mutex has to be locked by the caller.
+		 */
+		const Entry * insertStored(uint32_t id, const char * str, std::size_t length) {
+			entries.emplace_back(id, str, length);
+			const Entry * entry = &entries.back();
+			SlotArray * array = slotArray.load(std::memory_order_relaxed);
+			if(2 * entries.size() > array->mask + 1) {
+				rebuild(2 * (array->mask + 1));
+			} else {
+				insertIntoArray(*array, entry);
+			}
+			return entry;
+		}
+
+		/**
+		 * Make sure that @p additionalCount entries can be inserted without
+		 * growing the slot array. The mutex has to be locked by the caller.
+		 */
+		void reserve(std::size_t additionalCount) {
+			const SlotArray * array = slotArray.load(std::memory_order_relaxed);
+			uint32_t capacity = array->mask + 1;
+			while(2 * (entries.size() + additionalCount) > capacity) {
+				capacity *= 2;
+			}
+			if(capacity != array->mask + 1) {
+				rebuild(capacity);
+			}
+		}
+
+		const std::deque<Entry> & getEntries() const {
+			return entries;
+		}
+
+		/**
+		 * Add the values of this shard to the statistics.
+		 * Every entry needs as many string comparisons as its position in its chain.
+		 */
+		void collectStatistics(StringIdentifier::Statistics & statistics, std::size_t & probeSum) {
+			std::lock_guard<std::mutex> lock(mutex);
+			std::size_t flaggedCount = 0;
+			std::size_t chainedCount = 0;
+			for(const auto & entry : entries) {
+				if((entry.id & StringIdentifier::COLLISION_FLAG) != 0) {
+					++flaggedCount;
+					statistics.maxProbeLength = std::max<std::size_t>(statistics.maxProbeLength, 1);
+					continue;
+				}
+				std::size_t position = 1;
+				probeSum += position;
+				for(const Entry * next = entry.nextCollision.load(std::memory_order_relaxed);
+						next != nullptr; next = next->nextCollision.load(std::memory_order_relaxed)) {
+					++position;
+					++chainedCount;
+					probeSum += position;
+				}
+				statistics.maxProbeLength = std::max(statistics.maxProbeLength, position);
+			}
+			// Entries that toString() created for unknown collision ids are not part of a chain.
+			probeSum += flaggedCount - chainedCount;
+			statistics.entryCount += entries.size();
+			statistics.collisionCount += chainedCount;
+		}
+
+		/**
+		 * Append a string to the chain of strings with the same hash value.
+		 * The mutex has to be locked by the caller.
+		 */
+		const Entry * insertCollision(const Entry * chainHead, const char * str, std::size_t length) {
+			uint32_t id;
+			do {
+				// Skip ids that were added by StringIdentifier::toString() for unknown numbers.
+				id = StringIdentifier::COLLISION_FLAG | (++collisionCount << SHARD_BITS) | (chainHead->id & (SHARD_COUNT - 1));
+			} while(find(id) != nullptr);
+			const Entry * entry = insert(id, str, length);
+			appendToChain(chainHead, entry);
+			return entry;
+		}
+
+		/**
+		 * Append an entry with a given collision id, which has to be unused,
+		 * to the chain of strings with the same hash value.
+		 * The mutex has to be locked by the caller.
+		 */
+		const Entry * insertStoredCollision(const Entry * chainHead, uint32_t id, const char * str, std::size_t length) {
+			// Ids assigned later must not use the counter values of loaded ids.
+			collisionCount = std::max(collisionCount, (id & ~StringIdentifier::COLLISION_FLAG) >> SHARD_BITS);
+			const Entry * entry = insertStored(id, str, length);
+			appendToChain(chainHead, entry);
+			return entry;
+		}
+
+	private:
+		static void appendToChain(const Entry * chainHead, const Entry * entry) {
+			const Entry * last = chainHead;
+			while(const Entry * next = last->nextCollision.load(std::memory_order_relaxed)) {
+				last = next;
+			}
+			const_cast<Entry *>(last)->nextCollision.store(entry, std::memory_order_release);
+		}
+};
 
-static stringIdTable_t & getStringIdTable() {
-	static std::unique_ptr<stringIdTable_t> stringIdTable(new stringIdTable_t);
-	return *stringIdTable.get();
+//! Lock-free search in the chain of strings with the same hash value.
+static const Entry * findInChain(const Entry * entry, const char * str, std::size_t length) {
+	for(; entry != nullptr; entry = entry->nextCollision.load(std::memory_order_acquire)) {
+		if(entry->equals(str, length)) {
+			return entry;
+		}
+	}
+	return nullptr;
 }
 
-static std::mutex & getLookupTableMutex() {
-	static std::mutex mutex;
-	return mutex;
+/**
+ * Return the id of the string and insert it if it is not contained in the shard.
+ * The mutex of the shard has to be locked by the caller.
+ */
+static uint32_t internLocked(Shard & shard, uint32_t hash, const char * str, std::size_t length) {
+	if(length == 0) {
+		return 0;
+	}
+	const Entry * chainHead = shard.find(hash);
+	if(chainHead == nullptr) {
+		return shard.insert(hash, str, length)->id;
+	}
+	const Entry * entry = findInChain(chainHead, str, length);
+	if(entry == nullptr) {
+		// collision
+		entry = shard.insertCollision(chainHead, str, length);
+	}
+	return entry->id;
 }
 
-uint32_t StringIdentifier::calcId(const std::string & s) {
-	uint32_t id = calcHash(s);
-	std::lock_guard<std::mutex> lock(getLookupTableMutex());
-	stringIdTable_t & stringIdTable = getStringIdTable();
-
-	while (true) {
-		auto entry = stringIdTable.find(id);
-		if (entry == stringIdTable.cend()) {
-			// id not found -> insert it
-			stringIdTable.emplace(id, s);
-			break;
-		} else if (s == entry->second) {
-			// same string already inserted
-			break;
-		} else {
-			// collision
-			++id;
-		}
-	}
-	return id;
+static const char SNAPSHOT_MAGIC[4] = {'S', 'I', 'D', 'T'};
+static const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t entryCount;
+	uint32_t reserved;
+	//! Size of the records following the header
+	uint64_t recordBytes;
+};
+
+/*
+ * A record consists of the id and the length as uint32_t, followed by the
+ * characters and a null character. Loaded records are referenced directly.
+ */
+static const std::size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+//! The records of a snapshot are read in blocks of this size, so that memory is only allocated for data that exists.
+static const std::size_t SNAPSHOT_READ_SIZE = 1 << 20;
+
+//! Return the number of bytes remaining in the stream, or -1 if the stream does not support seeking.
+static std::streamoff getRemainingSize(std::istream & input) {
+	const std::streampos position = input.tellg();
+	if(position == std::streampos(-1)) {
+		return -1;
+	}
+	input.seekg(0, std::ios::end);
+	const std::streampos end = input.tellg();
+	input.seekg(position);
+	if(end == std::streampos(-1) || !input) {
+		input.clear();
+		input.seekg(position);
+		return -1;
+	}
+	return end - position;
+}
+
+}
+
+static Shard & getShard(uint32_t id) {
+	static Shard shards[SHARD_COUNT];
+	return shards[id & (SHARD_COUNT - 1)];
+}
+
+const uint32_t StringIdentifier::COLLISION_FLAG;
+
+uint32_t StringIdentifier::calcId(const char * str, std::size_t length) {
+	// The empty string always has the number zero and is not stored in the table.
+	if(length == 0) {
+		return 0;
+	}
+	return calcIdForHash(calcRuntimeHash(str, length), str, length);
+}
+
+uint32_t StringIdentifier::calcIdForHash(uint32_t hash, const char * str, std::size_t length) {
+	if(length == 0) {
+		return 0;
+	}
+	Shard & shard = getShard(hash);
+	const Entry * chainHead = shard.find(hash);
+	const Entry * entry = findInChain(chainHead, str, length);
+	if(entry != nullptr) {
+		return entry->id;
+	}
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	// Check again, because another thread could have inserted the string in the meantime.
+	return internLocked(shard, hash, str, length);
+}
+
+void StringIdentifier::internAll(const StringView * strings, std::size_t count, StringIdentifier * ids) {
+	// Group the strings by shard; each shard is then searched and filled under a single lock.
+	std::vector<std::vector<std::size_t>> indicesPerShard(SHARD_COUNT);
+	std::vector<uint32_t> hashes(count);
+	for(std::size_t i = 0; i < count; ++i) {
+		hashes[i] = calcRuntimeHash(strings[i].data(), strings[i].size());
+		indicesPerShard[hashes[i] & (SHARD_COUNT - 1)].push_back(i);
+	}
+	for(uint32_t shardIndex = 0; shardIndex < SHARD_COUNT; ++shardIndex) {
+		const auto & indices = indicesPerShard[shardIndex];
+		if(indices.empty()) {
+			continue;
+		}
+		Shard & shard = getShard(shardIndex);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for(const auto index : indices) {
+			const StringView & str = strings[index];
+			ids[index] = StringIdentifier(internLocked(shard, hashes[index], str.data(), str.size()));
+		}
+	}
 }
 
-std::string StringIdentifier::toString() const {
-	std::lock_guard<std::mutex> lock(getLookupTableMutex());
-	stringIdTable_t & stringIdTable = getStringIdTable();
-	auto entry = stringIdTable.find(value);
-	if (entry == stringIdTable.cend()) {
-		std::stringstream s;
-		s << "_strId_" << value;
-		stringIdTable[value] = s.str();
-		return s.str();
-	}
-	return entry->second;
+StringView StringIdentifier::toStringView() const {
+	if(value == 0) {
+		return StringView();
+	}
+	Shard & shard = getShard(value);
+	const Entry * entry = shard.find(value);
+	if(entry == nullptr) {
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		entry = shard.find(value);
+		if(entry == nullptr) {
+			std::stringstream s;
+			s << "_strId_" << value;
+			const std::string str = s.str();
+			entry = shard.insert(value, str.data(), str.size());
+		}
+	}
+	return StringView(entry->str, entry->length);
 }
 
-uint32_t StringIdentifier::calcHash(const std::string & s) {
-	uint32_t h = 0;
-	for(const auto & c : s) {
-		h ^= (((static_cast<uint32_t>(c) + h) * 1234393) % 0xffffff);
+uint32_t StringIdentifier::calcRuntimeHash(const char * str, std::size_t length) {
+	if(length == 0) {
+		return 0;
+	}
+	// Has to be identical to calcHash(const char *, std::size_t).
+	uint32_t hash = 2166136261u;
+	for(const char * end = str + length; str != end; ++str) {
+		hash = (hash ^ static_cast<uint8_t>(*str)) * 16777619u;
+	}
+	return finalizeHash(hash) & ~COLLISION_FLAG;
+}
+
+std::size_t StringIdentifier::saveTable(std::ostream & output) {
+	std::string records;
+	uint32_t entryCount = 0;
+	const auto appendRecord = [&records, &entryCount](const Entry & entry) {
+		const uint32_t recordHeader[2] = {entry.id, static_cast<uint32_t>(entry.length)};
+		records.append(reinterpret_cast<const char *>(recordHeader), RECORD_HEADER_SIZE);
+		records.append(entry.str, entry.length + 1);
+		++entryCount;
+	};
+	for(uint32_t i = 0; i < SHARD_COUNT; ++i) {
+		Shard & shard = getShard(i);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		for(const auto & entry : shard.getEntries()) {
+			// Write each chain starting at its head, so that heads are loaded first.
+			if((entry.id & COLLISION_FLAG) != 0 || entry.length > UINT32_MAX) {
+				continue;
+			}
+			// Placeholders of toString() are not written, but the strings colliding with them are.
+			const bool isPlaceholder = calcRuntimeHash(entry.str, entry.length) != entry.id;
+			for(const Entry * chainEntry = isPlaceholder ? entry.nextCollision.load(std::memory_order_relaxed) : &entry;
+					chainEntry != nullptr;
+					chainEntry = chainEntry->nextCollision.load(std::memory_order_relaxed)) {
+				appendRecord(*chainEntry);
+			}
+		}
+	}
+	SnapshotHeader header;
+	std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SNAPSHOT_VERSION;
+	header.entryCount = entryCount;
+	header.reserved = 0;
+	header.recordBytes = records.size();
+	output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	output.write(records.data(), static_cast<std::streamsize>(records.size()));
+	return entryCount;
+}
+
+std::size_t StringIdentifier::loadTable(std::istream & input) {
+	SnapshotHeader header;
+	if(!input.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+			std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != SNAPSHOT_VERSION) {
+		WARN("StringIdentifier: Invalid snapshot header.");
+		return 0;
+	}
+	// The size is checked before memory is allocated for it, because the header may be corrupt.
+	const std::streamoff remainingSize = getRemainingSize(input);
+	if(header.recordBytes > static_cast<uint64_t>(std::numeric_limits<std::streamsize>::max()) ||
+			(remainingSize >= 0 && header.recordBytes > static_cast<uint64_t>(remainingSize))) {
+		WARN("StringIdentifier: Snapshot is truncated.");
+		return 0;
+	}
+	const std::size_t recordBytes = static_cast<std::size_t>(header.recordBytes);
+	std::vector<char> buffer;
+	// Without the size of the stream, the buffer only grows with the data that is actually read.
+	buffer.reserve(remainingSize >= 0 ? recordBytes : std::min(recordBytes, SNAPSHOT_READ_SIZE));
+	while(buffer.size() < recordBytes) {
+		const std::size_t offset = buffer.size();
+		const std::size_t blockSize = std::min(recordBytes - offset, SNAPSHOT_READ_SIZE);
+		buffer.resize(offset + blockSize);
+		if(!input.read(buffer.data() + offset, static_cast<std::streamsize>(blockSize))) {
+			WARN("StringIdentifier: Snapshot is truncated.");
+			return 0;
+		}
+	}
+
+	struct Record {
+		uint32_t id;
+		uint32_t hash;
+		const char * str;
+		std::size_t length;
+	};
+	std::vector<Record> records;
+	records.reserve(header.entryCount);
+	for(std::size_t offset = 0; offset < recordBytes;) {
+		uint32_t recordHeader[2];
+		if(recordBytes - offset < RECORD_HEADER_SIZE) {
+			WARN("StringIdentifier: Invalid snapshot record.");
+			return 0;
+		}
+		std::memcpy(recordHeader, buffer.data() + offset, RECORD_HEADER_SIZE);
+		offset += RECORD_HEADER_SIZE;
+		const std::size_t length = recordHeader[1];
+		if(recordBytes - offset <= length || buffer[offset + length] != '\0') {
+			WARN("StringIdentifier: Invalid snapshot record.");
+			return 0;
+		}
+		const Record record{recordHeader[0], calcRuntimeHash(buffer.data() + offset, length), buffer.data() + offset, length};
+		offset += length + 1;
+		// A different hash function or a corrupt file would break the mapping.
+		if((record.id & COLLISION_FLAG) == 0 ? record.id != record.hash :
+				((record.id ^ record.hash) & (SHARD_COUNT - 1)) != 0) {
+			WARN("StringIdentifier: Snapshot does not match the hash function.");
+			return 0;
+		}
+		records.push_back(record);
+	}
+
+	// Insert the records shard by shard, keeping their order inside each shard.
+	std::stable_sort(records.begin(), records.end(), [](const Record & a, const Record & b) {
+		return (a.id & (SHARD_COUNT - 1)) < (b.id & (SHARD_COUNT - 1));
+	});
+	std::size_t addedCount = 0;
+	for(auto begin = records.cbegin(); begin != records.cend();) {
+		const uint32_t shardIndex = begin->id & (SHARD_COUNT - 1);
+		auto end = begin;
+		while(end != records.cend() && (end->id & (SHARD_COUNT - 1)) == shardIndex) {
+			++end;
+		}
+		Shard & shard = getShard(shardIndex);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		shard.reserve(static_cast<std::size_t>(std::distance(begin, end)));
+		for(; begin != end; ++begin) {
+			if(shard.find(begin->id) != nullptr) {
+				continue;
+			}
+			if((begin->id & COLLISION_FLAG) == 0) {
+				shard.insertStored(begin->id, begin->str, begin->length);
+				++addedCount;
+				continue;
+			}
+			const Entry * chainHead = shard.find(begin->hash);
+			if(chainHead != nullptr && findInChain(chainHead, begin->str, begin->length) == nullptr) {
+				shard.insertStoredCollision(chainHead, begin->id, begin->str, begin->length);
+				++addedCount;
+			}
+		}
+	}
+	if(addedCount > 0) {
+		// The entries reference the buffer directly.
+		static std::mutex snapshotMutex;
+		static std::vector<std::vector<char>> snapshotBuffers;
+		std::lock_guard<std::mutex> lock(snapshotMutex);
+		snapshotBuffers.emplace_back(std::move(buffer));
+	}
+	return addedCount;
+}
+
+StringIdentifier::Statistics StringIdentifier::getStatistics() {
+	Statistics statistics{0, 0, 0, 0.0};
+	std::size_t probeSum = 0;
+	for(uint32_t i = 0; i < SHARD_COUNT; ++i) {
+		getShard(i).collectStatistics(statistics, probeSum);
+	}
+	if(statistics.entryCount > 0) {
+		statistics.averageProbeLength = static_cast<double>(probeSum) / static_cast<double>(statistics.entryCount);
 	}
-	return h;
+	return statistics;
 }
 
 }
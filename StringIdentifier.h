@@ -11,17 +11,28 @@
 #ifndef STRINGIDENTIFIER_H_
 #define STRINGIDENTIFIER_H_
 
+#include "StringView.h"
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <iterator>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 namespace Util {
-
+class StringIdentifierLiteral;
 
 /**
  * String identifiers map a string to a number.
  * This mapping is guaranteed to be unique during one execution of the program.
+ * The number of a string is its hash value. If that value is already used by
+ * another string, the string gets a number with the bit COLLISION_FLAG set.
+ * Therefore, the number of a string can be computed at compile time (see
+ * operator""_sid), as long as no other string with the same hash value has
+ * been added before.
  *
  * @author Claudius Jähn, Benjamin Eikel
  * @ingroup strings
@@ -29,29 +40,174 @@ namespace Util {
 class StringIdentifier {
 		uint32_t value;
 	public:
+		//! Set in the numbers of strings whose hash value is used by another string.
+		static const uint32_t COLLISION_FLAG = 0x80000000;
 
-		StringIdentifier() : value(0) 							{}
-		explicit StringIdentifier( uint32_t _id) : value(_id)	{}
-		/*implicit*/ StringIdentifier( const std::string & str) : value(calcId(str)) {}
+		constexpr StringIdentifier() : value(0) 							{}
+		constexpr explicit StringIdentifier( uint32_t _id) : value(_id)	{}
+		/*implicit*/ StringIdentifier( const std::string & str) : value(calcId(str.data(), str.size())) {}
+		//! (A template to keep StringIdentifier(0) unambiguous)
+		template<typename char_t, typename = typename std::enable_if<std::is_same<char_t, char>::value>::type>
+		/*implicit*/ StringIdentifier( const char_t * str) : value(calcId(str, std::strlen(str))) {}
+		/**
+		 * Create the identifier for the given characters, which do not have
+		 * to be null-terminated. The characters are only copied if the string
+		 * is not yet contained in the lookup table.
+		 */
+		StringIdentifier( const char * str, std::size_t length) : value(calcId(str, length)) {}
 
-		uint32_t getValue()const								{	return value;	}
-		UTILAPI std::string toString()const;
+		constexpr uint32_t getValue()const								{	return value;	}
+		std::string toString()const										{	return toStringView().str();	}
+		/**
+		 * Return a view of the string without copying it or locking the lookup table.
+		 * The characters are null-terminated and stay valid until the end of the program.
+		 * The number zero always denotes the empty string.
+		 */
+		UTILAPI StringView toStringView()const;
 
 		StringIdentifier & operator=(const std::string & str){
-			value = calcId(str);
+			value = calcId(str.data(), str.size());
+			return *this;
+		}
+		template<typename char_t, typename = typename std::enable_if<std::is_same<char_t, char>::value>::type>
+		StringIdentifier & operator=(const char_t * str){
+			value = calcId(str, std::strlen(str));
 			return *this;
 		}
-		bool empty()const										{	return value==0;	}
+		constexpr bool empty()const										{	return value==0;	}
+
+		constexpr bool operator==(const StringIdentifier & other)const	{	return value == other.value;	}
+		constexpr bool operator!=(const StringIdentifier & other)const	{	return value != other.value;	}
+		constexpr bool operator<(const StringIdentifier & other)const	{	return value < other.value;	}
+
+		/**
+		 * Calculate the hash value of the given characters at compile time.
+		 * The result is identical to the value that is used at runtime.
+		 * The hash is FNV-1a followed by the finalizer of MurmurHash3. The
+		 * bit COLLISION_FLAG is always cleared; the empty string has the
+		 * value zero.
+		 */
+		static constexpr uint32_t calcHash(const char * str, std::size_t length) {
+			return length == 0 ? 0 : finalizeHash(calcFNV1a(str, length, 2166136261u)) & ~COLLISION_FLAG;
+		}
+
+		//! Statistics about the lookup table of all string identifiers.
+		struct Statistics {
+			//! Number of strings in the table
+			std::size_t entryCount;
+			//! Number of strings whose hash value was already used by another string
+			std::size_t collisionCount;
+			//! Maximum number of string comparisons needed to find a string
+			std::size_t maxProbeLength;
+			//! Average number of string comparisons needed to find a string
+			double averageProbeLength;
+		};
+		//! Collect statistics about the lookup table. This locks the table.
+		UTILAPI static Statistics getStatistics();
+
+		/**
+		 * Add all given strings to the lookup table. The table is locked at
+		 * most once per shard instead of once for every new string.
+		 * @param strings Range of elements that are convertible to StringView
+		 * (e.g. std::string or const char *)
+		 * @return Identifiers of the strings in the order of the range
+		 */
+		template<typename Range>
+		static std::vector<StringIdentifier> internAll(const Range & strings) {
+			const std::vector<StringView> views(std::begin(strings), std::end(strings));
+			std::vector<StringIdentifier> ids(views.size());
+			internAll(views.data(), views.size(), ids.data());
+			return ids;
+		}
+		//! Add @p count strings to the lookup table and store their identifiers in @p ids.
+		UTILAPI static void internAll(const StringView * strings, std::size_t count, StringIdentifier * ids);
 
-		bool operator==(const StringIdentifier & other)const	{	return value == other.value;	}
-		bool operator!=(const StringIdentifier & other)const	{	return value != other.value;	}
-		bool operator<(const StringIdentifier & other)const		{	return value < other.value;	}
+		/**
+		 * Write all strings of the lookup table together with their numbers
+		 * into a compact binary snapshot. Placeholders created by toString()
+		 * for unknown numbers are not written. The snapshot uses the byte order
+		 * of the machine.
+		 * @return Number of written strings
+		 */
+		UTILAPI static std::size_t saveTable(std::ostream & output);
+		/**
+		 * Fill the lookup table with the strings of a snapshot created by
+		 * saveTable(). The snapshot is read into a single block of memory that
+		 * is used directly as storage for the strings; nothing is copied per
+		 * string and the table is locked once per shard. Strings that are
+		 * already known are skipped, as well as entries whose number has been
+		 * assigned to another string in the meantime. To get the same numbers
+		 * for colliding strings as in the run that created the snapshot, load
+		 * it before other strings are added.
+		 * @return Number of added strings, or zero if the snapshot is invalid
+		 */
+		UTILAPI static std::size_t loadTable(std::istream & input);
 
 	private:
-		UTILAPI static uint32_t calcId(const std::string & s);
-		UTILAPI static uint32_t calcHash(const std::string & s);
+		static constexpr uint32_t calcFNV1a(const char * str, std::size_t length, uint32_t hash) {
+			return length == 0 ? hash : calcFNV1a(str + 1, length - 1, (hash ^ static_cast<uint8_t>(*str)) * 16777619u);
+		}
+		static constexpr uint32_t mixHash(uint32_t hash, uint32_t shift, uint32_t factor) {
+			return (hash ^ (hash >> shift)) * factor;
+		}
+		static constexpr uint32_t finalizeHash(uint32_t hash) {
+			return mixHash(mixHash(mixHash(hash, 16, 0x85ebca6bu), 13, 0xc2b2ae35u), 16, 1u);
+		}
+
+		friend class StringIdentifierLiteral;
+		UTILAPI static uint32_t calcId(const char * str, std::size_t length);
+		/**
+		 * Return the number of the string with the given, already computed hash
+		 * value and add the string to the lookup table if necessary.
+		 */
+		UTILAPI static uint32_t calcIdForHash(uint32_t hash, const char * str, std::size_t length);
+		//! Iterative version of calcHash(const char *, std::size_t) for runtime use
+		UTILAPI static uint32_t calcRuntimeHash(const char * str, std::size_t length);
 };
 
+/**
+ * Identifier of a string literal whose number is computed at compile time.
+ * It is created by the user-defined literal @c _sid:
+ * @code
+ * using namespace Util::Literals;
+ * constexpr auto KEY_NAME = "name"_sid;
+ * const GenericAttribute * name = map.findValue(KEY_NAME);
+ * @endcode
+ * The conversion to StringIdentifier does not hash the string. Once the
+ * string is contained in the lookup table, it does not lock the table either.
+ * If another string with the same hash value has been added before, the
+ * literal gets a number with the COLLISION_FLAG like every other string.
+ *
+ * @ingroup strings
+ */
+class StringIdentifierLiteral {
+		const char * str;
+		std::size_t length;
+		uint32_t value;
+	public:
+		constexpr StringIdentifierLiteral(const char * _str, std::size_t _length) :
+			str(_str), length(_length), value(StringIdentifier::calcHash(_str, _length)) {}
+
+		/**
+		 * Hash value of the string; usable in constant expressions. It equals
+		 * the number of the converted StringIdentifier unless the hash value
+		 * has been used by another string first.
+		 */
+		constexpr uint32_t getValue()const								{	return value;	}
+		std::string toString()const										{	return std::string(str, length);	}
+
+		/*implicit*/ operator StringIdentifier()const {
+			return StringIdentifier(StringIdentifier::calcIdForHash(value, str, length));
+		}
+};
+
+inline namespace Literals {
+//! Create a StringIdentifierLiteral at compile time: @c "name"_sid
+constexpr StringIdentifierLiteral operator"" _sid(const char * str, std::size_t length) {
+	return StringIdentifierLiteral(str, length);
+}
+}
+
 }
 
 namespace std{
@@ -16,6 +16,7 @@
 #include <deque>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <limits>
@@ -36,6 +37,11 @@ UTILAPI std::string createRandomString(size_t length);
 
 //!	Escape quotes, newlines and backslashes.
 UTILAPI std::string escape(const std::string & s);
+/**
+ * Append the @p length characters of @p s to @p out and escape them like
+ * escape(). Unlike escape(), no temporary strings are created.
+ */
+UTILAPI void appendEscaped(std::string & out, const char * s, std::size_t length);
 
 /**
  * Convert the given string containing white space separated number representations and append the numbers to the given double-ended queue.
@@ -81,6 +87,11 @@ static const uint32_t INVALID_UNICODE_CODE_POINT = std::numeric_limits<uint32_t>
 		If no valid code point could be read (e.g. formatting error), UnicodeCodePoint is INVALID_UNICODE_CODE_POINT. */
 UTILAPI std::pair<uint32_t,uint8_t> readUTF8Codepoint(const std::string & str,const size_t pos);
 
+/*! Check if the characters [begin, end) are valid UTF-8: no overlong encodings,
+	no surrogates and no code points above U+10FFFF. ASCII characters are checked in bulk. */
+UTILAPI bool isValidUTF8(const char * begin, const char * end);
+inline bool isValidUTF8(const std::string & str)	{	return isValidUTF8(str.data(), str.data() + str.size());	}
+
 /*! Read and return the content of a quoted string "foo bar". The cursor is placed after the string.
 	If no quoted string is found at the beginning of the stream, the cursor is not moved.   */
 UTILAPI std::string readQuotedString(const char * subject,int & cursor);
@@ -103,18 +114,133 @@ UTILAPI void stepWhitespaces(std::istream & is);
 UTILAPI void stepWhitespaces(std::istream & is,int & line);
 UTILAPI void stepWhitespaces(char ** cursor);
 
+/**
+ * @name Locale-independent number conversion
+ * The functions neither allocate memory nor depend on the global locale.
+ * Floating-point numbers are written with the shortest representation that
+ * is read back as the same value. Like std::ostream, the fixed notation is
+ * used unless the decimal exponent is smaller than -4 or not smaller than
+ * the number of digits (at least six), e.g. "0.25", "1234567", "1e+20".
+ */
+//@{
+//! Maximum number of characters written by formatInteger() and formatFloat()
+static const std::size_t MAX_NUMBER_LENGTH = 32;
+/**
+ * Write the decimal representation of @p value to @p buffer, which must
+ * provide space for MAX_NUMBER_LENGTH characters. No terminating null
+ * character is written.
+ * @return Position behind the last written character
+ */
+UTILAPI char * formatInteger(char * buffer, long long value);
+UTILAPI char * formatInteger(char * buffer, unsigned long long value);
+UTILAPI char * formatFloat(char * buffer, double value);
+UTILAPI char * formatFloat(char * buffer, float value);
+/**
+ * Read a number from the characters [begin, end). Leading white space is
+ * skipped. Integers that are out of range are clamped like by strtoll();
+ * "inf" and "nan" are accepted for floating-point numbers.
+ * @return Position behind the number, or @p begin if there is no number;
+ * then @p value is set to zero.
+ */
+UTILAPI const char * parseInteger(const char * begin, const char * end, long long & value);
+UTILAPI const char * parseInteger(const char * begin, const char * end, unsigned long long & value);
+UTILAPI const char * parseFloat(const char * begin, const char * end, double & value);
+UTILAPI const char * parseFloat(const char * begin, const char * end, float & value);
+//@}
+
+namespace _Internals {
+//! True for the types that are converted by formatInteger()/formatFloat() and parseInteger()/parseFloat()
+template<typename _T>
+struct IsFastNumber : std::integral_constant<bool, std::is_arithmetic<_T>::value &&
+		!std::is_same<_T, bool>::value && !std::is_same<_T, long double>::value> {};
+
+template<typename _T>
+char * formatNumber(char * buffer, _T value, std::true_type /*isIntegral*/) {
+	typedef typename std::conditional<std::is_signed<_T>::value, long long, unsigned long long>::type integer_t;
+	return formatInteger(buffer, static_cast<integer_t>(value));
+}
+template<typename _T>
+char * formatNumber(char * buffer, _T value, std::false_type /*isIntegral*/) {
+	return formatFloat(buffer, value);
+}
+
+template<typename _T>
+const char * parseNumber(const char * begin, const char * end, _T & value, std::true_type /*isIntegral*/) {
+	typedef typename std::conditional<std::is_signed<_T>::value, long long, unsigned long long>::type integer_t;
+	integer_t number;
+	const char * cursor = parseInteger(begin, end, number);
+	if(number < static_cast<integer_t>(std::numeric_limits<_T>::min())) {
+		value = std::numeric_limits<_T>::min();
+	} else if(number > static_cast<integer_t>(std::numeric_limits<_T>::max())) {
+		value = std::numeric_limits<_T>::max();
+	} else {
+		value = static_cast<_T>(number);
+	}
+	return cursor;
+}
+template<typename _T>
+const char * parseNumber(const char * begin, const char * end, _T & value, std::false_type /*isIntegral*/) {
+	return parseFloat(begin, end, value);
+}
+
+template<typename _T>
+_T toNumber(const std::string & in, std::true_type /*isFastNumber*/) {
+	_T out;
+	parseNumber(in.data(), in.data() + in.size(), out, std::is_integral<_T>());
+	return out;
+}
+template<typename _T>
+_T toNumber(const std::string & in, std::false_type /*isFastNumber*/) {
+	std::istringstream stream(in);
+	_T out;
+	stream >> out;
+	return out;
+}
+
+template<typename Type>
+std::string toString(Type var, std::true_type /*isFastNumber*/) {
+	char buffer[MAX_NUMBER_LENGTH];
+	return std::string(buffer, formatNumber(buffer, var, std::is_integral<Type>()));
+}
+template<typename Type>
+std::string toString(Type var, std::false_type /*isFastNumber*/) {
+	std::ostringstream s;
+	s << var;
+	return s.str();
+}
+}
+
+/**
+ * Convert a number to its decimal representation (see formatInteger() and formatFloat()).
+ * @return Position behind the last written character
+ */
+template<typename _T>
+char * formatNumber(char * buffer, _T value) {
+	static_assert(_Internals::IsFastNumber<_T>::value, "Unsupported number type.");
+	return _Internals::formatNumber(buffer, value, std::is_integral<_T>());
+}
+/**
+ * Read a number of the given type (see parseInteger() and parseFloat()).
+ * Integers that do not fit into @p _T are clamped.
+ */
+template<typename _T>
+const char * parseNumber(const char * begin, const char * end, _T & value) {
+	static_assert(_Internals::IsFastNumber<_T>::value, "Unsupported number type.");
+	return _Internals::parseNumber(begin, end, value, std::is_integral<_T>());
+}
+
 /**
  * Convert the given string to a number.
+ * Numbers are read by parseNumber(); characters, bools and other types by
+ * std::istream.
  *
  * @param in String containing a number representation.
  * @return Number as type determined by template parameter.
  */
 template<typename _T>
 inline static _T toNumber(const std::string & in) {
-	std::istringstream stream(in);
-	_T out;
-	stream >> out;
-	return out;
+	return _Internals::toNumber<_T>(in, std::integral_constant<bool, _Internals::IsFastNumber<_T>::value &&
+			!std::is_same<_T, char>::value && !std::is_same<_T, signed char>::value && !std::is_same<_T, unsigned char>::value>());
 }
 UTILAPI bool toBool(const std::string & s);
 
@@ -130,11 +256,10 @@ UTILAPI std::string trim(const std::string & s);
 
 UTILAPI std::string toFormattedString(float i);
 
+//! Convert the value to a string; numbers are written by formatNumber(), other types by std::ostream.
 template<typename Type>
 std::string toString(Type var) {
-	std::ostringstream s;
-	s << var;
-	return s.str();
+	return _Internals::toString(var, _Internals::IsFastNumber<Type>());
 }
 template<> inline std::string toString<unsigned char>(unsigned char var) {
 	return StringUtils::toString<unsigned int>(var);
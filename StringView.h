@@ -0,0 +1,86 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef UTIL_STRINGVIEW_H
+#define UTIL_STRINGVIEW_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace Util {
+
+/**
+ * @brief Read-only reference to a sequence of characters
+ *
+ * A string view consists of a pointer and a length. It does not own the
+ * characters, and the characters do not have to be null-terminated.
+ * The creator of a view has to make sure that the characters outlive it.
+ *
+ * @ingroup strings
+ */
+class StringView {
+		const char * ptr;
+		std::size_t length;
+	public:
+		typedef const char * const_iterator;
+
+		constexpr StringView() : ptr(""), length(0) {}
+		constexpr StringView(const char * _ptr, std::size_t _length) : ptr(_ptr), length(_length) {}
+		/*implicit*/ StringView(const char * str) : ptr(str), length(std::strlen(str)) {}
+		/*implicit*/ StringView(const std::string & str) : ptr(str.data()), length(str.size()) {}
+
+		constexpr const char * data() const			{	return ptr;	}
+		constexpr std::size_t size() const			{	return length;	}
+		constexpr bool empty() const				{	return length == 0;	}
+		constexpr char operator[](std::size_t index) const	{	return ptr[index];	}
+
+		const_iterator begin() const				{	return ptr;	}
+		const_iterator end() const					{	return ptr + length;	}
+
+		//! Return a view of the characters [pos, pos + count).
+		StringView substr(std::size_t pos, std::size_t count = std::string::npos) const {
+			pos = std::min(pos, length);
+			return StringView(ptr + pos, std::min(count, length - pos));
+		}
+
+		//! Return a copy of the characters.
+		std::string str() const						{	return std::string(ptr, length);	}
+		explicit operator std::string() const		{	return str();	}
+
+		int compare(const StringView & other) const {
+			const int result = std::memcmp(ptr, other.ptr, std::min(length, other.length));
+			if(result != 0) {
+				return result;
+			}
+			return length < other.length ? -1 : (length > other.length ? 1 : 0);
+		}
+		bool operator==(const StringView & other) const {
+			return length == other.length && std::memcmp(ptr, other.ptr, length) == 0;
+		}
+		bool operator!=(const StringView & other) const	{	return !(*this == other);	}
+		bool operator<(const StringView & other) const	{	return compare(other) < 0;	}
+};
+
+inline bool operator==(const std::string & a, const StringView & b)	{	return StringView(a) == b;	}
+inline bool operator==(const char * a, const StringView & b)		{	return StringView(a) == b;	}
+inline bool operator!=(const std::string & a, const StringView & b)	{	return StringView(a) != b;	}
+inline bool operator!=(const char * a, const StringView & b)		{	return StringView(a) != b;	}
+
+inline std::ostream & operator<<(std::ostream & out, const StringView & view) {
+	return out.write(view.data(), static_cast<std::streamsize>(view.size()));
+}
+
+}
+
+#endif /* UTIL_STRINGVIEW_H */
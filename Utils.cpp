@@ -421,11 +421,13 @@ void disableInfo()
 //    infoString.clear();
 //}
 uint32_t calcHash(const uint8_t * ptr,size_t size){
-	uint32_t h = 0;
+	// FNV-1a followed by the finalizer of MurmurHash3
+	uint32_t h = 2166136261u;
 	for(const uint8_t * end = ptr+size; ptr<end; ++ptr)
-		h ^= (((*ptr + h) * 1234393) % 0xffffff);
-	return h;
-
+		h = (h ^ *ptr) * 16777619u;
+	h = (h ^ (h >> 16)) * 0x85ebca6bu;
+	h = (h ^ (h >> 13)) * 0xc2b2ae35u;
+	return h ^ (h >> 16);
 }
 
 //====================================================
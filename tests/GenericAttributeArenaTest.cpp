@@ -0,0 +1,154 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <catch2/catch.hpp>
+#include "GenericAttribute.h"
+#include "GenericAttributeArena.h"
+#include "GenericAttributePatch.h"
+#include "JSON_Parser.h"
+#include "Timer.h"
+#include <array>
+#include <iostream>
+#include <memory>
+#include <iterator>
+#include <string>
+
+//! Create a map with @p count elements that are stored as separate attributes.
+static Util::GenericAttributeMap * createAttributeMap(int count) {
+	auto map = new Util::GenericAttributeMap;
+	for(int i = 0; i < count; ++i) {
+		map->setValue(Util::StringIdentifier("key" + std::to_string(i % 100)), Util::GenericAttribute::create(static_cast<short>(i)));
+	}
+	return map;
+}
+
+static Util::GenericAttributeList * createAttributeTree(int mapCount) {
+	auto list = new Util::GenericAttributeList;
+	for(int i = 0; i < mapCount; ++i) {
+		list->push_back(createAttributeMap(100));
+	}
+	return list;
+}
+
+TEST_CASE("GenericAttributeArenaTest_testArena", "[GenericAttributeArenaTest]") {
+	std::unique_ptr<Util::GenericAttributeList> heapTree(createAttributeTree(10));
+	std::unique_ptr<Util::GenericAttributeList> heapCopy;
+	{
+		Util::GenericAttributeArena arena(4096);
+		Util::GenericAttributeList * tree;
+		Util::GenericAttributeList * clonedTree;
+		{
+			Util::GenericAttributeArena::Scope scope(arena);
+			tree = arena.own(createAttributeTree(10));
+			clonedTree = arena.own(heapTree->clone());
+			{
+				// The innermost scope is used.
+				Util::GenericAttributeArena innerArena;
+				Util::GenericAttributeArena::Scope innerScope(innerArena);
+				std::unique_ptr<Util::GenericAttribute> attribute(Util::GenericAttribute::create(1.0));
+				REQUIRE(innerArena.getAllocatedBytes() > 0);
+			}
+		}
+		REQUIRE(arena.getAllocatedBytes() > 0);
+		REQUIRE(arena.getReservedBytes() >= arena.getAllocatedBytes());
+		const std::size_t allocatedBytes = arena.getAllocatedBytes();
+
+		// Outside of the scope, attributes are allocated on the heap.
+		std::unique_ptr<Util::GenericAttribute> heapAttribute(Util::GenericAttribute::create(2));
+		REQUIRE(arena.getAllocatedBytes() == allocatedBytes);
+
+		REQUIRE(*tree == *heapTree);
+		REQUIRE(*clonedTree == *heapTree);
+		// Removing attributes from the arena runs their destructors only.
+		auto firstMap = tree->front()->toType<Util::GenericAttributeMap>();
+		REQUIRE(firstMap->unsetValue(Util::StringIdentifier("key1")));
+		firstMap->setValue(Util::StringIdentifier("heap"), heapAttribute.release());
+		tree->erase(std::next(tree->begin()));
+		REQUIRE(tree->size() == 9);
+
+		// Copies made outside of the scope are placed on the heap.
+		heapCopy.reset(tree->clone());
+	}
+	REQUIRE(heapCopy->size() == 9);
+	REQUIRE(heapCopy->front()->toType<Util::GenericAttributeMap>()->contains(Util::StringIdentifier("heap")));
+	{
+		// Attributes that are created implicitly in trees outside of the arena are placed on the heap.
+		Util::GenericAttributeList list;
+		list.pushBackNumber(42);
+		const std::string longString("This string is too long to be stored inline.");
+		std::unique_ptr<Util::GenericAttributeMap> original(new Util::GenericAttributeMap);
+		original->setValue(Util::StringIdentifier("text"), Util::GenericAttribute::create(longString));
+		std::unique_ptr<Util::GenericAttributeMap> sharedCopy(original->cloneShared());
+		Util::GenericAttributeMap target;
+		const Util::GenericAttributePatch patch(target, *original);
+		{
+			Util::GenericAttributeArena arena;
+			Util::GenericAttributeArena::Scope scope(arena);
+			const Util::GenericAttributeList & constList = list;
+			REQUIRE(constList.getElements()[0].get()->toInt() == 42);
+			sharedCopy->setNumber(Util::StringIdentifier("number"), 1);
+			patch.applyTo(target);
+			REQUIRE(arena.getAllocatedBytes() == 0);
+		}
+		REQUIRE(list.at(0)->toInt() == 42);
+		REQUIRE(sharedCopy->getString(Util::StringIdentifier("text")) == longString);
+		REQUIRE(target.getString(Util::StringIdentifier("text")) == longString);
+	}
+	{
+		// Large attributes do not fit into the blocks.
+		Util::GenericAttributeArena arena(256);
+		Util::GenericAttributeArena::Scope scope(arena);
+		std::unique_ptr<Util::GenericAttribute> wrapper(Util::GenericAttribute::createUndefined(std::array<char, 200>()));
+		REQUIRE(arena.getAllocatedBytes() == 0);
+	}
+	{
+		const std::string json = "{\"list\":[1,{\"a\":\"b\"},[true]],\"value\":\"This string is too long to be stored inline.\"}";
+		Util::GenericAttributeArena arena;
+		Util::GenericAttribute * tree;
+		{
+			Util::GenericAttributeArena::Scope scope(arena);
+			tree = arena.own(Util::JSON_Parser::parse(json));
+		}
+		std::unique_ptr<Util::GenericAttribute> heapParsed(Util::JSON_Parser::parse(json));
+		REQUIRE(*tree == *heapParsed);
+		REQUIRE(tree->toJSON() == heapParsed->toJSON());
+	}
+}
+
+TEST_CASE("GenericAttributeArenaBenchmark", "[.][GenericAttributeArenaBenchmark]") {
+	const int mapCount = 2000;
+	std::unique_ptr<Util::GenericAttributeList> source(createAttributeTree(mapCount));
+	for(int round = 0; round < 2; ++round) {
+		Util::Timer timer;
+		std::unique_ptr<Util::GenericAttributeList> heapTree(source->clone());
+		timer.stop();
+		const double heapCloneTime = timer.getMilliseconds();
+		timer.reset();
+		heapTree.reset();
+		timer.stop();
+		const double heapDestroyTime = timer.getMilliseconds();
+
+		timer.reset();
+		std::unique_ptr<Util::GenericAttributeArena> arena(new Util::GenericAttributeArena);
+		{
+			Util::GenericAttributeArena::Scope scope(*arena);
+			arena->own(source->clone());
+		}
+		timer.stop();
+		const double arenaCloneTime = timer.getMilliseconds();
+		timer.reset();
+		arena.reset();
+		timer.stop();
+		const double arenaDestroyTime = timer.getMilliseconds();
+		std::cout << "Clone of " << mapCount * 100 << " attributes: heap " << heapCloneTime << " ms (destroy " << heapDestroyTime
+				  << " ms), arena " << arenaCloneTime << " ms (destroy " << arenaDestroyTime << " ms)" << std::endl;
+	}
+}
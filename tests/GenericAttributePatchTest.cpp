@@ -0,0 +1,166 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <catch2/catch.hpp>
+#include "GenericAttribute.h"
+#include "GenericAttributePatch.h"
+#include "GenericAttributeSerialization.h"
+#include "JSON_Parser.h"
+#include "Timer.h"
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+static Util::GenericAttributeMap * parseMap(const std::string & json) {
+	return dynamic_cast<Util::GenericAttributeMap *>(Util::JSON_Parser::parse(json));
+}
+
+TEST_CASE("GenericAttributePatchTest_testDiff", "[GenericAttributePatchTest]") {
+	using namespace Util;
+	std::unique_ptr<GenericAttributeMap> from(parseMap(R"({
+		"same" : 1, "changed" : 2, "removed" : 3, "typeChanged" : { "a" : 1 },
+		"nested" : { "same" : "x", "changed" : "y", "deeper" : { "value" : [1, 2] } }
+	})"));
+	std::unique_ptr<GenericAttributeMap> to(parseMap(R"({
+		"same" : 1, "changed" : 20, "added" : true, "typeChanged" : [ 1 ],
+		"nested" : { "same" : "x", "changed" : "z", "deeper" : { "value" : [1, 2, 3] } }
+	})"));
+	REQUIRE(from.get() != nullptr);
+	REQUIRE(to.get() != nullptr);
+
+	const GenericAttributePatch patch(*from, *to);
+	REQUIRE(patch.size() == 6);
+	int setCount = 0;
+	int unsetCount = 0;
+	int replaceCount = 0;
+	for(const auto & operation : patch.getOperations()) {
+		const std::string path = operation.path.toString();
+		switch(operation.type) {
+			case GenericAttributePatch::OperationType::SET:
+				++setCount;
+				REQUIRE(path == "added");
+				REQUIRE(operation.value.toBool());
+				break;
+			case GenericAttributePatch::OperationType::UNSET:
+				++unsetCount;
+				REQUIRE(path == "removed");
+				REQUIRE(!operation.value);
+				break;
+			case GenericAttributePatch::OperationType::REPLACE:
+				++replaceCount;
+				REQUIRE((path == "changed" || path == "typeChanged" || path == "nested.changed" || path == "nested.deeper.value"));
+				break;
+		}
+	}
+	REQUIRE(setCount == 1);
+	REQUIRE(unsetCount == 1);
+	REQUIRE(replaceCount == 4);
+
+	patch.applyTo(*from);
+	REQUIRE(*from == *to);
+	REQUIRE(GenericAttributePatch(*from, *to).empty());
+
+	// The patch can be applied to a copy that shares the elements.
+	std::unique_ptr<GenericAttributeMap> original(parseMap(R"({ "a" : { "b" : 1 } })"));
+	std::unique_ptr<GenericAttributeMap> copy(original->cloneShared());
+	GenericAttributePatch nestedPatch;
+	nestedPatch.addOperation(GenericAttributePatch::OperationType::REPLACE, GenericAttributePath("a.b"), GenericAttributeSlot::createNumber(2));
+	nestedPatch.applyTo(*copy);
+	REQUIRE(original->getValue<GenericAttributeMap>("a")->getInt("b") == 1);
+	REQUIRE(copy->getValue<GenericAttributeMap>("a")->getInt("b") == 2);
+
+	GenericAttributePatch invalidPatch;
+	invalidPatch.addOperation(GenericAttributePatch::OperationType::SET, GenericAttributePath("a.b.c"), GenericAttributeSlot::createNumber(2));
+	REQUIRE_THROWS_AS(invalidPatch.applyTo(*copy), std::logic_error);
+}
+
+TEST_CASE("GenericAttributePatchTest_testShared", "[GenericAttributePatchTest]") {
+	using namespace Util;
+	GenericAttributeMap state;
+	for(int i = 0; i < 100; ++i) {
+		auto entry = new GenericAttributeMap;
+		entry->setNumber("value", i);
+		state.setValue("entry" + std::to_string(i), entry);
+	}
+	std::unique_ptr<GenericAttributeMap> snapshot(state.cloneShared());
+	REQUIRE(GenericAttributePatch(*snapshot, state).empty());
+
+	state.getValue<GenericAttributeMap>("entry42")->setNumber("value", -1);
+	state.unsetValue("entry7");
+	const GenericAttributePatch patch(*snapshot, state);
+	REQUIRE(patch.size() == 2);
+	patch.applyTo(*snapshot);
+	REQUIRE(*snapshot == state);
+}
+
+TEST_CASE("GenericAttributePatchTest_testSerialization", "[GenericAttributePatchTest]") {
+	using namespace Util;
+	GenericAttributeSerialization::init();
+	std::unique_ptr<GenericAttributeMap> from(parseMap(R"({ "a" : 1, "b" : { "c" : "text", "d" : [ 1, 2 ] } })"));
+	std::unique_ptr<GenericAttributeMap> to(parseMap(R"({ "b" : { "c" : "other text", "d" : [ 1 ], "e" : { "f" : false } } })"));
+	const GenericAttributePatch patch(*from, *to);
+	REQUIRE(patch.size() == 4);
+
+	const std::string serialization = GenericAttributeSerialization::serialize(&patch);
+	std::unique_ptr<GenericAttribute> unserialized(GenericAttributeSerialization::unserialize(serialization));
+	auto unserializedPatch = unserialized->toType<GenericAttributePatch>();
+	REQUIRE(unserializedPatch != nullptr);
+	REQUIRE(*unserializedPatch == patch);
+	std::unique_ptr<GenericAttributePatch> patchClone(patch.clone());
+	REQUIRE(*patchClone == patch);
+
+	unserializedPatch->applyTo(*from);
+	REQUIRE(*from == *to);
+}
+
+TEST_CASE("GenericAttributePatchBenchmark", "[.][GenericAttributePatchBenchmark]") {
+	using namespace Util;
+	GenericAttributeSerialization::init();
+	GenericAttributeMap state;
+	for(int i = 0; i < 10000; ++i) {
+		auto entry = new GenericAttributeMap;
+		entry->setNumber("x", static_cast<float>(i));
+		entry->setNumber("y", static_cast<float>(-i));
+		entry->setString("name", "object number " + std::to_string(i));
+		state.setValue("object" + std::to_string(i), entry);
+	}
+	std::unique_ptr<GenericAttributeMap> snapshot(state.cloneShared());
+	std::unique_ptr<GenericAttributeMap> deepCopy(state.clone());
+	for(int i = 0; i < 10; ++i) {
+		state.getValue<GenericAttributeMap>("object" + std::to_string(i * 997))->setNumber("x", 0.5f);
+	}
+
+	Timer timer;
+	const std::string fullSerialization = GenericAttributeSerialization::serialize(&state);
+	timer.stop();
+	std::cout << "Serialize the whole map: " << fullSerialization.size() << " bytes, " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	const GenericAttributePatch fullPatch(*deepCopy, state);
+	timer.stop();
+	std::cout << "Diff against a deep copy: " << fullPatch.size() << " operations, " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	const GenericAttributePatch patch(*snapshot, state);
+	const std::string patchSerialization = GenericAttributeSerialization::serialize(&patch);
+	timer.stop();
+	std::cout << "Diff against a shared snapshot and serialize: " << patchSerialization.size() << " bytes, " << timer.getMilliseconds() << " ms" << std::endl;
+	REQUIRE(patch.size() == 10);
+	REQUIRE(fullPatch == patch);
+
+	timer.reset();
+	std::unique_ptr<GenericAttribute> received(GenericAttributeSerialization::unserialize(patchSerialization));
+	received->toType<GenericAttributePatch>()->applyTo(*deepCopy);
+	timer.stop();
+	std::cout << "Unserialize and apply the patch: " << timer.getMilliseconds() << " ms" << std::endl;
+	REQUIRE(*deepCopy == state);
+}
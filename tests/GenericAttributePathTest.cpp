@@ -0,0 +1,195 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <catch2/catch.hpp>
+#include "GenericAttribute.h"
+#include "GenericAttributePath.h"
+#include "JSON_Parser.h"
+#include "Timer.h"
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static const char * const config = R"({
+	"render" : {
+		"shadow" : { "bias" : 0.5, "size" : 2048, "enabled" : true, "mode" : "pcf" },
+		"name" : "a rather long name that is not stored inline"
+	},
+	"lights" : [ { "color" : "red" }, { "color" : "green" }, [ 1, 2, 3 ] ]
+})";
+
+TEST_CASE("GenericAttributePathTest_testParse", "[GenericAttributePathTest]") {
+	using Util::GenericAttributePath;
+	const GenericAttributePath path("lights[2][10].color");
+	REQUIRE(path.size() == 4);
+	REQUIRE(!path.getSteps()[0].isIndex);
+	REQUIRE(path.getSteps()[0].key == Util::StringIdentifier("lights"));
+	REQUIRE(path.getSteps()[1].isIndex);
+	REQUIRE(path.getSteps()[1].index == 2);
+	REQUIRE(path.getSteps()[2].index == 10);
+	REQUIRE(path.getSteps()[3].key == Util::StringIdentifier("color"));
+	REQUIRE(path.toString() == "lights[2][10].color");
+	REQUIRE(GenericAttributePath("[0].a").toString() == "[0].a");
+	REQUIRE(GenericAttributePath("").empty());
+
+	GenericAttributePath built;
+	built.appendKey("render").appendKey("shadow").appendIndex(1);
+	REQUIRE(built.toString() == "render.shadow[1]");
+
+	REQUIRE_THROWS_AS(GenericAttributePath("a..b"), std::invalid_argument);
+	REQUIRE_THROWS_AS(GenericAttributePath("a."), std::invalid_argument);
+	REQUIRE_THROWS_AS(GenericAttributePath(".a"), std::invalid_argument);
+	REQUIRE_THROWS_AS(GenericAttributePath("a[]"), std::invalid_argument);
+	REQUIRE_THROWS_AS(GenericAttributePath("a[1"), std::invalid_argument);
+	REQUIRE_THROWS_AS(GenericAttributePath("a[x]"), std::invalid_argument);
+	REQUIRE_THROWS_AS(GenericAttributePath("a.[1]"), std::invalid_argument);
+	REQUIRE_THROWS_AS(GenericAttributePath("a]"), std::invalid_argument);
+}
+
+TEST_CASE("GenericAttributePathTest_testResolve", "[GenericAttributePathTest]") {
+	using Util::GenericAttributePath;
+	std::unique_ptr<Util::GenericAttribute> root(Util::JSON_Parser::parse(config));
+	REQUIRE(root.get() != nullptr);
+
+	REQUIRE(GenericAttributePath("render.shadow.bias").getFloat(root.get()) == 0.5f);
+	REQUIRE(GenericAttributePath("render.shadow.size").getInt(root.get()) == 2048);
+	REQUIRE(GenericAttributePath("render.shadow.size").getUInt(root.get()) == 2048);
+	REQUIRE(GenericAttributePath("render.shadow.size").getDouble(root.get()) == 2048.0);
+	REQUIRE(GenericAttributePath("render.shadow.enabled").getBool(root.get()));
+	REQUIRE(GenericAttributePath("render.shadow.mode").getString(root.get()) == "pcf");
+	REQUIRE(GenericAttributePath("render.name").getString(root.get()) == "a rather long name that is not stored inline");
+	REQUIRE(GenericAttributePath("lights[1].color").getString(root.get()) == "green");
+	REQUIRE(GenericAttributePath("lights[2][2]").getInt(root.get()) == 3);
+
+	// Missing elements and type mismatches give the default value.
+	REQUIRE(GenericAttributePath("render.shadow.missing").getFloat(root.get(), 1.5f) == 1.5f);
+	REQUIRE(GenericAttributePath("lights[3].color").getString(root.get(), "none") == "none");
+	REQUIRE(GenericAttributePath("render[0]").getInt(root.get(), 7) == 7);
+	REQUIRE(GenericAttributePath("lights.color").getInt(root.get(), 7) == 7);
+	REQUIRE(GenericAttributePath("render.shadow.bias.x").getInt(root.get(), 7) == 7);
+	REQUIRE(GenericAttributePath("").getInt(root.get(), 7) == 7);
+	REQUIRE(GenericAttributePath("render").getInt(nullptr, 7) == 7);
+
+	// Inline values are not converted by the typed getters.
+	const Util::GenericAttributeSlot * slot = GenericAttributePath("render.shadow.bias").findSlot(root.get());
+	REQUIRE(slot != nullptr);
+	REQUIRE(slot->isInline());
+
+	auto shadow = GenericAttributePath("render.shadow").getValue<Util::GenericAttributeMap>(root.get());
+	REQUIRE(shadow != nullptr);
+	REQUIRE(shadow->size() == 4);
+	REQUIRE(GenericAttributePath("render.shadow").getValue<Util::GenericAttributeList>(root.get()) == nullptr);
+	REQUIRE(GenericAttributePath("lights[2][0]").getValue(root.get())->toInt() == 1);
+	REQUIRE(GenericAttributePath("lights[5]").getValue(root.get()) == nullptr);
+	REQUIRE(GenericAttributePath("").getValue(root.get()) == nullptr);
+}
+
+TEST_CASE("GenericAttributePathTest_testShared", "[GenericAttributePathTest]") {
+	using Util::GenericAttributePath;
+	std::unique_ptr<Util::GenericAttributeMap> root(dynamic_cast<Util::GenericAttributeMap *>(Util::JSON_Parser::parse(config)));
+	REQUIRE(root.get() != nullptr);
+	std::unique_ptr<Util::GenericAttributeMap> copy(root->cloneShared());
+
+	// Reading does not copy the shared elements.
+	REQUIRE(GenericAttributePath("render.shadow.size").getInt(copy.get()) == 2048);
+	REQUIRE(copy->isShared());
+
+	// Modifying through getValue() does not affect the other map.
+	GenericAttributePath("render.shadow").getValue<Util::GenericAttributeMap>(copy.get())->setNumber("size", 512);
+	REQUIRE(GenericAttributePath("render.shadow.size").getInt(copy.get()) == 512);
+	REQUIRE(GenericAttributePath("render.shadow.size").getInt(root.get()) == 2048);
+}
+
+TEST_CASE("GenericAttributePathTest_testQuery", "[GenericAttributePathTest]") {
+	using Util::GenericAttributePath;
+	std::unique_ptr<Util::GenericAttribute> root(Util::JSON_Parser::parse(config));
+
+	Util::GenericAttributePathQuery query;
+	const std::size_t bias = query.addPath(GenericAttributePath("render.shadow.bias"));
+	const std::size_t size = query.addPath(GenericAttributePath("render.shadow.size"));
+	const std::size_t shadow = query.addPath(GenericAttributePath("render.shadow"));
+	const std::size_t missing = query.addPath(GenericAttributePath("render.missing.value"));
+	const std::size_t color = query.addPath(GenericAttributePath("lights[0].color"));
+	const std::size_t duplicate = query.addPath(GenericAttributePath("render.shadow.bias"));
+	const std::size_t empty = query.addPath(GenericAttributePath());
+	REQUIRE(query.getPathCount() == 7);
+
+	std::vector<const Util::GenericAttributeSlot *> results;
+	query.resolve(root.get(), results);
+	REQUIRE(results.size() == 7);
+	REQUIRE(results[bias] != nullptr);
+	REQUIRE(results[bias]->toFloat() == 0.5f);
+	REQUIRE(results[size]->toInt() == 2048);
+	REQUIRE(results[shadow]->getKind() == Util::GenericAttributeKind::MAP);
+	REQUIRE(results[missing] == nullptr);
+	REQUIRE(results[color]->toString() == "red");
+	REQUIRE(results[duplicate] == results[bias]);
+	REQUIRE(results[empty] == nullptr);
+
+	query.resolve(nullptr, results);
+	REQUIRE(results.size() == 7);
+	REQUIRE(results[bias] == nullptr);
+}
+
+TEST_CASE("GenericAttributePathBenchmark", "[.][GenericAttributePathBenchmark]") {
+	using namespace Util;
+	GenericAttributeMap root;
+	for(int i = 0; i < 20; ++i) {
+		auto section = new GenericAttributeMap;
+		for(int j = 0; j < 20; ++j) {
+			auto group = new GenericAttributeMap;
+			for(int k = 0; k < 20; ++k) {
+				group->setNumber("value" + std::to_string(k), static_cast<float>(k));
+			}
+			section->setValue("group" + std::to_string(j), group);
+		}
+		root.setValue("section" + std::to_string(i), section);
+	}
+	const std::size_t iterations = 1000000;
+
+	Timer timer;
+	float chainedSum = 0.0f;
+	for(std::size_t i = 0; i < iterations; ++i) {
+		chainedSum += root.getValue<GenericAttributeMap>("section7")->getValue<GenericAttributeMap>("group13")->getFloat("value5");
+		chainedSum += root.getValue<GenericAttributeMap>("section7")->getValue<GenericAttributeMap>("group13")->getFloat("value9");
+	}
+	timer.stop();
+	std::cout << "Chained lookup: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	const GenericAttributePath first("section7.group13.value5");
+	const GenericAttributePath second("section7.group13.value9");
+	float pathSum = 0.0f;
+	for(std::size_t i = 0; i < iterations; ++i) {
+		pathSum += first.getFloat(&root);
+		pathSum += second.getFloat(&root);
+	}
+	timer.stop();
+	std::cout << "GenericAttributePath: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	GenericAttributePathQuery query;
+	query.addPath(first);
+	query.addPath(second);
+	std::vector<const GenericAttributeSlot *> results;
+	float querySum = 0.0f;
+	for(std::size_t i = 0; i < iterations; ++i) {
+		query.resolve(&root, results);
+		querySum += results[0]->toFloat() + results[1]->toFloat();
+	}
+	timer.stop();
+	std::cout << "GenericAttributePathQuery: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	REQUIRE(pathSum == chainedSum);
+	REQUIRE(querySum == chainedSum);
+}
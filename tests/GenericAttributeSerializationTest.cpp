@@ -11,10 +11,16 @@
 #include <catch2/catch.hpp>
 #include "GenericAttribute.h"
 #include "GenericAttributeSerialization.h"
+#include "JSON_Parser.h"
 #include "StringIdentifier.h"
+#include "Timer.h"
+#include <cstdint>
 #include <functional>
+#include <iostream>
+#include <limits>
 #include <sstream>
 #include <tuple>
+#include <typeinfo>
 #include <utility>
 
 template<typename AttributeType, typename ValueType, typename ConversionFunction>
@@ -34,6 +40,8 @@ TEST_CASE("GenericAttributeSerializationTest_testStandardSerialization", "[Gener
 	testGenericAttributeSerialization<Util::_NumberAttribute<float>>(12.345f, "12.345", "numberFloat", &Util::GenericAttribute::toFloat);
 	testGenericAttributeSerialization<Util::_NumberAttribute<long>>(-234978l, "-234978", "numberLong", &Util::GenericAttribute::toInt);
 	testGenericAttributeSerialization<Util::_NumberAttribute<unsigned long>>(413214ul, "413214", "numberULong", &Util::GenericAttribute::toUnsignedInt);
+	testGenericAttributeSerialization<Util::_NumberAttribute<long long>>(-9007199254740993ll, "-9007199254740993", "numberLongLong", &Util::GenericAttribute::toString);
+	testGenericAttributeSerialization<Util::_NumberAttribute<unsigned long long>>(18446744073709551615ull, "18446744073709551615", "numberULongLong", &Util::GenericAttribute::toString);
 	testGenericAttributeSerialization<Util::_NumberAttribute<int>>(-234978, "-234978", "numberInt", &Util::GenericAttribute::toInt);
 	testGenericAttributeSerialization<Util::_NumberAttribute<unsigned int>>(413214u, "413214", "numberUInt", &Util::GenericAttribute::toUnsignedInt);
 	testGenericAttributeSerialization<Util::_NumberAttribute<short>>(-1200, "-1200", "numberShort", &Util::GenericAttribute::toInt);
@@ -43,6 +51,9 @@ TEST_CASE("GenericAttributeSerializationTest_testStandardSerialization", "[Gener
 	testGenericAttributeSerialization<Util::_NumberAttribute<char>>(0, "0", "numberByte", &Util::GenericAttribute::toInt);
 	testGenericAttributeSerialization<Util::_NumberAttribute<char>>(127, "127", "numberByte", &Util::GenericAttribute::toInt);
 
+	testGenericAttributeSerialization<Util::_NumberAttribute<signed char>>(-128, "-128", "numberSByte", &Util::GenericAttribute::toInt);
+	testGenericAttributeSerialization<Util::_NumberAttribute<signed char>>(127, "127", "numberSByte", &Util::GenericAttribute::toInt);
+
 	testGenericAttributeSerialization<Util::_NumberAttribute<unsigned char>>(0u, "0", "numberUByte", &Util::GenericAttribute::toUnsignedInt);
 	testGenericAttributeSerialization<Util::_NumberAttribute<unsigned char>>(127u, "127", "numberUByte", &Util::GenericAttribute::toUnsignedInt);
 	testGenericAttributeSerialization<Util::_NumberAttribute<unsigned char>>(255u, "255", "numberUByte", &Util::GenericAttribute::toUnsignedInt);
@@ -58,6 +69,49 @@ TEST_CASE("GenericAttributeSerializationTest_testStandardSerialization", "[Gener
 	testGenericAttributeSerialization<Util::_StringAttribute<std::string>>("'\"", "'\\\"", "string", &Util::GenericAttribute::toString);
 	testGenericAttributeSerialization<Util::_StringAttribute<std::string>>("[1, 2, 3]", "[1, 2, 3]", "string", &Util::GenericAttribute::toString);
 	testGenericAttributeSerialization<Util::_StringAttribute<std::string>>("a\nb\nc", "a\\nb\\nc", "string", &Util::GenericAttribute::toString);
+
+	// There is no type to look up for a missing attribute.
+	REQUIRE_THROWS_AS(Util::GenericAttributeSerialization::serialize(nullptr), std::bad_typeid);
+
+	// Large integers read by the JSON parser can be serialized, whatever 64-bit type holds them.
+	std::unique_ptr<Util::GenericAttribute> parsed(Util::JSON_Parser::parse("[9007199254740993, -9007199254740993, 18446744073709551615]"));
+	auto parsedList = parsed->toType<const Util::GenericAttributeList>();
+	REQUIRE(parsedList != nullptr);
+	for(const auto & element : *parsedList) {
+		std::unique_ptr<Util::GenericAttribute> attribute(Util::GenericAttributeSerialization::unserialize(Util::GenericAttributeSerialization::serialize(element.get())));
+		REQUIRE(typeid(*attribute) == typeid(*element.get()));
+		REQUIRE(attribute->toString() == element.get()->toString());
+	}
+	REQUIRE(parsedList->at(0)->toString() == "9007199254740993");
+	REQUIRE(parsedList->at(2)->toString() == "18446744073709551615");
+}
+
+TEST_CASE("GenericAttributeSerializationTest_testNumberArraySerialization", "[GenericAttributeSerializationTest]") {
+	std::unique_ptr<Util::GenericAttribute> floats(new Util::NumberArrayAttribute<float>(std::vector<float>{1.5f, -2.0f, 1.0e20f}));
+	const auto content = Util::GenericAttributeSerialization::serialize(floats.get());
+	REQUIRE(content.find("\"type\":\"numberArrayFloat\"") != std::string::npos);
+	std::unique_ptr<Util::GenericAttribute> attribute(Util::GenericAttributeSerialization::unserialize(content));
+	REQUIRE(typeid(*floats) == typeid(*attribute));
+	REQUIRE(*floats == *attribute);
+
+	std::unique_ptr<Util::GenericAttribute> empty(new Util::NumberArrayAttribute<unsigned short>);
+	std::unique_ptr<Util::GenericAttribute> emptyAttribute(Util::GenericAttributeSerialization::unserialize(Util::GenericAttributeSerialization::serialize(empty.get())));
+	REQUIRE(*empty == *emptyAttribute);
+
+	// Arrays within a list
+	std::unique_ptr<Util::GenericAttributeList> container(new Util::GenericAttributeList);
+	container->push_back(new Util::NumberArrayAttribute<int>(std::vector<int>{-1, 0, 1 << 30}));
+	container->push_back(new Util::NumberArrayAttribute<unsigned char>(std::vector<unsigned char>{0, 34, 92, 255}));
+	std::unique_ptr<Util::GenericAttribute> list(Util::GenericAttributeSerialization::unserialize(Util::GenericAttributeSerialization::serialize(container.get())));
+	REQUIRE(*container == *list);
+
+	// The bytes are little-endian on every machine.
+	std::unique_ptr<Util::GenericAttribute> ints(new Util::NumberArrayAttribute<int>(std::vector<int>{1, 256}));
+	REQUIRE(Util::GenericAttributeSerialization::serialize(ints.get()).find("\"AQAAAAABAAA=\"") != std::string::npos);
+	std::unique_ptr<Util::GenericAttribute> fixedInts(Util::GenericAttributeSerialization::unserialize("{\"type\":\"numberArrayInt\",\"value\":\"AQAAAAABAAA=\"}"));
+	REQUIRE(*ints == *fixedInts);
+
+	REQUIRE_THROWS_AS(Util::GenericAttributeSerialization::unserialize("{\"type\":\"numberArrayInt\",\"value\":\"AAA=\"}"), std::logic_error);
 }
 
 static void checkGenericAttributeMapsEqual(const Util::GenericAttributeMap * expected, const Util::GenericAttributeMap * actual);
@@ -412,3 +466,177 @@ TEST_CASE("GenericAttributeSerializationTest_testCustomWithContextSerialization"
 																			"5 deux deux un trois quatre", 
 																			"noDefaultConstructorGenericAttribute", &Util::GenericAttribute::toString, context.get());
 }
+
+TEST_CASE("GenericAttributeSerializationTest_testReplaceBuiltInSerializer", "[GenericAttributeSerializationTest]") {
+	using namespace Util;
+	const auto serializeYesNo = [](const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
+		return std::make_pair(std::string("yesNo"), std::string(attributeAndContext.first->toBool() ? "yes" : "no"));
+	};
+	const auto unserializeYesNo = [](const GenericAttributeSerialization::unserializer_parameter_t & contentAndContext) -> GenericAttribute * {
+		return GenericAttribute::createBool(contentAndContext.first == "yes");
+	};
+	REQUIRE(GenericAttributeSerialization::registerSerializer<BoolAttribute>("yesNo", serializeYesNo, unserializeYesNo));
+	BoolAttribute attribute(true);
+	REQUIRE(GenericAttributeSerialization::serialize(&attribute) == "{\"type\":\"yesNo\",\"value\":\"yes\"}");
+	std::unique_ptr<GenericAttribute> newAttribute(GenericAttributeSerialization::unserialize(GenericAttributeSerialization::serialize(&attribute)));
+	REQUIRE(newAttribute->toBool());
+
+	// Restore the standard representation for the other tests.
+	const auto serializeBool = [](const GenericAttributeSerialization::serializer_parameter_t & attributeAndContext) {
+		return std::make_pair(std::string("bool"), attributeAndContext.first->toString());
+	};
+	const auto unserializeBool = [](const GenericAttributeSerialization::unserializer_parameter_t & contentAndContext) -> GenericAttribute * {
+		return GenericAttribute::createBool(contentAndContext.first == "true");
+	};
+	REQUIRE(GenericAttributeSerialization::registerSerializer<BoolAttribute>("bool", serializeBool, unserializeBool));
+	REQUIRE(GenericAttributeSerialization::serialize(&attribute) == "{\"type\":\"bool\",\"value\":\"true\"}");
+}
+
+template<typename Number>
+static void checkBinaryNumber(Number value) {
+	std::unique_ptr<Util::GenericAttribute> attribute(Util::GenericAttribute::createNumber<Number>(value));
+	const auto content = Util::GenericAttributeSerialization::serializeBinary(attribute.get());
+	std::unique_ptr<Util::GenericAttribute> newAttribute(Util::GenericAttributeSerialization::unserializeBinary(content));
+	REQUIRE(typeid(*attribute) == typeid(*newAttribute));
+	REQUIRE(static_cast<Util::_NumberAttribute<Number> *>(newAttribute.get())->get() == value);
+}
+TEST_CASE("GenericAttributeSerializationTest_testBinarySerialization", "[GenericAttributeSerializationTest]") {
+	using namespace Util;
+	checkBinaryNumber<double>(-0.1);
+	checkBinaryNumber<double>(std::numeric_limits<double>::max());
+	checkBinaryNumber<float>(3.5e-20f);
+	checkBinaryNumber<long long>(std::numeric_limits<long long>::min());
+	checkBinaryNumber<long long>(std::numeric_limits<long long>::max());
+	checkBinaryNumber<unsigned long long>(std::numeric_limits<unsigned long long>::max());
+	checkBinaryNumber<long>(-1);
+	checkBinaryNumber<unsigned long>(127);
+	checkBinaryNumber<int>(std::numeric_limits<int>::min());
+	checkBinaryNumber<unsigned int>(128);
+	checkBinaryNumber<short>(-300);
+	checkBinaryNumber<unsigned short>(65535);
+	checkBinaryNumber<char>('x');
+	checkBinaryNumber<signed char>(-128);
+	checkBinaryNumber<unsigned char>(255);
+
+	Util::GenericAttributeSerialization::registerSerializer<CustomGenericAttribute>(GATypeNameCGA, serializeCGA, unserializeCGA);
+
+	GenericAttributeMap map;
+	map.setBool("bool", true);
+	map.setNumber("int", -17);
+	map.setNumber("double", 0.25);
+	map.setNumber("long", 1234567890123L);
+	map.setString("short", "inline");
+	map.setString("long string", "a string that is too long to be stored inline");
+	map.setString("empty string", "");
+	map.setValue("empty", nullptr);
+	map.setValue("custom", new CustomGenericAttribute(std::make_pair(17ul, 42ul)));
+	map.setValue("array", GenericAttribute::createNumberArray<float>({1.5f, -2.0f, 3.25f}));
+	map.setValue("bytes", GenericAttribute::createNumberArray<unsigned char>({0, 128, 255}));
+	{
+		auto list = new GenericAttributeList;
+		list->pushBackNumber(1u);
+		list->pushBackString("two");
+		list->push_back(nullptr);
+		auto innerMap = new GenericAttributeMap;
+		innerMap->setNumber("x", 1.0f);
+		list->push_back(innerMap);
+		map.setValue("list", list);
+	}
+
+	const auto content = GenericAttributeSerialization::serializeBinary(&map);
+	REQUIRE(content.compare(0, 4, "GAB\x01") == 0);
+	std::unique_ptr<GenericAttribute> attribute(GenericAttributeSerialization::unserializeBinary(content));
+	auto newMap = attribute->toType<GenericAttributeMap>();
+	REQUIRE(newMap != nullptr);
+	REQUIRE(newMap->size() == map.size());
+	REQUIRE(newMap->getValue("empty") == nullptr);
+	REQUIRE(newMap->getString("long string") == "a string that is too long to be stored inline");
+	REQUIRE(newMap->getString("empty string").empty());
+	REQUIRE(typeid(*newMap->getValue("long")) == typeid(_NumberAttribute<long>));
+	REQUIRE(newMap->getValue("custom")->toUnsignedInt() == 59);
+	REQUIRE(*newMap->getValue("array") == *map.getValue("array"));
+	REQUIRE(*newMap->getValue("bytes") == *map.getValue("bytes"));
+	auto newList = newMap->getValue<GenericAttributeList>("list");
+	REQUIRE(newList != nullptr);
+	REQUIRE(newList->size() == 4);
+	REQUIRE((*newList)[2] == nullptr);
+	REQUIRE(*newList->at(3) == *map.getValue<GenericAttributeList>("list")->at(3));
+	// Serializing the unserialized attribute gives the same representation.
+	REQUIRE(GenericAttributeSerialization::serializeBinary(newMap) == content);
+
+	// Invalid representations
+	REQUIRE_THROWS_AS(GenericAttributeSerialization::unserializeBinary(GenericAttributeSerialization::serialize(newMap->getValue("array"))), std::logic_error);
+	REQUIRE_THROWS_AS(GenericAttributeSerialization::unserializeBinary(content + '\0'), std::logic_error);
+	for(std::size_t length = 0; length < content.size(); ++length) {
+		REQUIRE_THROWS_AS(GenericAttributeSerialization::unserializeBinary(content.substr(0, length)), std::logic_error);
+	}
+	std::unique_ptr<GenericAttribute> nothing(GenericAttributeSerialization::unserializeBinary(GenericAttributeSerialization::serializeBinary(nullptr)));
+	REQUIRE(nothing == nullptr);
+
+	// Deeply nested lists and maps are rejected instead of exhausting the stack.
+	std::string nestedLists("GAB\x01");
+	std::string nestedMaps("GAB\x01");
+	for(int i = 0; i < 2000000; ++i) {
+		nestedLists.push_back(static_cast<char>(GenericAttributeKind::LIST));
+		nestedLists.push_back('\x01');
+		nestedMaps.push_back(static_cast<char>(GenericAttributeKind::MAP));
+		nestedMaps.append("\x01\x01k", 3);
+	}
+	REQUIRE_THROWS_AS(GenericAttributeSerialization::unserializeBinary(nestedLists), std::logic_error);
+	REQUIRE_THROWS_AS(GenericAttributeSerialization::unserializeBinary(nestedMaps), std::logic_error);
+	{
+		// Moderate nesting is still accepted.
+		GenericAttributeList outer;
+		GenericAttributeList * inner = &outer;
+		for(int i = 0; i < 100; ++i) {
+			auto next = new GenericAttributeList;
+			inner->push_back(next);
+			inner = next;
+		}
+		std::unique_ptr<GenericAttribute> nested(GenericAttributeSerialization::unserializeBinary(GenericAttributeSerialization::serializeBinary(&outer)));
+		REQUIRE(*nested == outer);
+	}
+}
+
+TEST_CASE("GenericAttributeSerializationBinaryBenchmark", "[.][GenericAttributeSerializationBinaryBenchmark]") {
+	using namespace Util;
+	GenericAttributeMap tree;
+	for(int i = 0; i < 20000; ++i) {
+		auto entry = new GenericAttributeMap;
+		entry->setNumber("id", static_cast<unsigned int>(i));
+		entry->setNumber("x", static_cast<float>(i) * 0.1f);
+		entry->setNumber("y", -static_cast<double>(i) / 3.0);
+		entry->setBool("visible", i % 2 == 0);
+		entry->setString("name", "object number " + std::to_string(i));
+		auto list = new GenericAttributeList;
+		for(int j = 0; j < 4; ++j) {
+			list->pushBackNumber(i * 4 + j);
+		}
+		entry->setValue("children", list);
+		entry->setValue("matrix", GenericAttribute::createNumberArray<float>(std::vector<float>(16, static_cast<float>(i))));
+		tree.setValue("object" + std::to_string(i), entry);
+	}
+
+	Timer timer;
+	const std::string text = GenericAttributeSerialization::serialize(&tree);
+	timer.stop();
+	std::cout << "Text serialization: " << text.size() << " bytes, " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	const std::string binary = GenericAttributeSerialization::serializeBinary(&tree);
+	timer.stop();
+	std::cout << "Binary serialization: " << binary.size() << " bytes, " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	std::unique_ptr<GenericAttribute> fromText(GenericAttributeSerialization::unserialize(text));
+	timer.stop();
+	std::cout << "Text unserialization: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	std::unique_ptr<GenericAttribute> fromBinary(GenericAttributeSerialization::unserializeBinary(binary));
+	timer.stop();
+	std::cout << "Binary unserialization: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	REQUIRE(*fromBinary == tree);
+	REQUIRE(*fromText == tree);
+}
@@ -8,10 +8,21 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include <catch2/catch.hpp>
+#include "AttributeProvider.h"
 #include "GenericAttribute.h"
+#include "GenericAttributeSerialization.h"
+#include "JSON_Parser.h"
+#include "Timer.h"
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 static void testBoolGetters(const Util::BoolAttribute & attribute, bool expectedValue, const std::string & expectedString) {
 	REQUIRE(expectedValue == attribute.get());
@@ -180,3 +191,917 @@ TEST_CASE("GenericAttributeTest_testString", "[GenericAttributeTest]") {
 		REQUIRE(value == genericStringAttribute->toString());
 	}
 }
+
+TEST_CASE("GenericAttributeTest_testMap", "[GenericAttributeTest]") {
+	// Cover the linear search as well as the hash index.
+	for(const std::size_t count : {std::size_t(5), Util::GenericAttributeMap::INDEX_THRESHOLD, std::size_t(100)}) {
+		Util::GenericAttributeMap map;
+		for(std::size_t i = 0; i < count; ++i) {
+			map.setValue(Util::StringIdentifier("key" + std::to_string(i)), Util::GenericAttribute::create(static_cast<int>(i)));
+		}
+		REQUIRE(map.size() == count);
+		for(std::size_t i = 0; i < count; ++i) {
+			REQUIRE(map.getInt(Util::StringIdentifier("key" + std::to_string(i)), -1) == static_cast<int>(i));
+		}
+		REQUIRE_FALSE(map.contains(Util::StringIdentifier("missing")));
+		REQUIRE(map.getValue(Util::StringIdentifier("missing")) == nullptr);
+
+		// Replace
+		map.setString(Util::StringIdentifier("key0"), "zero");
+		REQUIRE(map.size() == count);
+		REQUIRE(map.getString(Util::StringIdentifier("key0")) == "zero");
+
+		// Remove every second element
+		for(std::size_t i = 0; i < count; i += 2) {
+			REQUIRE(map.unsetValue(Util::StringIdentifier("key" + std::to_string(i))));
+		}
+		REQUIRE_FALSE(map.unsetValue(Util::StringIdentifier("key0")));
+		REQUIRE(map.size() == count / 2);
+		for(std::size_t i = 0; i < count; ++i) {
+			REQUIRE(map.contains(Util::StringIdentifier("key" + std::to_string(i))) == (i % 2 == 1));
+		}
+		int sum = 0;
+		for(const auto & element : map) {
+			REQUIRE(element.first.toString() == "key" + element.second->toString());
+			sum += element.second->toInt();
+		}
+		REQUIRE(sum == static_cast<int>((count / 2) * (count / 2)));
+
+		std::unique_ptr<Util::GenericAttributeMap> clonedMap(map.clone());
+		REQUIRE(*clonedMap == map);
+		map.setValue(Util::StringIdentifier("key1"), nullptr);
+		REQUIRE(map.contains(Util::StringIdentifier("key1")));
+		REQUIRE(map.getValue(Util::StringIdentifier("key1")) == nullptr);
+
+		map.clear();
+		REQUIRE(map.empty());
+		REQUIRE_FALSE(map.contains(Util::StringIdentifier("key1")));
+	}
+}
+
+template<typename Map, typename SetFun>
+static void benchmarkMap(const std::string & name, std::size_t elementCount, SetFun setFun) {
+	const std::size_t mapCount = 100000 / elementCount;
+	std::vector<Util::StringIdentifier> keys;
+	for(std::size_t i = 0; i < elementCount; ++i) {
+		keys.emplace_back("GenericAttributeBenchmark_key" + std::to_string(i));
+	}
+	std::vector<Map> maps(mapCount);
+	Util::Timer timer;
+	for(auto & map : maps) {
+		for(const auto & key : keys) {
+			setFun(map, key, Util::GenericAttribute::create(1));
+		}
+	}
+	timer.stop();
+	const double insertTime = timer.getNanoseconds() / static_cast<double>(mapCount * elementCount);
+
+	std::size_t sum = 0;
+	timer.reset();
+	for(std::size_t round = 0; round < 20; ++round) {
+		for(const auto & map : maps) {
+			for(const auto & key : keys) {
+				sum += map.find(key)->second->toInt();
+			}
+		}
+	}
+	timer.stop();
+	const double lookupTime = timer.getNanoseconds() / static_cast<double>(20 * mapCount * elementCount);
+
+	timer.reset();
+	for(std::size_t round = 0; round < 20; ++round) {
+		for(const auto & map : maps) {
+			for(const auto & element : map) {
+				sum += element.second->toInt();
+			}
+		}
+	}
+	timer.stop();
+	const double iterationTime = timer.getNanoseconds() / static_cast<double>(20 * mapCount * elementCount);
+	REQUIRE(sum == 40 * mapCount * elementCount);
+	std::cout << name << " with " << elementCount << " elements: insert " << insertTime << " ns, lookup "
+			  << lookupTime << " ns, iteration " << iterationTime << " ns per element" << std::endl;
+}
+
+//! Adapter to look up elements of a GenericAttributeMap like in a std::unordered_map
+struct FlatMapAdapter {
+	Util::GenericAttributeMap map;
+	struct Found {
+		const Util::GenericAttribute * second;
+		const Found * operator->() const	{	return this;	}
+	};
+	Found find(const Util::StringIdentifier & key) const	{	return Found{map.findValue(key)};	}
+	Util::GenericAttributeMap::const_iterator begin() const	{	return map.begin();	}
+	Util::GenericAttributeMap::const_iterator end() const	{	return map.end();	}
+};
+
+TEST_CASE("GenericAttributeMapBenchmark", "[.][GenericAttributeMapBenchmark]") {
+	typedef std::unordered_map<Util::StringIdentifier, std::unique_ptr<Util::GenericAttribute>> HashMap;
+	for(const std::size_t elementCount : {std::size_t(4), std::size_t(12), std::size_t(64)}) {
+		benchmarkMap<HashMap>("std::unordered_map", elementCount,
+				[](HashMap & map, const Util::StringIdentifier & key, Util::GenericAttribute * value) {
+					map[key].reset(value);
+				});
+		benchmarkMap<FlatMapAdapter>("GenericAttributeMap", elementCount,
+				[](FlatMapAdapter & adapter, const Util::StringIdentifier & key, Util::GenericAttribute * value) {
+					adapter.map.setValue(key, value);
+				});
+	}
+}
+
+TEST_CASE("GenericAttributeTest_testKind", "[GenericAttributeTest]") {
+	using Util::GenericAttributeKind;
+	std::unique_ptr<Util::GenericAttribute> boolAttribute(Util::GenericAttribute::create(true));
+	std::unique_ptr<Util::GenericAttribute> intAttribute(Util::GenericAttribute::create(5));
+	std::unique_ptr<Util::GenericAttribute> doubleAttribute(Util::GenericAttribute::create(5.0));
+	std::unique_ptr<Util::GenericAttribute> stringAttribute(Util::GenericAttribute::createString("five"));
+	std::unique_ptr<Util::GenericAttribute> wrapperAttribute(Util::GenericAttribute::createUndefined(std::string("five")));
+	std::unique_ptr<Util::GenericAttribute> listAttribute(new Util::GenericAttributeList);
+	std::unique_ptr<Util::GenericAttribute> mapAttribute(new Util::GenericAttributeMap);
+	REQUIRE(boolAttribute->getKind() == GenericAttributeKind::BOOL);
+	REQUIRE(intAttribute->getKind() == GenericAttributeKind::NUMBER_INT);
+	REQUIRE(doubleAttribute->getKind() == GenericAttributeKind::NUMBER_DOUBLE);
+	REQUIRE(stringAttribute->getKind() == GenericAttributeKind::STRING);
+	REQUIRE(wrapperAttribute->getKind() == GenericAttributeKind::UNDEFINED);
+	REQUIRE(listAttribute->getKind() == GenericAttributeKind::LIST);
+	REQUIRE(mapAttribute->getKind() == GenericAttributeKind::MAP);
+	REQUIRE(std::unique_ptr<Util::GenericAttribute>(intAttribute->clone())->getKind() == GenericAttributeKind::NUMBER_INT);
+
+	REQUIRE(intAttribute->isA<Util::_NumberAttribute<int>>());
+	REQUIRE_FALSE(intAttribute->isA<Util::_NumberAttribute<unsigned int>>());
+	REQUIRE_FALSE(intAttribute->isA<Util::BoolAttribute>());
+	REQUIRE(intAttribute->toType<Util::_NumberAttribute<int>>()->get() == 5);
+	REQUIRE(doubleAttribute->toType<const Util::_NumberAttribute<float>>() == nullptr);
+	// Abstract base classes and other types use RTTI.
+	REQUIRE(intAttribute->isA<Util::GenericNumberAttribute>());
+	REQUIRE(stringAttribute->isA<Util::GenericStringAttribute>());
+	REQUIRE_FALSE(stringAttribute->isA<Util::GenericNumberAttribute>());
+	REQUIRE(wrapperAttribute->isA<Util::WrapperAttribute<std::string>>());
+	REQUIRE_FALSE(wrapperAttribute->isA<Util::StringAttribute>());
+	REQUIRE(wrapperAttribute->toType<Util::GenericAttributeMap>() == nullptr);
+
+	// Classes derived from built-in types keep the kind of their base.
+	struct DerivedBoolAttribute : public Util::BoolAttribute {
+		DerivedBoolAttribute() : Util::BoolAttribute(true) {}
+	};
+	std::unique_ptr<Util::GenericAttribute> derivedAttribute(new DerivedBoolAttribute);
+	REQUIRE(derivedAttribute->isA<Util::BoolAttribute>());
+	REQUIRE(derivedAttribute->isA<DerivedBoolAttribute>());
+	REQUIRE_FALSE(boolAttribute->isA<DerivedBoolAttribute>());
+	REQUIRE(*derivedAttribute == *boolAttribute);
+
+	Util::GenericAttributeMap map;
+	map.setValue(Util::StringIdentifier("int"), intAttribute->clone());
+	REQUIRE(map.getValue<Util::_NumberAttribute<int>>(Util::StringIdentifier("int")) != nullptr);
+	REQUIRE(map.getValue<Util::BoolAttribute>(Util::StringIdentifier("int")) == nullptr);
+	REQUIRE(map.getValue<Util::BoolAttribute>(Util::StringIdentifier("missing")) == nullptr);
+}
+
+TEST_CASE("GenericAttributeKindBenchmark", "[.][GenericAttributeKindBenchmark]") {
+	std::vector<std::unique_ptr<Util::GenericAttribute>> attributes;
+	for(int i = 0; i < 1000; ++i) {
+		switch(i % 4) {
+			case 0:	attributes.emplace_back(Util::GenericAttribute::create(i));	break;
+			case 1:	attributes.emplace_back(Util::GenericAttribute::create(static_cast<double>(i)));	break;
+			case 2:	attributes.emplace_back(Util::GenericAttribute::createString(std::to_string(i)));	break;
+			default:	attributes.emplace_back(new Util::GenericAttributeMap);	break;
+		}
+	}
+	const std::size_t rounds = 2000;
+	std::size_t rttiCount = 0;
+	Util::Timer timer;
+	for(std::size_t round = 0; round < rounds; ++round) {
+		for(const auto & attribute : attributes) {
+			const Util::GenericAttribute * attr = attribute.get();
+			if(dynamic_cast<const Util::BoolAttribute *>(attr) != nullptr || dynamic_cast<const Util::_NumberAttribute<float> *>(attr) != nullptr ||
+					dynamic_cast<const Util::_NumberAttribute<int> *>(attr) != nullptr || dynamic_cast<const Util::_NumberAttribute<double> *>(attr) != nullptr ||
+					dynamic_cast<const Util::StringAttribute *>(attr) != nullptr || dynamic_cast<const Util::GenericAttributeMap *>(attr) != nullptr) {
+				++rttiCount;
+			}
+		}
+	}
+	timer.stop();
+	const double rttiTime = timer.getNanoseconds() / static_cast<double>(rounds * attributes.size());
+	std::size_t kindCount = 0;
+	timer.reset();
+	for(std::size_t round = 0; round < rounds; ++round) {
+		for(const auto & attribute : attributes) {
+			const Util::GenericAttribute * attr = attribute.get();
+			if(attr->isA<Util::BoolAttribute>() || attr->isA<Util::_NumberAttribute<float>>() ||
+					attr->isA<Util::_NumberAttribute<int>>() || attr->isA<Util::_NumberAttribute<double>>() ||
+					attr->isA<Util::StringAttribute>() || attr->isA<Util::GenericAttributeMap>()) {
+				++kindCount;
+			}
+		}
+	}
+	timer.stop();
+	const double kindTime = timer.getNanoseconds() / static_cast<double>(rounds * attributes.size());
+	REQUIRE(rttiCount == kindCount);
+	std::cout << "GenericAttribute type check: dynamic_cast " << rttiTime << " ns, kind " << kindTime << " ns per attribute" << std::endl;
+}
+
+TEST_CASE("GenericAttributeTest_testInlineValues", "[GenericAttributeTest]") {
+	Util::GenericAttributeMap map;
+	map.setBool(Util::StringIdentifier("bool"), true);
+	map.setNumber(Util::StringIdentifier("int"), -7);
+	map.setNumber(Util::StringIdentifier("uint"), 7u);
+	map.setNumber(Util::StringIdentifier("float"), 0.5f);
+	map.setNumber(Util::StringIdentifier("double"), 2.25);
+	map.setNumber(Util::StringIdentifier("short"), static_cast<short>(3));
+	map.setString(Util::StringIdentifier("string"), "1");
+	map.setString(Util::StringIdentifier("longString"), "This string is too long to be stored inline.");
+	for(const auto & element : map) {
+		const bool expectInline = element.first != Util::StringIdentifier("short") && element.first != Util::StringIdentifier("longString");
+		REQUIRE(element.second.isInline() == expectInline);
+	}
+
+	// The conversions of inline values are identical to those of the attributes.
+	std::unique_ptr<Util::GenericAttributeMap> reference(new Util::GenericAttributeMap);
+	reference->setValue(Util::StringIdentifier("bool"), Util::GenericAttribute::create(true));
+	reference->setValue(Util::StringIdentifier("int"), Util::GenericAttribute::create(-7));
+	reference->setValue(Util::StringIdentifier("uint"), Util::GenericAttribute::create(7u));
+	reference->setValue(Util::StringIdentifier("float"), Util::GenericAttribute::create(0.5f));
+	reference->setValue(Util::StringIdentifier("double"), Util::GenericAttribute::create(2.25));
+	reference->setValue(Util::StringIdentifier("short"), Util::GenericAttribute::create(static_cast<short>(3)));
+	reference->setValue(Util::StringIdentifier("string"), Util::GenericAttribute::createString("1"));
+	reference->setValue(Util::StringIdentifier("longString"), Util::GenericAttribute::createString("This string is too long to be stored inline."));
+	for(const auto & element : *reference) {
+		const Util::StringIdentifier & key = element.first;
+		const Util::GenericAttribute * attribute = element.second.get();
+		REQUIRE(map.getBool(key) == attribute->toBool());
+		REQUIRE(map.getInt(key) == attribute->toInt());
+		REQUIRE(map.getUInt(key) == attribute->toUnsignedInt());
+		REQUIRE(map.getFloat(key) == attribute->toFloat());
+		REQUIRE(map.getDouble(key) == attribute->toDouble());
+		REQUIRE(map.getString(key) == attribute->toString());
+	}
+	REQUIRE(map.toJSON().size() == reference->toJSON().size());
+	REQUIRE(map == *reference);
+	REQUIRE(*reference == map);
+
+	std::unique_ptr<Util::GenericAttributeMap> clonedMap(map.clone());
+	REQUIRE(*clonedMap == map);
+	REQUIRE(clonedMap->begin()->second.isInline());
+
+	// Requesting a pointer creates the attribute, which then holds the value.
+	auto boolAttribute = map.getValue<Util::BoolAttribute>(Util::StringIdentifier("bool"));
+	REQUIRE(boolAttribute != nullptr);
+	REQUIRE(map.getValue(Util::StringIdentifier("bool")) == boolAttribute);
+	boolAttribute->set(false);
+	REQUIRE_FALSE(map.getBool(Util::StringIdentifier("bool")));
+	REQUIRE(map.getValue<Util::_NumberAttribute<int>>(Util::StringIdentifier("int"))->get() == -7);
+	REQUIRE(map.getValue<Util::_NumberAttribute<float>>(Util::StringIdentifier("int")) == nullptr);
+	REQUIRE(map.getValue<Util::StringAttribute>(Util::StringIdentifier("string"))->get() == "1");
+	REQUIRE(*clonedMap != map);
+	REQUIRE_FALSE(map.getValue(Util::StringIdentifier("string"))->toJSON().empty());
+
+	Util::GenericAttributeList list;
+	list.pushBackBool(true);
+	list.pushBackNumber(1.5f);
+	list.pushBackString("text");
+	list.push_back(Util::GenericAttribute::create(4));
+	REQUIRE(list.toJSON() == "[true,1.5,\"text\",4]");
+	REQUIRE(list.implode(";") == "true;1.5;text;4");
+	REQUIRE(list.at(2)->isA<Util::StringAttribute>());
+	REQUIRE(list.front()->toBool());
+	std::unique_ptr<Util::GenericAttributeList> clonedList(list.clone());
+	REQUIRE(*clonedList == list);
+}
+
+TEST_CASE("GenericAttributeInlineBenchmark", "[.][GenericAttributeInlineBenchmark]") {
+	// A configuration tree with 100000 scalars
+	std::string json = "[";
+	for(int i = 0; i < 1000; ++i) {
+		json += i == 0 ? "{" : ",{";
+		for(int j = 0; j < 100; ++j) {
+			json += (j == 0 ? "\"key" : ",\"key") + std::to_string(j) + "\":";
+			switch(j % 4) {
+				case 0:	json += std::to_string(i * j);	break;
+				case 1:	json += "true";	break;
+				case 2:	json += "\"value" + std::to_string(j) + '"';	break;
+				default:	json += "0.25";	break;
+			}
+		}
+		json += '}';
+	}
+	json += ']';
+
+	Util::Timer timer;
+	std::unique_ptr<Util::GenericAttribute> tree(Util::JSON_Parser::parse(json));
+	timer.stop();
+	const double parseTime = timer.getMilliseconds();
+	auto list = tree->toType<Util::GenericAttributeList>();
+	REQUIRE(list->size() == 1000);
+	double sum = 0.0;
+	timer.reset();
+	for(const auto & element : *list) {
+		const auto map = element->toType<Util::GenericAttributeMap>();
+		for(const auto & mapElement : *map) {
+			sum += mapElement.second.toDouble();
+		}
+	}
+	timer.stop();
+	const double readTime = timer.getMilliseconds();
+	timer.reset();
+	tree.reset();
+	timer.stop();
+	const double destroyTime = timer.getMilliseconds();
+	std::cout << "Inline values: parse " << parseTime << " ms, read " << readTime << " ms, destroy " << destroyTime << " ms" << std::endl;
+
+	// Force an attribute for every scalar, which is what every element used to cost.
+	tree.reset(Util::JSON_Parser::parse(json));
+	list = tree->toType<Util::GenericAttributeList>();
+	timer.reset();
+	double attributeSum = 0.0;
+	for(const auto & element : *list) {
+		const auto map = element->toType<Util::GenericAttributeMap>();
+		for(const auto & mapElement : *map) {
+			attributeSum += mapElement.second->toDouble();
+		}
+	}
+	timer.stop();
+	const double materializeTime = timer.getMilliseconds();
+	timer.reset();
+	tree.reset();
+	timer.stop();
+	REQUIRE(sum == attributeSum);
+	std::cout << "Attributes: additional " << materializeTime << " ms to create, destroy " << timer.getMilliseconds() << " ms" << std::endl;
+	std::cout << "Bytes per map element: inline " << sizeof(Util::GenericAttributeMap::value_type)
+			  << ", attribute " << sizeof(Util::GenericAttributeMap::value_type) << " + " << sizeof(Util::_NumberAttribute<float>)
+			  << ".." << sizeof(Util::StringAttribute) << " + allocation overhead" << std::endl;
+}
+
+TEST_CASE("GenericAttributeTest_testCopyOnWrite", "[GenericAttributeTest]") {
+	using namespace Util;
+	GenericAttributeMap original;
+	original.setNumber("number", 5);
+	original.setString("name", "original");
+	auto nested = new GenericAttributeMap;
+	nested->setBool("flag", true);
+	auto deeper = new GenericAttributeMap;
+	deeper->setNumber("depth", 2);
+	nested->setValue("deeper", deeper);
+	original.setValue("nested", nested);
+
+	std::unique_ptr<GenericAttributeMap> copy(original.cloneShared());
+	REQUIRE(copy->isShared());
+	REQUIRE(original.isShared());
+	REQUIRE(original == *copy);
+	// Reading scalars does not copy.
+	REQUIRE(copy->getInt("number") == 5);
+	REQUIRE(copy->getString("name") == "original");
+	REQUIRE(copy->isShared());
+	// Neither does reading attributes through a const map.
+	const GenericAttributeMap & constCopy = *copy;
+	REQUIRE(constCopy.findValue<GenericAttributeMap>("nested") == nested);
+	std::size_t elementCount = 0;
+	for(const auto & element : constCopy) {
+		REQUIRE(element.second);
+		++elementCount;
+	}
+	REQUIRE(elementCount == 3);
+	REQUIRE(copy->isShared());
+
+	// Modifying the copy only changes the copy.
+	copy->setNumber("number", 7);
+	REQUIRE_FALSE(copy->isShared());
+	REQUIRE_FALSE(original.isShared());
+	REQUIRE(original.getInt("number") == 5);
+	REQUIRE(copy->getInt("number") == 7);
+
+	// Nested maps are shared again and copied only along the modified path.
+	auto copiedNested = copy->getValue<GenericAttributeMap>("nested");
+	REQUIRE(copiedNested != nested);
+	REQUIRE(copiedNested->isShared());
+	copiedNested->getValue<GenericAttributeMap>("deeper")->setNumber("depth", 3);
+	REQUIRE(deeper->getInt("depth") == 2);
+	REQUIRE(copiedNested->getValue<GenericAttributeMap>("deeper")->getInt("depth") == 3);
+	REQUIRE(copiedNested->getBool("flag"));
+	REQUIRE_FALSE(original == *copy);
+
+	// Removing from the original does not affect the copy.
+	std::unique_ptr<GenericAttributeMap> secondCopy(original.cloneShared());
+	REQUIRE(original.unsetValue("name"));
+	REQUIRE_FALSE(original.contains("name"));
+	REQUIRE(secondCopy->getString("name") == "original");
+	REQUIRE(secondCopy->size() == 3);
+
+	// Attributes that are obtained by getValue() may be modified in place.
+	std::unique_ptr<GenericAttributeMap> thirdCopy(secondCopy->cloneShared());
+	secondCopy->setValue("attribute", GenericAttribute::createString("shared"));
+	std::unique_ptr<GenericAttributeMap> fourthCopy(secondCopy->cloneShared());
+	secondCopy->getValue<StringAttribute>("attribute")->set("modified");
+	REQUIRE(fourthCopy->getString("attribute") == "shared");
+	REQUIRE_FALSE(thirdCopy->contains("attribute"));
+
+	// AttributeProvider copies share their attributes.
+	AttributeProvider provider;
+	provider.setAttribute("value", GenericAttribute::createNumber(1));
+	AttributeProvider providerCopy(provider);
+	REQUIRE(providerCopy.getAttributes()->isShared());
+	providerCopy.setAttribute("value", GenericAttribute::createNumber(2));
+	REQUIRE(provider.getAttribute("value")->toInt() == 1);
+	REQUIRE(providerCopy.getAttribute("value")->toInt() == 2);
+	// Reading attributes leaves them shared, even if they cannot be cloned.
+	typedef WrapperAttribute<std::unique_ptr<int>> PointerAttribute;
+	provider.setAttribute("pointer", new PointerAttribute(new int(3)));
+	AttributeProvider readingCopy(provider);
+	REQUIRE(*readingCopy.getAttribute<PointerAttribute>("pointer")->get() == 3);
+	REQUIRE(readingCopy.getAttribute("value")->toInt() == 1);
+	REQUIRE(readingCopy.getAttributes()->isShared());
+	// Attributes that are modified in place are copied first.
+	AttributeProvider writingCopy(providerCopy);
+	writingCopy.getMutableAttribute<_NumberAttribute<int>>("value")->set(3);
+	REQUIRE_FALSE(writingCopy.getAttributes()->isShared());
+	REQUIRE(providerCopy.getAttribute("value")->toInt() == 2);
+	REQUIRE(writingCopy.getAttribute("value")->toInt() == 3);
+
+	// The deprecated const getValue() still returns a mutable attribute and copies shared elements.
+	std::unique_ptr<GenericAttributeMap> fifthCopy(fourthCopy->cloneShared());
+	const GenericAttributeMap & constFifthCopy = *fifthCopy;
+	REQUIRE(constFifthCopy.findValue<StringAttribute>("attribute")->get() == "shared");
+	REQUIRE(fifthCopy->isShared());
+	constFifthCopy.getValue<StringAttribute>("attribute")->set("modified");
+	REQUIRE(fourthCopy->getString("attribute") == "shared");
+	REQUIRE(fifthCopy->getString("attribute") == "modified");
+}
+
+TEST_CASE("GenericAttributeCopyOnWriteBenchmark", "[.][GenericAttributeCopyOnWriteBenchmark]") {
+	// An object with 50 attributes including a nested map with 50 attributes
+	Util::AttributeProvider prototype;
+	auto nested = new Util::GenericAttributeMap;
+	for(int i = 0; i < 50; ++i) {
+		const std::string key = "key" + std::to_string(i);
+		prototype.setAttribute(key, Util::GenericAttribute::createString("a value that is too long to be inline " + key));
+		nested->setValue(key, Util::GenericAttribute::createNumber(static_cast<long long>(i)));
+	}
+	prototype.setAttribute("nested", nested);
+
+	const std::size_t objectCount = 100000;
+	for(const bool shared : {false, true}) {
+		std::vector<Util::AttributeProvider> objects;
+		objects.reserve(objectCount);
+		Util::Timer timer;
+		for(std::size_t i = 0; i < objectCount; ++i) {
+			if(shared) {
+				objects.emplace_back(prototype);
+			} else {
+				objects.emplace_back();
+				objects.back().setAttributes(prototype.getAttributes()->clone());
+			}
+		}
+		timer.stop();
+		const double copyTime = timer.getMilliseconds();
+		timer.reset();
+		for(auto & object : objects) {
+			object.setAttribute("key0", Util::GenericAttribute::createNumber(1));
+		}
+		timer.stop();
+		const double writeTime = timer.getMilliseconds();
+		timer.reset();
+		objects.clear();
+		timer.stop();
+		std::cout << (shared ? "Copy-on-write" : "Deep clone") << ": copy " << objectCount << " objects " << copyTime
+				  << " ms, first write " << writeTime << " ms, destroy " << timer.getMilliseconds() << " ms" << std::endl;
+	}
+}
+
+TEST_CASE("GenericAttributeTest_testJSON", "[GenericAttributeTest]") {
+	using namespace Util;
+	GenericAttributeMap map;
+	map.setBool("bool", false);
+	map.setNumber("int", -3);
+	map.setString("short", "a \"b\"");
+	map.setString("long", "a string with a\nnewline and a \\ backslash");
+	auto list = new GenericAttributeList;
+	list->push_back(GenericAttribute::createNumber(1.5));
+	list->push_back(new GenericAttributeMap);
+	list->push_back(new GenericAttributeList);
+	map.setValue("list", list);
+	const std::string expected = "{\"bool\":false,\"int\":-3,\"short\":\"a \\\"b\\\"\","
+			"\"long\":\"a string with a\\nnewline and a \\\\ backslash\",\"list\":[1.5,{},[]]}";
+	REQUIRE(map.toJSON() == expected);
+
+	std::ostringstream stream;
+	map.writeJSON(stream);
+	REQUIRE(stream.str() == expected);
+
+	// A buffer can be reused.
+	std::string buffer;
+	map.appendJSON(buffer);
+	buffer += ' ';
+	list->appendJSON(buffer);
+	REQUIRE(buffer == expected + " [1.5,{},[]]");
+
+	// The parser reads the output.
+	std::unique_ptr<GenericAttribute> parsed(JSON_Parser::parse(expected));
+	REQUIRE(parsed->toJSON() == expected);
+
+	// Large trees are passed to the stream in blocks.
+	struct RecordingBuffer : public std::stringbuf {
+		std::streamsize largestWrite = 0;
+		std::streamsize xsputn(const char * s, std::streamsize count) override {
+			largestWrite = std::max(largestWrite, count);
+			return std::stringbuf::xsputn(s, count);
+		}
+	};
+	GenericAttributeList largeList;
+	for(int i = 0; i < 10000; ++i) {
+		auto element = new GenericAttributeMap;
+		element->setNumber("index", i);
+		element->setString("name", "element number " + std::to_string(i));
+		largeList.push_back(element);
+	}
+	RecordingBuffer recordingBuffer;
+	std::ostream recordingStream(&recordingBuffer);
+	largeList.writeJSON(recordingStream);
+	REQUIRE(recordingBuffer.str() == largeList.toJSON());
+	REQUIRE(recordingBuffer.str().size() > 4 * 64 * 1024);
+	REQUIRE(recordingBuffer.largestWrite < 2 * 64 * 1024);
+}
+
+//! Reference implementation that concatenates the strings of the children
+static std::string concatenateJSON(const Util::GenericAttribute & attribute) {
+	std::ostringstream s;
+	if(auto map = attribute.toType<const Util::GenericAttributeMap>()) {
+		s << '{';
+		bool first = true;
+		for(const auto & element : *map) {
+			s << (first ? "\"" : ",\"") << element.first.toString() << "\":" << concatenateJSON(*element.second);
+			first = false;
+		}
+		s << '}';
+	} else if(auto list = attribute.toType<const Util::GenericAttributeList>()) {
+		s << '[';
+		bool first = true;
+		for(const auto & element : *list) {
+			s << (first ? "" : ",") << concatenateJSON(*element);
+			first = false;
+		}
+		s << ']';
+	} else if(attribute.toType<const Util::StringAttribute>()) {
+		s << '"' << Util::StringUtils::escape(attribute.toString()) << '"';
+	} else {
+		s << attribute.toJSON();
+	}
+	return s.str();
+}
+
+TEST_CASE("GenericAttributeJSONBenchmark", "[.][GenericAttributeJSONBenchmark]") {
+	// A tree of nested maps and lists with a JSON representation of about 50 MB
+	std::unique_ptr<Util::GenericAttributeList> tree(new Util::GenericAttributeList);
+	for(int i = 0; i < 3600; ++i) {
+		auto object = new Util::GenericAttributeMap;
+		for(int j = 0; j < 20; ++j) {
+			auto child = new Util::GenericAttributeMap;
+			child->setNumber("index", i * 20 + j);
+			child->setBool("visible", j % 2 == 0);
+			child->setString("name", "node \"" + std::to_string(j) + "\"");
+			auto values = new Util::GenericAttributeList;
+			for(int k = 0; k < 20; ++k) {
+				values->push_back(Util::GenericAttribute::createString("a value\nwith a line break " + std::to_string(k)));
+			}
+			child->setValue("values", values);
+			object->setValue("child" + std::to_string(j), child);
+		}
+		tree->push_back(object);
+	}
+
+	Util::Timer timer;
+	const std::string concatenated = concatenateJSON(*tree);
+	timer.stop();
+	std::cout << "Concatenated strings: " << concatenated.size() / 1000000.0 << " MB in " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	const std::string json = tree->toJSON();
+	timer.stop();
+	std::cout << "toJSON(): " << timer.getMilliseconds() << " ms" << std::endl;
+	REQUIRE(json == concatenated);
+
+	std::string buffer;
+	buffer.reserve(json.size());
+	timer.reset();
+	tree->appendJSON(buffer);
+	timer.stop();
+	std::cout << "appendJSON() into a reused buffer: " << timer.getMilliseconds() << " ms" << std::endl;
+	REQUIRE(buffer == json);
+
+	std::ostringstream stream;
+	timer.reset();
+	tree->writeJSON(stream);
+	timer.stop();
+	std::cout << "writeJSON(): " << timer.getMilliseconds() << " ms" << std::endl;
+	REQUIRE(stream.str().size() == json.size());
+}
+
+TEST_CASE("GenericAttributeTest_testList", "[GenericAttributeTest]") {
+	using namespace Util;
+	GenericAttributeList list;
+	REQUIRE(list.empty());
+	REQUIRE(list.at(0) == nullptr);
+	list.reserve(10);
+	REQUIRE(list.capacity() >= 10);
+
+	std::vector<GenericAttribute *> attributes;
+	for(int i = 0; i < 3; ++i) {
+		attributes.push_back(GenericAttribute::createNumber(i));
+	}
+	list.push_back(attributes.begin(), attributes.end());
+	std::vector<GenericAttributeSlot> slots;
+	slots.push_back(GenericAttributeSlot::createBool(true));
+	slots.push_back(GenericAttributeSlot::createString("text"));
+	list.push_back(std::make_move_iterator(slots.begin()), std::make_move_iterator(slots.end()));
+	list.push_front(GenericAttribute::createString("first"));
+	REQUIRE(list.size() == 6);
+
+	REQUIRE(list.at(-1) == nullptr);
+	REQUIRE(list.at(6) == nullptr);
+	REQUIRE(list.at(0)->toString() == "first");
+	REQUIRE(list.at(3)->toInt() == 2);
+	REQUIRE(list[4].isInline());
+	REQUIRE(list[4].toBool());
+	REQUIRE(list[5].toString() == "text");
+	REQUIRE(list.toJSON() == "[\"first\",0,1,2,true,\"text\"]");
+
+	list.erase(list.begin() + 1, list.begin() + 3);
+	REQUIRE(list.toJSON() == "[\"first\",2,true,\"text\"]");
+	std::unique_ptr<GenericAttributeList> clonedList(list.clone());
+	REQUIRE(*clonedList == list);
+}
+
+TEST_CASE("GenericAttributeListBenchmark", "[.][GenericAttributeListBenchmark]") {
+	const std::size_t count = 2000000;
+	Util::Timer timer;
+	std::deque<Util::GenericAttributeSlot> deque;
+	for(std::size_t i = 0; i < count; ++i) {
+		deque.emplace_back(Util::GenericAttributeSlot::createNumber(static_cast<int>(i)));
+	}
+	timer.stop();
+	const double dequeFillTime = timer.getMilliseconds();
+	timer.reset();
+	long long dequeSum = 0;
+	for(const auto & slot : deque) {
+		dequeSum += slot.toInt();
+	}
+	timer.stop();
+	std::cout << "std::deque: fill " << dequeFillTime << " ms, iterate " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	Util::GenericAttributeList list;
+	list.reserve(count);
+	for(std::size_t i = 0; i < count; ++i) {
+		list.pushBackNumber(static_cast<int>(i));
+	}
+	timer.stop();
+	const double listFillTime = timer.getMilliseconds();
+	timer.reset();
+	long long listSum = 0;
+	for(const auto & slot : list) {
+		listSum += slot.toInt();
+	}
+	timer.stop();
+	const double listIterateTime = timer.getMilliseconds();
+	timer.reset();
+	long long indexSum = 0;
+	for(std::size_t i = 0; i < count; ++i) {
+		indexSum += list[i].toInt();
+	}
+	timer.stop();
+	REQUIRE(dequeSum == listSum);
+	REQUIRE(dequeSum == indexSum);
+	std::cout << "GenericAttributeList: fill " << listFillTime << " ms, iterate " << listIterateTime
+			  << " ms, indexed access " << timer.getMilliseconds() << " ms" << std::endl;
+}
+
+TEST_CASE("GenericAttributeTest_testNumberArray", "[GenericAttributeTest]") {
+	using namespace Util;
+	const float values[] = {1.5f, -2.0f, 3.25f};
+	std::unique_ptr<GenericAttribute> floats(new NumberArrayAttribute<float>(values, 3));
+	REQUIRE(floats->getKind() == GenericAttributeKind::NUMBER_ARRAY_FLOAT);
+	auto floatArray = floats->toType<NumberArrayAttribute<float>>();
+	REQUIRE(floatArray != nullptr);
+	REQUIRE(floats->toType<NumberArrayAttribute<double>>() == nullptr);
+	REQUIRE(floats->toType<GenericAttributeList>() == nullptr);
+	REQUIRE(floatArray->size() == 3);
+	REQUIRE((*floatArray)[2] == 3.25f);
+	REQUIRE(floats->toJSON() == "[1.5,-2,3.25]");
+
+	std::unique_ptr<GenericAttribute> clone(floats->clone());
+	REQUIRE(*clone == *floats);
+	floatArray->get().push_back(4.0f);
+	REQUIRE_FALSE(*clone == *floats);
+
+	// Bytes are written as numbers.
+	std::unique_ptr<NumberArrayAttribute<unsigned char>> bytes(GenericAttribute::createNumberArray(std::vector<unsigned char>{0, 65, 255}));
+	REQUIRE(bytes->getKind() == GenericAttributeKind::NUMBER_ARRAY_UNSIGNED_CHAR);
+	REQUIRE(bytes->toJSON() == "[0,65,255]");
+	REQUIRE(NumberArrayAttribute<signed char>(std::vector<signed char>{-128, 0, 127}).toJSON() == "[-128,0,127]");
+	REQUIRE(NumberArrayAttribute<int>().toJSON() == "[]");
+
+	// Numbers that need more than six digits are written without loss.
+	const std::vector<double> doubles{0.1234567, 1.0 / 3.0, 123456789.0, 0.1 + 0.2, -1.0e-300};
+	std::unique_ptr<GenericAttribute> parsedDoubles(JSON_Parser::parse(NumberArrayAttribute<double>(doubles).toJSON()));
+	auto parsedList = parsedDoubles->toType<GenericAttributeList>();
+	REQUIRE(parsedList != nullptr);
+	REQUIRE(parsedList->size() == doubles.size());
+	for(std::size_t i = 0; i < doubles.size(); ++i) {
+		REQUIRE(parsedList->at(static_cast<int>(i))->toDouble() == doubles[i]);
+	}
+	const std::vector<float> floatValues{0.1234567f, 1.0f / 3.0f, 16777215.0f};
+	std::unique_ptr<GenericAttribute> parsedFloats(JSON_Parser::parse(NumberArrayAttribute<float>(floatValues).toJSON()));
+	for(std::size_t i = 0; i < floatValues.size(); ++i) {
+		REQUIRE(parsedFloats->toType<GenericAttributeList>()->at(static_cast<int>(i))->toFloat() == floatValues[i]);
+	}
+
+	// Within containers
+	GenericAttributeMap map;
+	map.setValue("vertices", GenericAttribute::createNumberArray(std::vector<double>{0.5, 1.0}));
+	REQUIRE(map.toJSON() == "{\"vertices\":[0.5,1]}");
+	REQUIRE(map.getValue<NumberArrayAttribute<double>>("vertices")->get() == std::vector<double>({0.5, 1.0}));
+}
+
+TEST_CASE("GenericAttributeNumberArrayBenchmark", "[.][GenericAttributeNumberArrayBenchmark]") {
+	const std::size_t count = 1000000;
+	std::vector<float> source(count);
+	for(std::size_t i = 0; i < count; ++i) {
+		source[i] = static_cast<float>(i) * 0.5f;
+	}
+
+	Util::Timer timer;
+	std::vector<float> copy(count);
+	std::memcpy(copy.data(), source.data(), count * sizeof(float));
+	timer.stop();
+	std::cout << "memcpy: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	std::unique_ptr<Util::GenericAttributeList> list(new Util::GenericAttributeList);
+	list->reserve(count);
+	for(const float value : source) {
+		list->push_back(Util::GenericAttribute::createNumber(value));
+	}
+	timer.stop();
+	const double listLoadTime = timer.getMilliseconds();
+	timer.reset();
+	list.reset();
+	timer.stop();
+	std::cout << "GenericAttributeList of _NumberAttribute<float>: load " << listLoadTime << " ms, destroy " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	std::unique_ptr<Util::NumberArrayAttribute<float>> array(new Util::NumberArrayAttribute<float>(source.data(), count));
+	timer.stop();
+	std::cout << "NumberArrayAttribute<float>: load " << timer.getMilliseconds() << " ms" << std::endl;
+
+	Util::GenericAttributeSerialization::init();
+	timer.reset();
+	const std::string serialization = Util::GenericAttributeSerialization::serialize(array.get());
+	timer.stop();
+	const double serializeTime = timer.getMilliseconds();
+	timer.reset();
+	std::unique_ptr<Util::GenericAttribute> unserialized(Util::GenericAttributeSerialization::unserialize(serialization));
+	timer.stop();
+	REQUIRE(*unserialized == *array);
+	std::cout << "Serialization (" << serialization.size() / 1000000.0 << " MB): serialize " << serializeTime
+			  << " ms, unserialize " << timer.getMilliseconds() << " ms" << std::endl;
+}
+
+TEST_CASE("GenericAttributeTest_testStructuralHash", "[GenericAttributeTest]") {
+	using namespace Util;
+	// Leaves: equal values have equal hashes; inline values match their attributes.
+	REQUIRE(_NumberAttribute<int>(5).getStructuralHash() == GenericAttributeSlot::createNumber(5).getStructuralHash());
+	REQUIRE(_NumberAttribute<double>(0.0).getStructuralHash() == _NumberAttribute<double>(-0.0).getStructuralHash());
+	REQUIRE(BoolAttribute(true).getStructuralHash() == GenericAttributeSlot::createBool(true).getStructuralHash());
+	REQUIRE(StringAttribute("short").getStructuralHash() == GenericAttributeSlot::createString("short").getStructuralHash());
+	REQUIRE(_NumberAttribute<int>(5).getStructuralHash() != _NumberAttribute<int>(6).getStructuralHash());
+	REQUIRE(_NumberAttribute<int>(5).getStructuralHash() != _NumberAttribute<float>(5.0f).getStructuralHash());
+	REQUIRE(StringAttribute("5").getStructuralHash() != _NumberAttribute<int>(5).getStructuralHash());
+	REQUIRE(NumberArrayAttribute<float>(std::vector<float>{1.0f, 2.0f}).getStructuralHash() ==
+			NumberArrayAttribute<float>(std::vector<float>{1.0f, 2.0f}).getStructuralHash());
+	REQUIRE(NumberArrayAttribute<float>(std::vector<float>{1.0f, 2.0f}).getStructuralHash() !=
+			NumberArrayAttribute<float>(std::vector<float>{2.0f, 1.0f}).getStructuralHash());
+
+	// Maps do not depend on the order of insertion; lists do.
+	std::unique_ptr<GenericAttributeMap> first(new GenericAttributeMap);
+	first->setNumber("a", 1);
+	first->setString("b", "text");
+	auto firstList = new GenericAttributeList;
+	firstList->pushBackNumber(1);
+	firstList->pushBackNumber(2);
+	first->setValue("list", firstList);
+	std::unique_ptr<GenericAttributeMap> second(new GenericAttributeMap);
+	auto secondList = new GenericAttributeList;
+	secondList->push_back(GenericAttribute::createNumber(1));
+	secondList->push_back(GenericAttribute::createNumber(2));
+	second->setValue("list", secondList);
+	second->setValue("b", GenericAttribute::createString("text"));
+	second->setNumber("a", 1);
+	REQUIRE(*first == *second);
+	REQUIRE(first->getStructuralHash() == second->getStructuralHash());
+	REQUIRE(GenericAttributeMap().getStructuralHash() != GenericAttributeList().getStructuralHash());
+
+	GenericAttributeList reversed;
+	reversed.pushBackNumber(2);
+	reversed.pushBackNumber(1);
+	REQUIRE(reversed.getStructuralHash() != secondList->getStructuralHash());
+
+	// Modifications reset the cached values along the path.
+	const uint64_t unmodifiedHash = first->getStructuralHash();
+	first->getValue<GenericAttributeList>("list")->pushBackNumber(3);
+	REQUIRE(first->getStructuralHash() != unmodifiedHash);
+	REQUIRE(*first != *second);
+	first->getValue<GenericAttributeList>("list")->erase(std::prev(first->getValue<GenericAttributeList>("list")->end()));
+	REQUIRE(first->getStructuralHash() == unmodifiedHash);
+	first->getValue<_NumberAttribute<int>>("a")->set(7);
+	REQUIRE(first->getStructuralHash() != unmodifiedHash);
+	first->setNumber("a", 1);
+	REQUIRE(first->getStructuralHash() == unmodifiedHash);
+	first->unsetValue("b");
+	REQUIRE(first->getStructuralHash() != unmodifiedHash);
+
+	// Outdated cached values do not affect comparisons.
+	GenericAttributeMap outdated;
+	auto outdatedList = new GenericAttributeList;
+	outdatedList->pushBackNumber(1);
+	outdated.setValue("list", outdatedList);
+	GenericAttributeMap current;
+	auto currentList = new GenericAttributeList;
+	currentList->pushBackNumber(2);
+	current.setValue("list", currentList);
+	REQUIRE(outdated.getStructuralHash() != current.getStructuralHash());
+	REQUIRE(outdatedList->getStructuralHash() != currentList->getStructuralHash());
+	outdatedList->at(0)->toType<_NumberAttribute<int>>()->set(2);
+	REQUIRE(*outdatedList == *currentList);
+	REQUIRE(outdated == current);
+
+	// Reading a const list keeps the cached value; non-const access resets it.
+	GenericAttributeList cachedList;
+	auto element = new _NumberAttribute<int>(1);
+	cachedList.push_back(element);
+	const uint64_t cachedHash = cachedList.getStructuralHash();
+	const GenericAttributeList & constList = cachedList;
+	REQUIRE(constList.at(0) == element);
+	REQUIRE(constList[0].get() == element);
+	REQUIRE(std::distance(constList.begin(), constList.end()) == 1);
+	element->set(2);
+	REQUIRE(cachedList.getStructuralHash() == cachedHash);
+	REQUIRE(cachedList.at(0) == element);
+	REQUIRE(cachedList.getStructuralHash() != cachedHash);
+
+	// Shared maps share the cached value until one of them is modified.
+	std::unique_ptr<GenericAttributeMap> copy(second->cloneShared());
+	REQUIRE(copy->getStructuralHash() == second->getStructuralHash());
+	copy->setNumber("c", 3);
+	REQUIRE(copy->getStructuralHash() != second->getStructuralHash());
+	REQUIRE(second->getStructuralHash() == unmodifiedHash);
+	std::unique_ptr<GenericAttributeMap> deepCopy(second->clone());
+	REQUIRE(deepCopy->getStructuralHash() == second->getStructuralHash());
+
+	// A moved-from list is empty and has the hash of an empty list.
+	GenericAttributeList moved(std::move(reversed));
+	REQUIRE(reversed.getStructuralHash() == GenericAttributeList().getStructuralHash());
+	REQUIRE(moved.size() == 2);
+}
+
+TEST_CASE("GenericAttributeHashBenchmark", "[.][GenericAttributeHashBenchmark]") {
+	using namespace Util;
+	// Two large trees that differ in one value
+	std::unique_ptr<GenericAttributeMap> first(new GenericAttributeMap);
+	for(int i = 0; i < 1000; ++i) {
+		auto entry = new GenericAttributeMap;
+		for(int j = 0; j < 100; ++j) {
+			entry->setNumber("value" + std::to_string(j), i * j);
+		}
+		first->setValue("entry" + std::to_string(i), entry);
+	}
+	std::unique_ptr<GenericAttributeMap> second(first->clone());
+	second->getValue<GenericAttributeMap>("entry999")->setNumber("value99", -1);
+
+	Timer timer;
+	const bool equal = *first == *second;
+	timer.stop();
+	std::cout << "Comparison without hash values: " << timer.getMilliseconds() << " ms" << std::endl;
+	REQUIRE(!equal);
+
+	timer.reset();
+	first->getStructuralHash();
+	second->getStructuralHash();
+	timer.stop();
+	std::cout << "Computation of the hash values: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	const std::size_t iterations = 1000;
+	timer.reset();
+	for(std::size_t i = 0; i < iterations; ++i) {
+		REQUIRE(*first != *second);
+	}
+	timer.stop();
+	std::cout << iterations << " comparisons with cached hash values: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	uint64_t hashSum = 0;
+	for(std::size_t i = 0; i < iterations; ++i) {
+		second->getValue<GenericAttributeMap>("entry500")->setNumber("value0", static_cast<int>(i));
+		hashSum += second->getStructuralHash();
+	}
+	timer.stop();
+	std::cout << iterations << " modifications and hash updates: " << timer.getMilliseconds() << " ms" << std::endl;
+	REQUIRE(hashSum != 0);
+}
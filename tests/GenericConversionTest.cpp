@@ -9,11 +9,18 @@
 */
 #include <catch2/catch.hpp>
 #include "Generic.h"
+#include "GenericAttribute.h"
 #include "GenericConversion.h"
+#include "JSON_Parser.h"
 #include "StringIdentifier.h"
 #include "StringUtils.h"
+#include "Timer.h"
+#include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
 #include <vector>
 
@@ -31,8 +38,9 @@ static bool checkGenericsEqual(const Util::Generic & expected, const Util::Gener
 		REQUIRE(expected.ref<bool>() == actual.ref<bool>());
 		return true;
 	} else if(expected.contains<float>()) {
-		REQUIRE(actual.contains<float>());
-		REQUIRE(expected.ref<float>() == actual.ref<float>());
+		// Numbers with a fraction are read as double.
+		REQUIRE(actual.contains<double>());
+		REQUIRE(expected.ref<float>() == static_cast<float>(actual.ref<double>()));
 		return true;
 	} else if(expected.contains<std::string>()) {
 		REQUIRE(actual.contains<std::string>());
@@ -88,22 +96,31 @@ TEST_CASE("GenericConversionTest_testBasicSerialization", "[GenericConversionTes
 	testGenericSerialization<bool, bool>(true, "true", true);
 	testGenericSerialization<bool, bool>(false, "false", false);
 
-	testGenericSerialization<double, float>(25.6789, "25.6789", 25.6789f);
-	testGenericSerialization<float, float>(12.345f, "12.345", 12.345f);
-	testGenericSerialization<long, float>(-234978l, "-234978", -234978.0f);
-	testGenericSerialization<unsigned long, float>(413214ul, "413214", 413214.0f);
-	testGenericSerialization<int, float>(-234978, "-234978", -234978.0f);
-	testGenericSerialization<unsigned int, float>(413214u, "413214", 413214.0f);
-	testGenericSerialization<short, float>(-1200, "-1200", -1200.0f);
-	testGenericSerialization<unsigned short, float>(837u, "837", 837.0f);
+	testGenericSerialization<double, double>(25.6789, "25.6789", 25.6789);
+	testGenericSerialization<float, double>(12.345f, "12.345", 12.345);
+	testGenericSerialization<long, int>(-234978l, "-234978", -234978);
+	testGenericSerialization<unsigned long, int>(413214ul, "413214", 413214);
+	testGenericSerialization<int, int>(-234978, "-234978", -234978);
+	testGenericSerialization<unsigned int, int>(413214u, "413214", 413214);
+	testGenericSerialization<short, int>(-1200, "-1200", -1200);
+	testGenericSerialization<unsigned short, int>(837u, "837", 837);
 
-	testGenericSerialization<char, float>(-128, "-128", -128.0f);
-	testGenericSerialization<char, float>(0, "0", 0.0f);
-	testGenericSerialization<char, float>(127, "127", 127.0f);
+	testGenericSerialization<char, int>(-128, "-128", -128);
+	testGenericSerialization<char, int>(0, "0", 0);
+	testGenericSerialization<char, int>(127, "127", 127);
 
-	testGenericSerialization<unsigned char, float>(0u, "0", 0.0f);
-	testGenericSerialization<unsigned char, float>(127u, "127", 127.0f);
-	testGenericSerialization<unsigned char, float>(255u, "255", 255.0f);
+	testGenericSerialization<signed char, int>(-128, "-128", -128);
+	testGenericSerialization<signed char, int>(127, "127", 127);
+
+	testGenericSerialization<unsigned char, int>(0u, "0", 0);
+	testGenericSerialization<unsigned char, int>(127u, "127", 127);
+	testGenericSerialization<unsigned char, int>(255u, "255", 255);
+
+	// Integers beyond the range of int and double are read exactly.
+	typedef std::conditional<sizeof(long) >= 8, long, long long>::type integer64_t;
+	typedef std::conditional<sizeof(long) >= 8, unsigned long, unsigned long long>::type unsigned64_t;
+	testGenericSerialization<long long, integer64_t>(-9007199254740993ll, "-9007199254740993", -9007199254740993ll);
+	testGenericSerialization<unsigned long long, unsigned64_t>(18446744073709551615ull, "18446744073709551615", 18446744073709551615ull);
 
 	testGenericStringSerialization("Hello, world!");
 	testGenericStringSerialization("abc");
@@ -165,3 +182,131 @@ TEST_CASE("GenericConversionTest_testMapSerialization", "[GenericConversionTest]
 	const Util::Generic importedGenericArray = Util::GenericConversion::fromJSON(tempStream);
 	REQUIRE(checkGenericsEqual(genericMap, importedGenericArray));
 }
+
+TEST_CASE("GenericConversionTest_testNumberArrayConversion", "[GenericConversionTest]") {
+	std::unique_ptr<Util::GenericAttributeMap> map(new Util::GenericAttributeMap);
+	map->setValue(Util::StringIdentifier("floats"), Util::GenericAttribute::createNumberArray(std::vector<float>{1.5f, -2.0f}));
+	map->setValue(Util::StringIdentifier("bytes"), Util::GenericAttribute::createNumberArray(std::vector<unsigned char>{7, 255}));
+	map->setValue(Util::StringIdentifier("signedByte"), Util::GenericAttribute::createNumber(static_cast<signed char>(-7)));
+
+	const Util::Generic generic = Util::GenericConversion::fromGenericAttribute(map.get());
+	REQUIRE(generic.contains<GenericMap>());
+	const auto & genericMap = generic.ref<GenericMap>();
+	const Util::Generic & floats = genericMap.at(Util::StringIdentifier("floats"));
+	REQUIRE(floats.contains<std::vector<float>>());
+	REQUIRE(floats.ref<std::vector<float>>() == std::vector<float>({1.5f, -2.0f}));
+	const Util::Generic & bytes = genericMap.at(Util::StringIdentifier("bytes"));
+	REQUIRE(bytes.contains<std::vector<unsigned char>>());
+	const Util::Generic & signedByte = genericMap.at(Util::StringIdentifier("signedByte"));
+	REQUIRE(signedByte.contains<signed char>());
+	REQUIRE(signedByte.ref<signed char>() == -7);
+
+	std::stringstream floatStream;
+	Util::GenericConversion::toJSON(floats, floatStream);
+	REQUIRE(floatStream.str() == "[1.5,-2]");
+	std::stringstream byteStream;
+	Util::GenericConversion::toJSON(bytes, byteStream);
+	REQUIRE(byteStream.str() == "[7,255]");
+	std::stringstream signedByteStream;
+	Util::GenericConversion::toJSON(signedByte, signedByteStream);
+	REQUIRE(signedByteStream.str() == "-7");
+
+	// JSON arrays are read as arrays of Generic.
+	const Util::Generic imported = Util::GenericConversion::fromJSON(floatStream);
+	REQUIRE(imported.contains<GenericArray>());
+	REQUIRE(imported.ref<GenericArray>().size() == 2);
+}
+
+TEST_CASE("GenericConversionTest_testDirectConversion", "[GenericConversionTest]") {
+	using namespace Util;
+	std::stringstream input("{\"a\":[1,-2.5,\"x\",null,{\"b\":true}],\"c\":{},\"d\":1,\"d\":2,\"id\":1234567890123}");
+	const Generic generic = GenericConversion::fromJSON(input);
+	REQUIRE(generic.contains<GenericMap>());
+	const auto & map = generic.ref<GenericMap>();
+	REQUIRE(map.size() == 4);
+	const auto & array = map.at(StringIdentifier("a")).ref<GenericArray>();
+	REQUIRE(array.size() == 5);
+	REQUIRE(array[0].ref<int>() == 1);
+	REQUIRE(array[1].ref<double>() == -2.5);
+	REQUIRE(array[2].ref<std::string>() == "x");
+	REQUIRE(!array[3].valid());
+	REQUIRE(array[4].ref<GenericMap>().at(StringIdentifier("b")).ref<bool>());
+	REQUIRE(map.at(StringIdentifier("c")).ref<GenericMap>().empty());
+	// Like in a GenericAttributeMap, the last value of a key is used.
+	REQUIRE(map.at(StringIdentifier("d")).ref<int>() == 2);
+	REQUIRE(map.at(StringIdentifier("id")).getType() == (sizeof(long) >= 8 ? typeid(long) : typeid(long long)));
+
+	// The part of invalid data that could be read is returned.
+	std::stringstream invalid("[1,[2,3 4]");
+	const Generic partial = GenericConversion::fromJSON(invalid);
+	std::stringstream partialJSON;
+	GenericConversion::toJSON(partial, partialJSON);
+	REQUIRE(partialJSON.str() == "[1,[2,3]]");
+	std::stringstream empty("");
+	REQUIRE(!GenericConversion::fromJSON(empty).valid());
+
+	// Large data is written in several blocks; the result equals the one of the GenericAttributes.
+	GenericArray largeArray;
+	for(int i = 0; i < 20000; ++i) {
+		GenericMap element;
+		element.emplace(StringIdentifier("name"), Generic("element \"" + std::to_string(i) + '"'));
+		element.emplace(StringIdentifier("value"), Generic(i * 0.1));
+		largeArray.emplace_back(std::move(element));
+	}
+	std::stringstream largeJSON;
+	GenericConversion::toJSON(Generic(std::move(largeArray)), largeJSON);
+	REQUIRE(largeJSON.str().size() > 3 * 64 * 1024);
+	std::unique_ptr<GenericAttribute> attributes(JSON_Parser::parse(largeJSON.str()));
+	const Generic fromAttributes = GenericConversion::fromGenericAttribute(attributes.get());
+	const Generic direct = GenericConversion::fromJSON(largeJSON);
+	std::stringstream fromAttributesJSON;
+	GenericConversion::toJSON(fromAttributes, fromAttributesJSON);
+	std::unique_ptr<GenericAttribute> reparsed(JSON_Parser::parse(fromAttributesJSON.str()));
+	REQUIRE(*reparsed == *attributes);
+	const auto & directArray = direct.ref<GenericArray>();
+	REQUIRE(directArray.size() == 20000);
+	REQUIRE(directArray[12345].ref<GenericMap>().at(StringIdentifier("value")).ref<double>() == 12345 * 0.1);
+	REQUIRE(directArray[12345].ref<GenericMap>().at(StringIdentifier("name")).ref<std::string>() == "element \"12345\"");
+}
+
+TEST_CASE("GenericConversionBenchmark", "[.][GenericConversionBenchmark]") {
+	using namespace Util;
+	GenericArray array;
+	for(int i = 0; i < 550000; ++i) {
+		GenericMap element;
+		element.emplace(StringIdentifier("id"), Generic(1500000000000000000ll + i));
+		element.emplace(StringIdentifier("name"), Generic("object number " + std::to_string(i) + " with a longer description"));
+		element.emplace(StringIdentifier("x"), Generic(i * 0.1));
+		element.emplace(StringIdentifier("visible"), Generic(i % 2 == 0));
+		GenericArray values;
+		for(int j = 0; j < 8; ++j) {
+			values.emplace_back(i * 8 + j);
+		}
+		element.emplace(StringIdentifier("values"), Generic(std::move(values)));
+		array.emplace_back(std::move(element));
+	}
+	const Generic data(std::move(array));
+
+	Timer timer;
+	std::stringstream stream;
+	GenericConversion::toJSON(data, stream);
+	timer.stop();
+	const std::string json = stream.str();
+	std::cout << "Write " << json.size() << " bytes with toJSON(): " << timer.getMilliseconds() << " ms" << std::endl;
+
+	std::istringstream directInput(json);
+	timer.reset();
+	const Generic direct = GenericConversion::fromJSON(directInput);
+	timer.stop();
+	std::cout << "Read with fromJSON(): " << timer.getMilliseconds() << " ms" << std::endl;
+
+	std::istringstream attributeInput(json);
+	timer.reset();
+	std::unique_ptr<GenericAttribute> attributes(JSON_Parser::parse(attributeInput));
+	const Generic fromAttributes = GenericConversion::fromGenericAttribute(attributes.get());
+	timer.stop();
+	std::cout << "Read with JSON_Parser::parse() and fromGenericAttribute(): " << timer.getMilliseconds() << " ms" << std::endl;
+
+	REQUIRE(direct.ref<GenericArray>().size() == 550000);
+	REQUIRE(fromAttributes.ref<GenericArray>().size() == 550000);
+}
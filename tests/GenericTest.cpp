@@ -12,6 +12,7 @@
 #include <array>
 #include <cstdint>
 #include <string>
+#include <typeinfo>
 #include <vector>
 #include <unordered_map>
 
@@ -73,6 +74,12 @@ TEST_CASE("GenericTest_testBasic", "[GenericTest]") {
 	testContains({{false, false, false, false, false, true, false}}, vecAttr);
 	testContains({{false, false, false, false, false, false, false}}, emptyAttr);
 
+	REQUIRE(boolAttr.getType() == typeid(bool));
+	REQUIRE(doubleAttr.getType() == typeid(double));
+	REQUIRE(vecAttr.getType() == typeid(std::vector<uint32_t>));
+	REQUIRE(genericAttr.getType() == typeid(int32_t));
+	REQUIRE(emptyAttr.getType() == typeid(void));
+
 	REQUIRE_THROWS_AS(boolAttr.ref<float>(), std::bad_cast);
 	REQUIRE_THROWS_AS(emptyAttr.ref<float>(), std::bad_cast);
 }
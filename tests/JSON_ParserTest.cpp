@@ -0,0 +1,317 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <catch2/catch.hpp>
+#include "GenericAttribute.h"
+#include "JSON_Parser.h"
+#include "StringIdentifier.h"
+#include "Timer.h"
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+TEST_CASE("JSON_ParserTest_testParse", "[JSON_ParserTest]") {
+	using namespace Util;
+	const std::string json = "{"
+							 " \"1\":2 ,\n"
+							 " \"foo\":\"bar\" ,"
+							 " \"true\":false,"
+							 " \"bar\":true,"
+							 " \"nothing\":null,"
+							 " \"a\":[1,02e10,3.0,-2.5,\"27\",\"a\\\"a\\n\",],"
+							 " \"m\":{\"inner\":{}}"
+							 "}";
+	std::unique_ptr<GenericAttribute> attribute(JSON_Parser::parse(json));
+	auto map = dynamic_cast<GenericAttributeMap *>(attribute.get());
+	REQUIRE(map != nullptr);
+	REQUIRE(map->size() == 7);
+	REQUIRE(map->getFloat("1") == 2.0f);
+	REQUIRE(map->getString("foo") == "bar");
+	REQUIRE(!map->getBool("true", true));
+	REQUIRE(map->getBool("bar"));
+	REQUIRE(map->getValue("nothing") != nullptr);
+	auto list = map->getValue<GenericAttributeList>("a");
+	REQUIRE(list != nullptr);
+	REQUIRE(list->size() == 6);
+	REQUIRE(list->at(1)->toFloat() == 2e10f);
+	REQUIRE(list->at(3)->toFloat() == -2.5f);
+	REQUIRE(list->at(4)->toString() == "27");
+	REQUIRE(list->at(5)->toString() == "a\"a\n");
+	auto inner = map->getValue<GenericAttributeMap>("m");
+	REQUIRE(inner != nullptr);
+	REQUIRE(inner->getValue<GenericAttributeMap>("inner") != nullptr);
+
+	std::unique_ptr<GenericAttribute> scalar(JSON_Parser::parse(" \"a string that is not stored inline\" "));
+	REQUIRE(dynamic_cast<StringAttribute *>(scalar.get()) != nullptr);
+	REQUIRE(scalar->toString() == "a string that is not stored inline");
+	scalar.reset(JSON_Parser::parse("-17.5"));
+	REQUIRE(dynamic_cast<_NumberAttribute<double> *>(scalar.get()) != nullptr);
+	REQUIRE(scalar->toFloat() == -17.5f);
+
+	REQUIRE(JSON_Parser::parse("") == nullptr);
+	REQUIRE(JSON_Parser::parse("  \n") == nullptr);
+	REQUIRE(JSON_Parser::parse("}") == nullptr);
+	// Invalid data gives the part that could be read.
+	attribute.reset(JSON_Parser::parse("[1, 2 3]"));
+	REQUIRE(attribute != nullptr);
+	REQUIRE(attribute->toJSON() == "[1,2]");
+	attribute.reset(JSON_Parser::parse("{\"a\":[true],\"b\""));
+	REQUIRE(attribute != nullptr);
+	REQUIRE(attribute->toJSON() == "{\"a\":[true]}");
+}
+
+TEST_CASE("JSON_ParserTest_testNumbers", "[JSON_ParserTest]") {
+	using namespace Util;
+	// Integers are stored exactly, with the smallest type that holds them.
+	const std::string integers = "[0,-7,2147483647,-2147483648,2147483648,9007199254740993,-9223372036854775808,18446744073709551615]";
+	std::unique_ptr<GenericAttribute> attribute(JSON_Parser::parse(integers));
+	REQUIRE(attribute != nullptr);
+	REQUIRE(attribute->toJSON() == integers);
+	auto list = dynamic_cast<GenericAttributeList *>(attribute.get());
+	REQUIRE(list != nullptr);
+	const auto longKind = sizeof(long) == 8 ? GenericAttributeKind::NUMBER_LONG : GenericAttributeKind::NUMBER_LONG_LONG;
+	const auto unsignedLongKind = sizeof(long) == 8 ? GenericAttributeKind::NUMBER_UNSIGNED_LONG : GenericAttributeKind::NUMBER_UNSIGNED_LONG_LONG;
+	REQUIRE(list->at(1)->getKind() == GenericAttributeKind::NUMBER_INT);
+	REQUIRE(list->at(3)->getKind() == GenericAttributeKind::NUMBER_INT);
+	REQUIRE(list->at(3)->toInt() == std::numeric_limits<int>::min());
+	REQUIRE(list->at(4)->getKind() == longKind);
+	REQUIRE(list->at(5)->getKind() == longKind);
+	REQUIRE(list->at(6)->getKind() == longKind);
+	REQUIRE(list->at(7)->getKind() == unsignedLongKind);
+
+	// Other numbers are stored as correctly rounded doubles.
+	attribute.reset(JSON_Parser::parse("[0.1,-1e-3,1E300,4.9e-324,18446744073709551616,-9223372036854775809,0.30000000000000004]"));
+	list = dynamic_cast<GenericAttributeList *>(attribute.get());
+	REQUIRE(list != nullptr);
+	REQUIRE(list->size() == 7);
+	for(std::size_t i = 0; i < list->size(); ++i) {
+		REQUIRE(list->at(i)->getKind() == GenericAttributeKind::NUMBER_DOUBLE);
+	}
+	REQUIRE(list->at(0)->toDouble() == 0.1);
+	REQUIRE(list->at(1)->toDouble() == -0.001);
+	REQUIRE(list->at(2)->toDouble() == 1e300);
+	REQUIRE(list->at(3)->toDouble() == std::numeric_limits<double>::denorm_min());
+	REQUIRE(list->at(4)->toDouble() == 18446744073709551616.0);
+	REQUIRE(list->at(5)->toDouble() == -9223372036854775809.0);
+	REQUIRE(list->at(6)->toDouble() == 0.1 + 0.2);
+
+	attribute.reset(JSON_Parser::parse("1234567890123"));
+	REQUIRE(attribute->getKind() == longKind);
+	REQUIRE(attribute->toJSON() == "1234567890123");
+}
+
+TEST_CASE("JSON_ParserTest_testStream", "[JSON_ParserTest]") {
+	using namespace Util;
+	// Large enough to be read in several chunks, so that tokens cross the chunk boundaries.
+	std::ostringstream jsonStream;
+	jsonStream << '[';
+	for(int i = 0; i < 20000; ++i) {
+		jsonStream << "{\"key" << i << "\":\"escaped \\\"value\\\" " << i << "\",\"number\":" << i << ".25},";
+	}
+	jsonStream << "true]";
+	const std::string json = jsonStream.str();
+	REQUIRE(json.size() > 3 * 64 * 1024);
+
+	std::unique_ptr<GenericAttribute> fromString(JSON_Parser::parse(json));
+	std::istringstream input(json);
+	std::unique_ptr<GenericAttribute> fromStream(JSON_Parser::parse(input));
+	REQUIRE(fromString != nullptr);
+	REQUIRE(fromStream != nullptr);
+	REQUIRE(*fromString == *fromStream);
+	auto list = dynamic_cast<GenericAttributeList *>(fromStream.get());
+	REQUIRE(list != nullptr);
+	REQUIRE(list->size() == 20001);
+	auto element = dynamic_cast<GenericAttributeMap *>(list->at(12345));
+	REQUIRE(element != nullptr);
+	REQUIRE(element->getString("key12345") == "escaped \"value\" 12345");
+	REQUIRE(element->getFloat("number") == 12345.25f);
+
+	std::istringstream empty("");
+	REQUIRE(JSON_Parser::parse(empty) == nullptr);
+}
+
+TEST_CASE("JSON_ParserTest_testScanning", "[JSON_ParserTest]") {
+	using namespace Util;
+	// Quotes, escape sequences and white space at every position of the blocks that are scanned at once.
+	for(std::size_t length = 0; length < 140; ++length) {
+		const std::string plain(length, 'x');
+		const std::string space = std::string(length, ' ') + "\t\n\r";
+		const std::string json = space + "[\"" + plain + "\"," + space + "\"" + plain + "\\\"" + plain + "\"" + space + "]" + space;
+		std::unique_ptr<GenericAttribute> attribute(JSON_Parser::parse(json));
+		auto list = dynamic_cast<GenericAttributeList *>(attribute.get());
+		REQUIRE(list != nullptr);
+		REQUIRE(list->size() == 2);
+		REQUIRE(list->at(0)->toString() == plain);
+		REQUIRE(list->at(1)->toString() == plain + '"' + plain);
+	}
+
+	// Strings are checked for valid UTF-8; invalid ones are kept, but reported once per parse.
+	std::ostringstream warnings;
+	std::streambuf * previousBuffer = std::cerr.rdbuf(warnings.rdbuf());
+	const std::string longValid = std::string(100, 'x') + "\xe2\x82\xac" + std::string(100, 'x');
+	std::unique_ptr<GenericAttribute> valid(JSON_Parser::parse("[\"gr\xc3\xbc\xc3\x9f" "e\", \"\xe2\x82\xac\", \"" + longValid + "\"]"));
+	const std::string validWarnings = warnings.str();
+	const std::string longInvalid = std::string(100, 'x') + "\xfc" + std::string(100, 'x');
+	std::unique_ptr<GenericAttribute> invalid(JSON_Parser::parse("{\"key\": \"Latin-1 \xfc\", \"\xe4\": \"" + longInvalid + "\", \"escaped\": \"\\\xfc\"}"));
+	std::cerr.rdbuf(previousBuffer);
+	REQUIRE(validWarnings.empty());
+	const std::string invalidWarnings = warnings.str();
+	REQUIRE(invalidWarnings.find("4 string(s) are not valid UTF-8") != std::string::npos);
+	REQUIRE(invalidWarnings.find("not valid UTF-8") == invalidWarnings.rfind("not valid UTF-8"));
+	REQUIRE(valid->toType<GenericAttributeList>()->at(1)->toString() == "\xe2\x82\xac");
+	REQUIRE(valid->toType<GenericAttributeList>()->at(2)->toString() == longValid);
+	REQUIRE(invalid->toType<GenericAttributeMap>()->getString("key") == "Latin-1 \xfc");
+	REQUIRE(invalid->toType<GenericAttributeMap>()->getString("\xe4") == longInvalid);
+	REQUIRE(invalid->toType<GenericAttributeMap>()->getString("escaped") == "\xfc");
+}
+
+//! Record all events as a compact string.
+class RecordingVisitor : public Util::JSON_Parser::Visitor {
+	public:
+		std::ostringstream events;
+		bool enterObject() override							{	events << '{';	return true;	}
+		bool leaveObject() override							{	events << '}';	return true;	}
+		bool enterArray() override							{	events << '[';	return true;	}
+		bool leaveArray() override							{	events << ']';	return true;	}
+		bool visitKey(const std::string & key) override		{	events << key << ':';	return true;	}
+		bool visitString(const std::string & value) override	{	events << '"' << value << '"' << ' ';	return true;	}
+		bool visitNumber(double value) override				{	events << value << ' ';	return true;	}
+		bool visitBool(bool value) override					{	events << (value ? "T " : "F ");	return true;	}
+		bool visitNull() override							{	events << "N ";	return true;	}
+};
+
+//! Find the string value of a key and stop.
+class FindVisitor : public Util::JSON_Parser::Visitor {
+		const std::string wantedKey;
+		bool found;
+	public:
+		std::string value;
+		std::size_t numberCount;
+		explicit FindVisitor(std::string key) : wantedKey(std::move(key)), found(false), value(), numberCount(0) {}
+		bool visitKey(const std::string & key) override		{	found = (key == wantedKey);	return true;	}
+		bool visitNumber(double) override					{	++numberCount;	return true;	}
+		bool visitString(const std::string & text) override {
+			if(found) {
+				value = text;
+				return false;
+			}
+			return true;
+		}
+};
+
+TEST_CASE("JSON_ParserTest_testTraverse", "[JSON_ParserTest]") {
+	using namespace Util;
+	const std::string json = "{\"a\":[1,2.5,\"x\\\"y\",],\"b\":{\"c\":true,\"d\":null},\"e\":false,\"f\":{}}";
+	{
+		RecordingVisitor visitor;
+		REQUIRE(JSON_Parser::traverse(json, visitor));
+		REQUIRE(visitor.events.str() == "{a:[1 2.5 \"x\"y\" ]b:{c:T d:N }e:F f:{}}");
+	}
+	{
+		std::istringstream input(json);
+		RecordingVisitor visitor;
+		REQUIRE(JSON_Parser::traverse(input, visitor));
+		REQUIRE(visitor.events.str() == "{a:[1 2.5 \"x\"y\" ]b:{c:T d:N }e:F f:{}}");
+	}
+	{
+		// Numbers are reported with double precision.
+		RecordingVisitor visitor;
+		REQUIRE(JSON_Parser::traverse("[0.1]", visitor));
+		std::ostringstream expected;
+		expected << "[" << 0.1 << " ]";
+		REQUIRE(visitor.events.str() == expected.str());
+	}
+	{
+		// Integers are reported exactly.
+		struct IntegerVisitor : public JSON_Parser::Visitor {
+			std::ostringstream events;
+			bool visitNumber(double value) override						{	events << 'D' << value << ' ';	return true;	}
+			bool visitInteger(long long value) override					{	events << 'I' << value << ' ';	return true;	}
+			bool visitUnsignedInteger(unsigned long long value) override	{	events << 'U' << value << ' ';	return true;	}
+		} visitor;
+		REQUIRE(JSON_Parser::traverse("[-9223372036854775808,9223372036854775807,9223372036854775808,18446744073709551616,-0,2.5]", visitor));
+		REQUIRE(visitor.events.str() == "I-9223372036854775808 I9223372036854775807 U9223372036854775808 D1.84467e+19 I0 D2.5 ");
+	}
+	{
+		FindVisitor visitor("name");
+		REQUIRE(!JSON_Parser::traverse("[1,{\"id\":2,\"name\":\"found\"},3,4]", visitor));
+		REQUIRE(visitor.value == "found");
+		REQUIRE(visitor.numberCount == 2);
+	}
+	{
+		RecordingVisitor visitor;
+		REQUIRE(!JSON_Parser::traverse("{\"a\":[1 2]}", visitor));
+		REQUIRE(visitor.events.str() == "{a:[1 ");
+		REQUIRE(!JSON_Parser::traverse("[1,", visitor));
+		REQUIRE(!JSON_Parser::traverse("", visitor));
+	}
+}
+
+TEST_CASE("JSON_ParserBenchmark", "[.][JSON_ParserBenchmark]") {
+	using namespace Util;
+	GenericAttributeMap tree;
+	for(int i = 0; i < 100000; ++i) {
+		auto entry = new GenericAttributeMap;
+		entry->setNumber("x", static_cast<float>(i) * 0.5f);
+		entry->setNumber("id", 1500000000000000000ll + i);
+		entry->setString("name", "object number " + std::to_string(i) + " with a longer description");
+		auto list = new GenericAttributeList;
+		for(int j = 0; j < 4; ++j) {
+			list->pushBackNumber(i * 4 + j);
+		}
+		list->pushBackBool(true);
+		entry->setValue("values", list);
+		tree.setValue("object" + std::to_string(i), entry);
+	}
+	const std::string json = tree.toJSON();
+
+	Timer timer;
+	std::unique_ptr<GenericAttribute> fromString(JSON_Parser::parse(json));
+	timer.stop();
+	std::cout << "Parse " << json.size() << " bytes from a string: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	std::istringstream input(json);
+	timer.reset();
+	std::unique_ptr<GenericAttribute> fromStream(JSON_Parser::parse(input));
+	timer.stop();
+	std::cout << "Parse " << json.size() << " bytes from a stream: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	FindVisitor visitor("name");
+	JSON_Parser::traverse(json, visitor);
+	timer.stop();
+	std::cout << "Find a field with traverse(): " << timer.getMilliseconds() << " ms" << std::endl;
+
+	struct SumVisitor : public JSON_Parser::Visitor {
+		bool isX = false;
+		double sum = 0.0;
+		bool visitKey(const std::string & key) override	{	isX = (key == "x");	return true;	}
+		bool visitNumber(double value) override {
+			if(isX) {
+				sum += value;
+				isX = false;
+			}
+			return true;
+		}
+	} sumVisitor;
+	timer.reset();
+	JSON_Parser::traverse(json, sumVisitor);
+	timer.stop();
+	std::cout << "Sum all \"x\" values with traverse(): " << timer.getMilliseconds() << " ms" << std::endl;
+	REQUIRE(sumVisitor.sum == 0.5 * 99999.0 * 100000.0 / 2.0);
+
+	// Integers and doubles are read with their exact values, but possibly with other types.
+	REQUIRE(fromString->toJSON() == json);
+	REQUIRE(fromStream->toJSON() == json);
+}
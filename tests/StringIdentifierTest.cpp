@@ -0,0 +1,364 @@
+/*
+	This file is part of the Util library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	Copyright (C) 2014-2019 Sascha Brandt <sascha@brandt.graphics>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <catch2/catch.hpp>
+#include "StringIdentifier.h"
+#include "Timer.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! Occupy the hash value of @p str by a placeholder and return the identifier of @p str, which collides with it.
+static Util::StringIdentifier createCollision(const std::string & str) {
+	Util::StringIdentifier(Util::StringIdentifier::calcHash(str.data(), str.size())).toString();
+	return Util::StringIdentifier(str);
+}
+
+static std::vector<std::string> createKeys(const std::string & prefix, std::size_t count) {
+	std::vector<std::string> keys;
+	keys.reserve(count);
+	for(std::size_t i = 0; i < count; ++i) {
+		keys.emplace_back(prefix + std::to_string(i));
+	}
+	return keys;
+}
+
+TEST_CASE("StringIdentifierTest_testBasic", "[StringIdentifierTest]") {
+	const Util::StringIdentifier empty;
+	REQUIRE(empty.empty());
+	REQUIRE(Util::StringIdentifier(std::string()).empty());
+	
+	const Util::StringIdentifier a(std::string("StringIdentifierTest_a"));
+	const Util::StringIdentifier b(std::string("StringIdentifierTest_b"));
+	REQUIRE(a != b);
+	REQUIRE(a == Util::StringIdentifier(std::string("StringIdentifierTest_a")));
+	REQUIRE(std::string("StringIdentifierTest_a") == a.toString());
+	REQUIRE(std::string("StringIdentifierTest_b") == b.toString());
+
+	const auto keys = createKeys("StringIdentifierTest_key", 10000);
+	std::vector<uint32_t> ids;
+	for(const auto & key : keys) {
+		ids.push_back(Util::StringIdentifier(key).getValue());
+	}
+	for(std::size_t i = 0; i < keys.size(); ++i) {
+		REQUIRE(keys[i] == Util::StringIdentifier(ids[i]).toString());
+	}
+	std::sort(ids.begin(), ids.end());
+	REQUIRE(std::unique(ids.begin(), ids.end()) == ids.end());
+}
+
+TEST_CASE("StringIdentifierTest_testCharacters", "[StringIdentifierTest]") {
+	const Util::StringIdentifier fromString(std::string("StringIdentifierTest_chars"));
+	REQUIRE(fromString == Util::StringIdentifier("StringIdentifierTest_chars"));
+
+	const char * const buffer = "{\"StringIdentifierTest_chars\":1}";
+	const Util::StringIdentifier fromPart(buffer + 2, 26);
+	REQUIRE(fromString == fromPart);
+	REQUIRE(Util::StringIdentifier(buffer + 2, 25) != fromPart);
+	REQUIRE(std::string("StringIdentifierTest_char") == Util::StringIdentifier(buffer + 2, 25).toString());
+	REQUIRE(Util::StringIdentifier(buffer, 0).empty());
+
+	Util::StringIdentifier assigned;
+	assigned = "StringIdentifierTest_chars";
+	REQUIRE(fromString == assigned);
+}
+
+TEST_CASE("StringIdentifierTest_testStringView", "[StringIdentifierTest]") {
+	const Util::StringIdentifier id("StringIdentifierTest_view");
+	const Util::StringView view = id.toStringView();
+	REQUIRE(view == "StringIdentifierTest_view");
+	REQUIRE(view.size() == 25);
+	REQUIRE(view.data()[view.size()] == '\0');
+	// The characters are stored only once.
+	REQUIRE(Util::StringIdentifier("StringIdentifierTest_view").toStringView().data() == view.data());
+	REQUIRE(view.substr(21) == "view");
+
+	// The number zero is reserved for the empty string; it is not added to the table.
+	REQUIRE(Util::StringIdentifier().toStringView().empty());
+	REQUIRE(Util::StringIdentifier().toString().empty());
+	REQUIRE(Util::StringIdentifier(std::string()).empty());
+	REQUIRE(Util::StringIdentifier(view.data(), 0).empty());
+
+	// Long strings do not fit into a shared block.
+	const std::string longString(10000, 'x');
+	const Util::StringView longView = Util::StringIdentifier(longString).toStringView();
+	REQUIRE(longView == longString);
+}
+
+TEST_CASE("StringIdentifierTest_testConcurrency", "[StringIdentifierTest]") {
+	const auto keys = createKeys("StringIdentifierTest_concurrent", 19997);
+	const std::size_t threadCount = 8;
+	std::vector<std::vector<uint32_t>> results(threadCount);
+	std::vector<std::thread> threads;
+	for(std::size_t t = 0; t < threadCount; ++t) {
+		threads.emplace_back([&keys, &results, t]() {
+			// Every thread uses a different order (the number of keys is prime) to provoke
+			// concurrent insertions of the same key.
+			std::vector<uint32_t> & ids = results[t];
+			ids.resize(keys.size());
+			for(std::size_t i = 0; i < keys.size(); ++i) {
+				const std::size_t index = (i * (2 * t + 1) + t * 997) % keys.size();
+				ids[index] = Util::StringIdentifier(keys[index]).getValue();
+			}
+		});
+	}
+	for(auto & thread : threads) {
+		thread.join();
+	}
+	for(std::size_t t = 1; t < threadCount; ++t) {
+		REQUIRE(results[0] == results[t]);
+	}
+	for(std::size_t i = 0; i < keys.size(); ++i) {
+		REQUIRE(keys[i] == Util::StringIdentifier(results[0][i]).toString());
+	}
+}
+
+TEST_CASE("StringIdentifierTest_testLiterals", "[StringIdentifierTest]") {
+	using namespace Util::Literals;
+	constexpr auto literal = "StringIdentifierTest_literal"_sid;
+	static_assert(literal.getValue() != 0, "Literal has to be computed at compile time.");
+	REQUIRE(std::string("StringIdentifierTest_literal") == literal.toString());
+
+	// First use of the literal registers the string
+	const Util::StringIdentifier fromLiteral = literal;
+	REQUIRE(literal.getValue() == fromLiteral.getValue());
+	REQUIRE(std::string("StringIdentifierTest_literal") == fromLiteral.toString());
+	REQUIRE(fromLiteral == Util::StringIdentifier(std::string("StringIdentifierTest_literal")));
+
+	// String interned at runtime first
+	const Util::StringIdentifier fromString(std::string("StringIdentifierTest_runtimeFirst"));
+	REQUIRE(fromString == Util::StringIdentifier("StringIdentifierTest_runtimeFirst"_sid));
+	REQUIRE(""_sid.getValue() == 0);
+}
+
+TEST_CASE("StringIdentifierTest_testCollision", "[StringIdentifierTest]") {
+	using namespace Util::Literals;
+	const std::string str("StringIdentifierTest_collision");
+	const uint32_t hash = Util::StringIdentifier::calcHash(str.data(), str.size());
+	// Occupy the hash value by requesting the string of an unknown id
+	const std::string placeholder = Util::StringIdentifier(hash).toString();
+	REQUIRE(placeholder != str);
+
+	const Util::StringIdentifier collision(str);
+	REQUIRE(collision.getValue() != hash);
+	REQUIRE((collision.getValue() & Util::StringIdentifier::COLLISION_FLAG) != 0);
+	REQUIRE(collision == Util::StringIdentifier(str));
+	REQUIRE(str == collision.toString());
+	REQUIRE(placeholder == Util::StringIdentifier(hash).toString());
+	// Literals resolve collisions like other strings.
+	const Util::StringIdentifier fromLiteral = "StringIdentifierTest_collision"_sid;
+	REQUIRE(fromLiteral == collision);
+	REQUIRE(fromLiteral.toString() == str);
+}
+
+TEST_CASE("StringIdentifierTest_testStatistics", "[StringIdentifierTest]") {
+	const auto before = Util::StringIdentifier::getStatistics();
+	const auto keys = createKeys("StringIdentifierTest_statistics", 1000);
+	for(const auto & key : keys) {
+		Util::StringIdentifier id(key);
+	}
+	// Adds the placeholder and the colliding string
+	createCollision("StringIdentifierTest_statisticsCollision");
+	const auto after = Util::StringIdentifier::getStatistics();
+	REQUIRE(after.entryCount == before.entryCount + keys.size() + 2);
+	REQUIRE(after.collisionCount == before.collisionCount + 1);
+	REQUIRE(after.maxProbeLength >= 2);
+	REQUIRE(after.averageProbeLength >= 1.0);
+	REQUIRE(after.averageProbeLength < 1.1);
+}
+
+TEST_CASE("StringIdentifierTest_testInternAll", "[StringIdentifierTest]") {
+	const auto keys = createKeys("StringIdentifierTest_internAll", 5000);
+	const Util::StringIdentifier known(keys[17]);
+	std::vector<std::string> input(keys);
+	input.push_back(keys[3]); // duplicate inside the batch
+	const auto ids = Util::StringIdentifier::internAll(input);
+	REQUIRE(ids.size() == input.size());
+	REQUIRE(ids[17] == known);
+	REQUIRE(ids.back() == ids[3]);
+	for(std::size_t i = 0; i < keys.size(); ++i) {
+		REQUIRE(ids[i] == Util::StringIdentifier(keys[i]));
+	}
+	const char * const literals[] = {"StringIdentifierTest_internAll0", "StringIdentifierTest_internAllLiteral"};
+	const auto literalIds = Util::StringIdentifier::internAll(literals);
+	REQUIRE(literalIds[0] == ids[0]);
+	REQUIRE(literalIds[1].toString() == literals[1]);
+}
+
+//! Create a snapshot in the format of StringIdentifier::saveTable() containing the given entries.
+static std::string createSnapshot(const std::vector<std::pair<uint32_t, std::string>> & entries) {
+	std::string records;
+	for(const auto & entry : entries) {
+		const uint32_t recordHeader[2] = {entry.first, static_cast<uint32_t>(entry.second.size())};
+		records.append(reinterpret_cast<const char *>(recordHeader), sizeof(recordHeader));
+		records.append(entry.second.c_str(), entry.second.size() + 1);
+	}
+	const uint32_t header[4] = {0, 1, static_cast<uint32_t>(entries.size()), 0};
+	const uint64_t recordBytes = records.size();
+	std::string snapshot(reinterpret_cast<const char *>(header), sizeof(header));
+	snapshot.replace(0, 4, "SIDT");
+	snapshot.append(reinterpret_cast<const char *>(&recordBytes), sizeof(recordBytes));
+	return snapshot + records;
+}
+
+//! Stream buffer that does not support seeking, like a pipe.
+struct NonSeekableBuffer : public std::streambuf {
+	explicit NonSeekableBuffer(std::string & data) {
+		setg(&data[0], &data[0], &data[0] + data.size());
+	}
+};
+
+TEST_CASE("StringIdentifierTest_testSnapshot", "[StringIdentifierTest]") {
+	const auto keys = createKeys("StringIdentifierTest_snapshotSaved", 100);
+	for(const auto & key : keys) {
+		Util::StringIdentifier id(key);
+	}
+	const Util::StringIdentifier collision = createCollision("StringIdentifierTest_snapshotCollision");
+	std::stringstream stream;
+	const std::size_t savedCount = Util::StringIdentifier::saveTable(stream);
+	// The colliding string is saved, but the placeholder is not.
+	REQUIRE(savedCount >= keys.size() + 1);
+	REQUIRE(savedCount < Util::StringIdentifier::getStatistics().entryCount);
+	// Everything is known already.
+	REQUIRE(Util::StringIdentifier::loadTable(stream) == 0);
+	REQUIRE(collision == Util::StringIdentifier("StringIdentifierTest_snapshotCollision"));
+
+	// Entries of a previous run
+	const std::string loadedKey("StringIdentifierTest_snapshotLoaded");
+	const uint32_t loadedHash = Util::StringIdentifier::calcHash(loadedKey.data(), loadedKey.size());
+	const std::string chainedKey("StringIdentifierTest_snapshotChained");
+	const uint32_t chainedHash = Util::StringIdentifier::calcHash(chainedKey.data(), chainedKey.size());
+	// Occupy the hash value, as if chainedKey collided with another string in the previous run.
+	Util::StringIdentifier(chainedHash).toString();
+	const uint32_t chainedId = Util::StringIdentifier::COLLISION_FLAG | (1000000u << 6) | (chainedHash & 63);
+	std::vector<std::pair<uint32_t, std::string>> entries{{loadedHash, loadedKey}, {chainedId, chainedKey}};
+	for(uint32_t i = 0; i < 1000; ++i) {
+		const std::string key = "StringIdentifierTest_snapshotFresh" + std::to_string(i);
+		entries.emplace_back(Util::StringIdentifier::calcHash(key.data(), key.size()), key);
+	}
+	std::istringstream snapshot(createSnapshot(entries));
+	REQUIRE(Util::StringIdentifier::loadTable(snapshot) == entries.size());
+	REQUIRE(Util::StringIdentifier(loadedKey).getValue() == loadedHash);
+	REQUIRE(Util::StringIdentifier(chainedKey).getValue() == chainedId);
+	REQUIRE(Util::StringIdentifier(chainedId).toString() == chainedKey);
+	REQUIRE(Util::StringIdentifier("StringIdentifierTest_snapshotFresh999").toString() == "StringIdentifierTest_snapshotFresh999");
+
+	// Invalid snapshots
+	std::istringstream empty("");
+	REQUIRE(Util::StringIdentifier::loadTable(empty) == 0);
+	std::string wrongHash = createSnapshot({{12345, "StringIdentifierTest_snapshotWrongHash"}});
+	std::istringstream wrongHashStream(wrongHash);
+	REQUIRE(Util::StringIdentifier::loadTable(wrongHashStream) == 0);
+	std::istringstream truncated(wrongHash.substr(0, wrongHash.size() - 5));
+	REQUIRE(Util::StringIdentifier::loadTable(truncated) == 0);
+	// The header claims more data than there is.
+	std::string oversized = createSnapshot({});
+	const uint64_t oversizedBytes = static_cast<uint64_t>(1) << 40;
+	oversized.replace(16, sizeof(oversizedBytes), reinterpret_cast<const char *>(&oversizedBytes), sizeof(oversizedBytes));
+	std::istringstream oversizedStream(oversized);
+	REQUIRE(Util::StringIdentifier::loadTable(oversizedStream) == 0);
+	NonSeekableBuffer oversizedBuffer(oversized);
+	std::istream oversizedPipe(&oversizedBuffer);
+	REQUIRE(Util::StringIdentifier::loadTable(oversizedPipe) == 0);
+	std::string wrongHashCopy(wrongHash);
+	NonSeekableBuffer wrongHashBuffer(wrongHashCopy);
+	std::istream wrongHashPipe(&wrongHashBuffer);
+	REQUIRE(Util::StringIdentifier::loadTable(wrongHashPipe) == 0);
+}
+
+TEST_CASE("StringIdentifierBenchmark", "[.][StringIdentifierBenchmark]") {
+	const auto keys = createKeys("StringIdentifierBenchmark_attribute", 1000);
+	for(const auto & key : keys) {
+		Util::StringIdentifier id(key);
+	}
+	const std::size_t lookupsPerThread = 2000000;
+	const std::size_t maxThreads = std::max(4u, std::thread::hardware_concurrency());
+	for(std::size_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+		std::vector<uint32_t> checksums(threadCount);
+		std::vector<std::thread> threads;
+		Util::Timer timer;
+		for(std::size_t t = 0; t < threadCount; ++t) {
+			threads.emplace_back([&keys, &checksums, lookupsPerThread, t]() {
+				uint32_t checksum = 0;
+				for(std::size_t i = 0; i < lookupsPerThread; ++i) {
+					checksum += Util::StringIdentifier(keys[(i + t) % keys.size()]).getValue();
+				}
+				checksums[t] = checksum;
+			});
+		}
+		for(auto & thread : threads) {
+			thread.join();
+		}
+		timer.stop();
+		std::cout << "StringIdentifier lookup: " << threadCount << " thread(s), "
+				  << (timer.getNanoseconds() / static_cast<double>(lookupsPerThread)) << " ns per lookup and thread" << std::endl;
+		REQUIRE(std::count(checksums.begin(), checksums.end(), checksums[0]) == static_cast<std::ptrdiff_t>(threadCount));
+	}
+	{
+		using namespace Util::Literals;
+		uint32_t checksum = 0;
+		Util::Timer timer;
+		for(std::size_t i = 0; i < lookupsPerThread; ++i) {
+			checksum += static_cast<Util::StringIdentifier>("StringIdentifierBenchmark_attribute42"_sid).getValue();
+		}
+		timer.stop();
+		std::cout << "StringIdentifier literal: " << (timer.getNanoseconds() / static_cast<double>(lookupsPerThread)) << " ns per conversion" << std::endl;
+		REQUIRE(checksum == static_cast<uint32_t>(lookupsPerThread * Util::StringIdentifier(keys[42]).getValue()));
+	}
+	{
+		// Intern a few million keys that look like attribute paths
+		static const char * const parts[] = {"scene", "node", "material", "diffuse", "transform", "mesh", "light", "camera"};
+		std::vector<std::string> pathKeys;
+		const std::size_t keyCount = 3000000;
+		pathKeys.reserve(keyCount);
+		for(std::size_t i = 0; i < keyCount; ++i) {
+			pathKeys.emplace_back(std::string(parts[i % 8]) + '/' + std::to_string(i / 64) + '.' + parts[(i / 8) % 8] + '_' + std::to_string(i % 64));
+		}
+		Util::Timer timer;
+		for(const auto & key : pathKeys) {
+			Util::StringIdentifier id(key);
+		}
+		timer.stop();
+		const auto statistics = Util::StringIdentifier::getStatistics();
+		std::cout << "StringIdentifier interning: " << keyCount << " keys in " << timer.getMilliseconds() << " ms; "
+				  << statistics.entryCount << " entries, " << statistics.collisionCount << " collisions, probe length max "
+				  << statistics.maxProbeLength << " avg " << statistics.averageProbeLength << std::endl;
+
+		// Compare interning new keys one by one and as a batch.
+		std::vector<std::string> batchKeys(pathKeys);
+		for(std::size_t i = 0; i < keyCount; ++i) {
+			pathKeys[i] += "_single";
+			batchKeys[i] += "_batch";
+		}
+		timer.reset();
+		for(const auto & key : pathKeys) {
+			Util::StringIdentifier id(key);
+		}
+		timer.stop();
+		std::cout << "StringIdentifier single: " << keyCount << " new keys in " << timer.getMilliseconds() << " ms" << std::endl;
+		timer.reset();
+		const auto ids = Util::StringIdentifier::internAll(batchKeys);
+		timer.stop();
+		std::cout << "StringIdentifier internAll: " << ids.size() << " new keys in " << timer.getMilliseconds() << " ms" << std::endl;
+
+		std::stringstream snapshot;
+		timer.reset();
+		const std::size_t savedCount = Util::StringIdentifier::saveTable(snapshot);
+		timer.stop();
+		std::cout << "StringIdentifier saveTable: " << savedCount << " entries, " << snapshot.str().size() << " bytes in "
+				  << timer.getMilliseconds() << " ms" << std::endl;
+	}
+}
@@ -9,7 +9,14 @@
 */
 #include "StringUtils.h"
 #include <catch2/catch.hpp>
+#include "Timer.h"
+#include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
 #include <string>
 
 #define NUMBER_TEST(_TYPE, _VALUE) \
@@ -83,3 +90,193 @@ TEST_CASE("StringUtilsTest", "[StringUtilsTest]") {
 	NUMBER_TEST(int8_t, 100)
 	NUMBER_TEST(int8_t, 127)
 }
+
+TEST_CASE("StringUtilsTest_testEscape", "[StringUtilsTest]") {
+	REQUIRE(Util::StringUtils::escape("") == "");
+	REQUIRE(Util::StringUtils::escape("plain text") == "plain text");
+	REQUIRE(Util::StringUtils::escape("a \"quoted\" word") == "a \\\"quoted\\\" word");
+	REQUIRE(Util::StringUtils::escape("line\nbreak") == "line\\nbreak");
+	REQUIRE(Util::StringUtils::escape("back\\slash\\") == "back\\\\slash\\\\");
+	REQUIRE(Util::StringUtils::escape("\"\n\\") == "\\\"\\n\\\\");
+
+	std::string buffer = "prefix ";
+	const std::string text = "\"x\"\tz";
+	Util::StringUtils::appendEscaped(buffer, text.data(), text.size());
+	REQUIRE(buffer == "prefix \\\"x\\\"\tz");
+}
+
+TEST_CASE("StringUtilsTest_testNumberFormatting", "[StringUtilsTest]") {
+	using Util::StringUtils::toString;
+	REQUIRE(toString(0.0) == "0");
+	REQUIRE(toString(-0.0) == "-0");
+	REQUIRE(toString(0.1) == "0.1");
+	REQUIRE(toString(0.1 + 0.2) == "0.30000000000000004");
+	REQUIRE(toString(1.5) == "1.5");
+	REQUIRE(toString(100.0) == "100");
+	REQUIRE(toString(1234567.0) == "1234567");
+	REQUIRE(toString(1e6) == "1e+06");
+	REQUIRE(toString(1e20) == "1e+20");
+	REQUIRE(toString(0.0001) == "0.0001");
+	REQUIRE(toString(1e-5) == "1e-05");
+	REQUIRE(toString(-2.5e-300) == "-2.5e-300");
+	REQUIRE(toString(1.7976931348623157e308) == "1.7976931348623157e+308");
+	REQUIRE(toString(std::numeric_limits<double>::quiet_NaN()) == "nan");
+	REQUIRE(toString(std::numeric_limits<double>::infinity()) == "inf");
+	REQUIRE(toString(-std::numeric_limits<double>::infinity()) == "-inf");
+	REQUIRE(toString(12.345f) == "12.345");
+	REQUIRE(toString(0.1f) == "0.1");
+	REQUIRE(toString(16777216.0f) == "16777216");
+
+	REQUIRE(toString(std::numeric_limits<long long>::min()) == "-9223372036854775808");
+	REQUIRE(toString(std::numeric_limits<unsigned long long>::max()) == "18446744073709551615");
+	REQUIRE(toString(-42) == "-42");
+
+	char buffer[Util::StringUtils::MAX_NUMBER_LENGTH];
+	char * end = Util::StringUtils::formatNumber(buffer, -1.25);
+	REQUIRE(std::string(buffer, end) == "-1.25");
+}
+
+TEST_CASE("StringUtilsTest_testNumberParsing", "[StringUtilsTest]") {
+	using Util::StringUtils::toNumber;
+	using Util::StringUtils::parseNumber;
+	REQUIRE(toNumber<double>("  1.5e3") == 1500.0);
+	REQUIRE(toNumber<double>("-.25") == -0.25);
+	REQUIRE(toNumber<double>("1E-2") == 0.01);
+	REQUIRE(toNumber<double>("0.30000000000000004") == 0.1 + 0.2);
+	REQUIRE(toNumber<double>("2.2250738585072014e-308") == std::numeric_limits<double>::min());
+	REQUIRE(toNumber<double>("1e400") == std::numeric_limits<double>::infinity());
+	REQUIRE(toNumber<double>("1e-400") == 0.0);
+	REQUIRE(toNumber<double>("-Infinity") == -std::numeric_limits<double>::infinity());
+	REQUIRE(toNumber<float>("3.4028235e38") == std::numeric_limits<float>::max());
+	REQUIRE(toNumber<int>("99999999999") == std::numeric_limits<int>::max());
+	REQUIRE(toNumber<int>("-99999999999") == std::numeric_limits<int>::min());
+	REQUIRE(toNumber<long long>("-9223372036854775808") == std::numeric_limits<long long>::min());
+	REQUIRE(toNumber<unsigned long long>("18446744073709551615") == std::numeric_limits<unsigned long long>::max());
+
+	// Values that are not exact in the fast path: rounding to even, subnormal numbers and long mantissas
+	REQUIRE(toNumber<double>("9007199254740993") == 9007199254740992.0);
+	REQUIRE(toNumber<double>("9007199254740995") == 9007199254740996.0);
+	REQUIRE(toNumber<double>("1e23") == 1e23);
+	REQUIRE(toNumber<double>("1.7976931348623157e308") == std::numeric_limits<double>::max());
+	REQUIRE(toNumber<double>("1.7976931348623159e308") == std::numeric_limits<double>::infinity());
+	REQUIRE(toNumber<double>("4.9406564584124654e-324") == std::numeric_limits<double>::denorm_min());
+	REQUIRE(toNumber<double>("2.4703282292062327e-324") == 0.0);
+	REQUIRE(toNumber<double>("2.4703282292062328e-324") == std::numeric_limits<double>::denorm_min());
+	REQUIRE(toNumber<double>("2.2250738585072011e-308") == std::nextafter(std::numeric_limits<double>::min(), 0.0));
+	REQUIRE(toNumber<double>("123456789012345678901234567890") == 1.2345678901234568e29);
+	REQUIRE(toNumber<double>("9007199254740993.00000000000000000000000001") == 9007199254740994.0);
+	REQUIRE(toNumber<float>("1.00000005960464477539062499") == 1.0f);
+	REQUIRE(toNumber<float>("1.00000005960464477539062501") == std::nextafter(1.0f, 2.0f));
+	REQUIRE(toNumber<float>("1.4e-45") == std::numeric_limits<float>::denorm_min());
+
+	const std::string text = "12.5e1x";
+	double value = 1.0;
+	const char * cursor = parseNumber(text.data(), text.data() + text.size(), value);
+	REQUIRE(value == 125.0);
+	REQUIRE(*cursor == 'x');
+
+	// Nothing is read from an invalid input.
+	const std::string garbage = "  -x";
+	int integer = 1;
+	REQUIRE(parseNumber(garbage.data(), garbage.data() + garbage.size(), integer) == garbage.data());
+	REQUIRE(integer == 0);
+
+	// The exponent is ignored if it has no digits.
+	const std::string noExponent = "7e+";
+	cursor = parseNumber(noExponent.data(), noExponent.data() + noExponent.size(), value);
+	REQUIRE(value == 7.0);
+	REQUIRE(*cursor == 'e');
+
+	std::mt19937_64 engine(42);
+	for(int i = 0; i < 10000; ++i) {
+		const uint64_t bits = engine();
+		double doubleValue;
+		std::memcpy(&doubleValue, &bits, sizeof(double));
+		if(doubleValue == doubleValue) {
+			REQUIRE(toNumber<double>(Util::StringUtils::toString(doubleValue)) == doubleValue);
+		}
+		const uint32_t floatBits = static_cast<uint32_t>(bits >> 32);
+		float floatValue;
+		std::memcpy(&floatValue, &floatBits, sizeof(float));
+		if(floatValue == floatValue) {
+			REQUIRE(toNumber<float>(Util::StringUtils::toString(floatValue)) == floatValue);
+		}
+	}
+}
+
+TEST_CASE("StringUtilsTest_testUTF8Validation", "[StringUtilsTest]") {
+	using namespace Util::StringUtils;
+	REQUIRE(isValidUTF8(""));
+	REQUIRE(isValidUTF8("plain ASCII text that is longer than sixteen characters"));
+	REQUIRE(isValidUTF8("\x24 \xC2\xA2 \xE2\x82\xAC \xF0\x90\x8D\x88"));
+	REQUIRE(isValidUTF8(utf32_to_utf8(0x10FFFF)));
+	REQUIRE(!isValidUTF8("\x80"));						// Continuation byte without start
+	REQUIRE(!isValidUTF8("\xC0\xAF"));					// Overlong encoding
+	REQUIRE(!isValidUTF8("\xE0\x80\xAF"));				// Overlong encoding
+	REQUIRE(!isValidUTF8("\xED\xA0\x80"));				// Surrogate
+	REQUIRE(!isValidUTF8("\xF4\x90\x80\x80"));			// Above U+10FFFF
+	REQUIRE(!isValidUTF8("\xF8\x88\x80\x80\x80"));		// Five bytes
+	REQUIRE(!isValidUTF8("\xE2\x82"));					// Truncated
+	REQUIRE(!isValidUTF8("\xE2\x28\xA1"));				// Invalid continuation byte
+	// Invalid bytes after and within blocks of ASCII characters
+	for(std::size_t position = 0; position < 40; ++position) {
+		std::string text(40, 'a');
+		REQUIRE(isValidUTF8(text));
+		text[position] = '\xFF';
+		REQUIRE(!isValidUTF8(text));
+		text.replace(position, 1, "\xC3\xA4");
+		REQUIRE(isValidUTF8(text));
+	}
+}
+
+TEST_CASE("StringUtilsNumberBenchmark", "[.][StringUtilsNumberBenchmark]") {
+	const std::size_t count = 1000000;
+	std::mt19937_64 engine(1);
+	std::uniform_real_distribution<double> distribution(-1.0e6, 1.0e6);
+	std::vector<double> values;
+	values.reserve(count);
+	for(std::size_t i = 0; i < count; ++i) {
+		values.push_back(distribution(engine));
+	}
+
+	Util::Timer timer;
+	std::vector<std::string> streamStrings;
+	streamStrings.reserve(count);
+	for(const auto & value : values) {
+		std::ostringstream stream;
+		stream.precision(17);
+		stream << value;
+		streamStrings.push_back(stream.str());
+	}
+	timer.stop();
+	std::cout << "Format with std::ostringstream: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	std::vector<std::string> strings;
+	strings.reserve(count);
+	for(const auto & value : values) {
+		strings.push_back(Util::StringUtils::toString(value));
+	}
+	timer.stop();
+	std::cout << "Format with StringUtils::toString: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	double streamSum = 0.0;
+	for(const auto & string : streamStrings) {
+		std::istringstream stream(string);
+		double value;
+		stream >> value;
+		streamSum += value;
+	}
+	timer.stop();
+	std::cout << "Parse with std::istringstream: " << timer.getMilliseconds() << " ms" << std::endl;
+
+	timer.reset();
+	double sum = 0.0;
+	for(const auto & string : strings) {
+		sum += Util::StringUtils::toNumber<double>(string);
+	}
+	timer.stop();
+	std::cout << "Parse with StringUtils::toNumber: " << timer.getMilliseconds() << " ms" << std::endl;
+	REQUIRE(sum == streamSum);
+}
@@ -17,6 +17,8 @@
 #include <typeindex>
 #include <typeinfo>
 #include <sstream>
+#include <string>
+#include <unordered_map>
 
 struct Base {
 	virtual ~Base() {
@@ -180,3 +182,19 @@ TEST_CASE("WrapperFactoryTest_testUnknown", "[WrapperFactoryTest]") {
 		delete productA;
 	}
 }
+
+TEST_CASE("WrapperFactoryTest_testHashContainer", "[WrapperFactoryTest]") {
+	typedef std::function<std::size_t (const std::string &)> LengthCreator;
+	Util::WrapperFactory<std::string, std::size_t, std::string, LengthCreator, Util::FallbackPolicies::ExceptionFallback,
+						 std::unordered_map<std::string, LengthCreator>> factory;
+	REQUIRE(factory.registerType("single", [](const std::string & text) { return text.size(); }));
+	REQUIRE(factory.registerType("double", [](const std::string & text) { return 2 * text.size(); }));
+	REQUIRE(!factory.registerType("double", [](const std::string & text) { return 3 * text.size(); }));
+
+	REQUIRE(5 == factory.create("single", "hello"));
+	REQUIRE(10 == factory.create("double", "hello"));
+
+	REQUIRE(factory.unregisterType("double"));
+	typedef Util::FallbackPolicies::ExceptionFallback<std::size_t, std::string>::Exception FactoryException;
+	REQUIRE_THROWS_AS(factory.create("double", "hello"), FactoryException);
+}